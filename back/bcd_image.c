@@ -0,0 +1,315 @@
+// bcd_image.c
+#include "header/bcd_image.h"
+#include "header/bcd_manager.h"
+#include "header/vdisk.h"
+#include "header/fat32.h"
+#include "header/utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define VBCD_MAX_ENTRIES 32
+#define VBCD_MAX_ARGS    8
+
+typedef struct {
+    char id[BCD_ID_MAX];
+    char description[128];
+    char application[32];
+    char device[32];
+    char path[MAX_PATH];
+} vbcd_entry_t;
+
+typedef struct {
+    int          timeout;
+    char         default_id[BCD_ID_MAX];
+    char         order[VBCD_MAX_ENTRIES][BCD_ID_MAX];
+    int          order_count;
+    vbcd_entry_t entries[VBCD_MAX_ENTRIES];
+    int          count;
+} vbcd_store_t;
+
+static char store_path[MAX_PATH];
+static char backup_path[MAX_PATH];
+
+static const char* get_store_path(void) {
+    snprintf(store_path, sizeof(store_path), "%s.bcd", vdisk_path());
+    return store_path;
+}
+
+const char* vbcd_backup_path(void) {
+    snprintf(backup_path, sizeof(backup_path), "%s.bcd.bak", vdisk_path());
+    return backup_path;
+}
+
+// ── Magasin ───────────────────────────────────────────────────────────────
+
+// Magasin neuf : l'entrée Windows seule, comme sur une installation standard
+static void store_init(vbcd_store_t* s) {
+    memset(s, 0, sizeof(*s));
+    s->timeout = 30;
+    strcpy(s->default_id, "{current}");
+    strcpy(s->order[0], "{current}");
+    s->order_count = 1;
+
+    vbcd_entry_t* e = &s->entries[0];
+    strcpy(e->id, "{current}");
+    strcpy(e->description, "Windows 11");
+    strcpy(e->application, "OSLOADER");
+    strcpy(e->device, "partition=C:");
+    strcpy(e->path, "\\Windows\\system32\\winload.efi");
+    s->count = 1;
+}
+
+static vbcd_entry_t* store_find(vbcd_store_t* s, const char* id) {
+    for (int i = 0; i < s->count; i++) {
+        if (_stricmp(s->entries[i].id, id) == 0) return &s->entries[i];
+    }
+    return NULL;
+}
+
+
+static int store_load_from(const char* path, vbcd_store_t* s) {
+    FILE* f = fopen(path, "r");
+    if (!f) return -1;
+
+    memset(s, 0, sizeof(*s));
+    vbcd_entry_t* cur = NULL;
+    int           ok  = 1;   // valeur trop longue : magasin refusé
+    char line[512];
+    while (fgets(line, sizeof(line), f)) {
+        line[strcspn(line, "\r\n")] = '\0';
+        char* value = strchr(line, ' ');
+        if (value) *value++ = '\0';
+        else value = line + strlen(line);
+
+        if (line[0] == '[') {
+            cur = NULL;
+            char* end = strchr(line, ']');
+            if (end && s->count < VBCD_MAX_ENTRIES) {
+                *end = '\0';
+                cur = &s->entries[s->count++];
+                if (copy_string(cur->id, sizeof(cur->id), line + 1) != 0) ok = 0;
+            }
+        } else if (cur) {
+            char*  field = NULL;
+            size_t size  = 0;
+            if      (strcmp(line, "description") == 0) field = cur->description, size = sizeof(cur->description);
+            else if (strcmp(line, "application") == 0) field = cur->application, size = sizeof(cur->application);
+            else if (strcmp(line, "device") == 0)      field = cur->device,      size = sizeof(cur->device);
+            else if (strcmp(line, "path") == 0)        field = cur->path,        size = sizeof(cur->path);
+            if (field && copy_string(field, size, value) != 0) ok = 0;
+        } else if (strcmp(line, "timeout") == 0) {
+            s->timeout = atoi(value);
+        } else if (strcmp(line, "default") == 0) {
+            if (copy_string(s->default_id, sizeof(s->default_id), value) != 0) ok = 0;
+        } else if (strcmp(line, "displayorder") == 0) {
+            for (char* tok = strtok(value, " "); tok && s->order_count < VBCD_MAX_ENTRIES;
+                 tok = strtok(NULL, " ")) {
+                if (copy_string(s->order[s->order_count++], BCD_ID_MAX, tok) != 0) ok = 0;
+            }
+        }
+    }
+    fclose(f);
+    if (!ok) fprintf(stderr, "[Erreur] Magasin BCD invalide (valeur trop longue) : %s\n", path);
+    return ok ? 0 : -1;
+}
+
+static void store_load(vbcd_store_t* s) {
+    if (store_load_from(get_store_path(), s) != 0) store_init(s);
+}
+
+static int store_save_to(const char* path, const vbcd_store_t* s) {
+    FILE* f = fopen(path, "w");
+    if (!f) {
+        fprintf(stderr, "[Erreur] Ecriture du magasin BCD impossible : %s\n", path);
+        return -1;
+    }
+
+    fprintf(f, "timeout %d\ndefault %s\ndisplayorder", s->timeout, s->default_id);
+    for (int i = 0; i < s->order_count; i++) fprintf(f, " %s", s->order[i]);
+    fprintf(f, "\n");
+    for (int i = 0; i < s->count; i++) {
+        const vbcd_entry_t* e = &s->entries[i];
+        fprintf(f, "[%s]\ndescription %s\napplication %s\n", e->id, e->description, e->application);
+        if (e->device[0]) fprintf(f, "device %s\n", e->device);
+        if (e->path[0])   fprintf(f, "path %s\n", e->path);
+    }
+
+    int rc = ferror(f) ? -1 : 0;
+    if (fclose(f) != 0) rc = -1;
+    return rc;
+}
+
+static void order_remove(vbcd_store_t* s, const char* id) {
+    int n = 0;
+    for (int i = 0; i < s->order_count; i++) {
+        if (_stricmp(s->order[i], id) != 0) memmove(s->order[n++], s->order[i], BCD_ID_MAX);
+    }
+    s->order_count = n;
+}
+
+// ── Commandes ─────────────────────────────────────────────────────────────
+
+// Découpe la ligne de commande (les guillemets regroupent)
+static int split_args(const char* args, char* buf, size_t buf_size, char** argv) {
+    int    argc = 0;
+    size_t n    = 0;
+    const char* p = args;
+    while (*p && argc < VBCD_MAX_ARGS) {
+        while (*p == ' ') p++;
+        if (!*p) break;
+        argv[argc++] = buf + n;
+        int quoted = 0;
+        while (*p && (quoted || *p != ' ') && n + 1 < buf_size) {
+            if (*p == '"') quoted = !quoted;
+            else buf[n++] = *p;
+            p++;
+        }
+        buf[n++] = '\0';
+        if (n >= buf_size) break;
+    }
+    return argc;
+}
+
+static void new_id(char* out) {
+    static int seeded = 0;
+    if (!seeded) {
+        srand((unsigned int)time(NULL) ^ (unsigned int)(size_t)&seeded);
+        seeded = 1;
+    }
+    unsigned int r[8];
+    for (int i = 0; i < 8; i++) r[i] = (unsigned int)rand() & 0xFFFF;
+    snprintf(out, BCD_ID_MAX, "{%04x%04x-%04x-%04x-%04x-%04x%04x%04x}",
+             r[0], r[1], r[2], (r[3] & 0x0FFF) | 0x4000, (r[4] & 0x3FFF) | 0x8000,
+             r[5], r[6], r[7]);
+}
+
+// Le binaire doit exister sur la partition "partition=X:" de l'image
+static int check_efi_binary(const char* device, const char* path) {
+    if (strncmp(device, "partition=", 10) != 0 || !device[10]) return -1;
+
+    unsigned long long offset, size;
+    if (vdisk_find_partition(device[10], &offset, &size) != 0) return -1;
+
+    fat32_t fs;
+    if (fat32_open(&fs, vdisk_device(), offset) != 0) return -1;
+    int is_dir = 0;
+    int rc = (fat32_find(&fs, path, &is_dir, NULL) == 0 && !is_dir) ? 0 : -1;
+    fat32_close(&fs);
+    return rc;
+}
+
+int vbcd_run(const char* args, char* output, DWORD output_size) {
+    char  buf[1024];
+    char* argv[VBCD_MAX_ARGS];
+    int   argc = split_args(args, buf, sizeof(buf), argv);
+    char  out[2048] = "";
+    int   rc = -1;
+
+    if (output && output_size) output[0] = '\0';
+    if (argc == 0) return -1;
+
+    vbcd_store_t* s = malloc(sizeof(vbcd_store_t));
+    if (!s) return -1;
+    store_load(s);
+
+    const char* cmd = argv[0];
+    if (_stricmp(cmd, "/create") == 0 && argc >= 5 && _stricmp(argv[1], "/d") == 0 &&
+        _stricmp(argv[3], "/application") == 0) {
+        if (s->count < VBCD_MAX_ENTRIES) {
+            vbcd_entry_t* e = &s->entries[s->count++];
+            memset(e, 0, sizeof(*e));
+            new_id(e->id);
+            if (copy_string(e->description, sizeof(e->description), argv[2]) != 0 ||
+                copy_string(e->application, sizeof(e->application), argv[4]) != 0) {
+                s->count--;
+                snprintf(out, sizeof(out), "The element data is too long.\n");
+            } else {
+                snprintf(out, sizeof(out), "The entry %s was successfully created.\n", e->id);
+                rc = store_save_to(get_store_path(), s);
+            }
+        } else {
+            snprintf(out, sizeof(out), "The BCD store is full.\n");
+        }
+    } else if (_stricmp(cmd, "/set") == 0 && argc >= 4) {
+        vbcd_entry_t* e = store_find(s, argv[1]);
+        if (!e) {
+            snprintf(out, sizeof(out), "The specified entry %s does not exist.\n", argv[1]);
+        } else if (_stricmp(argv[2], "device") == 0) {
+            unsigned long long offset, size;
+            if (strncmp(argv[3], "partition=", 10) == 0 &&
+                vdisk_find_partition(argv[3][10], &offset, &size) == 0 &&
+                copy_string(e->device, sizeof(e->device), argv[3]) == 0) {
+                rc = store_save_to(get_store_path(), s);
+            } else {
+                snprintf(out, sizeof(out), "The element data %s is not valid.\n", argv[3]);
+            }
+        } else if (_stricmp(argv[2], "path") == 0) {
+            if (e->device[0] && check_efi_binary(e->device, argv[3]) != 0) {
+                snprintf(out, sizeof(out), "%s not found on %s.\n", argv[3], e->device);
+            } else if (copy_string(e->path, sizeof(e->path), argv[3]) != 0) {
+                snprintf(out, sizeof(out), "The element data %s is not valid.\n", argv[3]);
+            } else {
+                rc = store_save_to(get_store_path(), s);
+            }
+        } else {
+            snprintf(out, sizeof(out), "Unsupported element %s.\n", argv[2]);
+        }
+    } else if (_stricmp(cmd, "/displayorder") == 0 && argc >= 3 &&
+               _stricmp(argv[2], "/addfirst") == 0) {
+        if (store_find(s, argv[1])) {
+            order_remove(s, argv[1]);
+            if (s->order_count == VBCD_MAX_ENTRIES) s->order_count--;
+            memmove(s->order[1], s->order[0], (size_t)s->order_count * BCD_ID_MAX);
+            copy_string(s->order[0], BCD_ID_MAX, argv[1]);   // id du magasin : tient
+            s->order_count++;
+            rc = store_save_to(get_store_path(), s);
+        } else {
+            snprintf(out, sizeof(out), "The specified entry %s does not exist.\n", argv[1]);
+        }
+    } else if (_stricmp(cmd, "/default") == 0 && argc >= 2) {
+        if (store_find(s, argv[1])) {
+            copy_string(s->default_id, sizeof(s->default_id), argv[1]);
+            rc = store_save_to(get_store_path(), s);
+        } else {
+            snprintf(out, sizeof(out), "The specified entry %s does not exist.\n", argv[1]);
+        }
+    } else if (_stricmp(cmd, "/timeout") == 0 && argc >= 2) {
+        s->timeout = atoi(argv[1]);
+        rc = store_save_to(get_store_path(), s);
+    } else if (_stricmp(cmd, "/delete") == 0 && argc >= 2) {
+        vbcd_entry_t* e = store_find(s, argv[1]);
+        if (e) {
+            *e = s->entries[--s->count];
+            order_remove(s, argv[1]);
+            if (_stricmp(s->default_id, argv[1]) == 0) {
+                copy_string(s->default_id, sizeof(s->default_id),
+                            s->order_count ? s->order[0] : "{current}");
+            }
+            rc = store_save_to(get_store_path(), s);
+        } else {
+            snprintf(out, sizeof(out), "The specified entry %s does not exist.\n", argv[1]);
+        }
+    } else if (_stricmp(cmd, "/export") == 0 && argc >= 2) {
+        rc = store_save_to(argv[1], s);
+    } else if (_stricmp(cmd, "/import") == 0 && argc >= 2) {
+        rc = store_load_from(argv[1], s) == 0 ? store_save_to(get_store_path(), s) : -1;
+    } else if (_stricmp(cmd, "/enum") == 0) {
+        size_t n = (size_t)snprintf(out, sizeof(out), "timeout %d\ndefault %s\n",
+                                    s->timeout, s->default_id);
+        for (int i = 0; i < s->count && n < sizeof(out); i++) {
+            n += (size_t)snprintf(out + n, sizeof(out) - n, "%s  %s  %s%s\n",
+                                  s->entries[i].id, s->entries[i].description,
+                                  s->entries[i].device, s->entries[i].path);
+        }
+        rc = 0;
+    } else {
+        snprintf(out, sizeof(out), "The parameter is incorrect: %s\n", args);
+    }
+
+    free(s);
+    // Sortie tronquée comme celle d'un processus (run_process_with_input)
+    if (output && output_size) copy_string(output, output_size, out);
+    return rc;
+}
@@ -1,11 +1,16 @@
 // bcd_manager.c
 #include "header/bcd_manager.h"
+#include "header/bcd_image.h"
 #include "header/utils.h"
-#include <windows.h>
+#include "header/vdisk.h"
+#include "header/compat.h"
 #include <stdio.h>
 #include <string.h>
 
+// Sur disque virtuel, le magasin de l'image remplace bcdedit
 static int run_bcdedit(const char* args, char* output, DWORD output_size) {
+    if (vdisk_is_open()) return vbcd_run(args, output, output_size);
+
     char command[1024];
     snprintf(command, sizeof(command), "bcdedit %s", args);
     return run_process_with_input(command, NULL, output, output_size);
@@ -16,6 +21,7 @@ static int run_bcdedit(const char* args, char* output, DWORD output_size) {
 int bcd_backup(const char* backup_path) {
     char args[512];
     char output[1024];
+    if (vdisk_is_open()) backup_path = vbcd_backup_path();
     snprintf(args, sizeof(args), "/export \"%s\"", backup_path);
 
     if (run_bcdedit(args, output, sizeof(output)) != 0) {
@@ -29,6 +35,7 @@ int bcd_backup(const char* backup_path) {
 int bcd_restore(const char* backup_path) {
     char args[512];
     char output[1024];
+    if (vdisk_is_open()) backup_path = vbcd_backup_path();
 
     if (GetFileAttributesA(backup_path) == INVALID_FILE_ATTRIBUTES) {
         fprintf(stderr, "[Erreur] Backup BCD introuvable : %s\n", backup_path);
@@ -0,0 +1,162 @@
+// bench.c
+#include "header/bench.h"
+#include "header/io_policy.h"
+#include "header/digest.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_BUFFER (1024 * 1024)
+#define MB           (1024.0 * 1024.0)
+
+static double seconds_since(LARGE_INTEGER start) {
+    LARGE_INTEGER now, freq;
+    QueryPerformanceCounter(&now);
+    QueryPerformanceFrequency(&freq);
+    return (double)(now.QuadPart - start.QuadPart) / (double)freq.QuadPart;
+}
+
+// Taille du fichier, -1 si illisible. Chaque passe part d'un cache froid,
+// sinon la première réchauffe les suivantes. Sous Windows rien n'évince
+// les pages d'un fichier : chaque passe lit donc sa propre tranche (voir
+// bench_run), qu'aucune passe précédente n'a mise en cache.
+static long long cold_size(const char* path) {
+    HANDLE h = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                           FILE_ATTRIBUTE_NORMAL, NULL);
+    if (h == INVALID_HANDLE_VALUE) return -1;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(h, &size)) size.QuadPart = -1;
+#ifndef _WIN32
+    compat_drop_cache(h, 0, 0);
+#endif
+    CloseHandle(h);
+    return size.QuadPart;
+}
+
+static void print_cache(const char* path) {
+    long long cached = io_cached_bytes(path);
+    if (cached < 0) printf("cache ?\n");
+    else            printf("cache %.0f Mo\n", (double)cached / MB);
+}
+
+// Copie [offset, offset + length) de path vers tmp avec vidages
+// périodiques ; flush_s reçoit la durée du vidage final, seul à bloquer en
+// mode buffered.
+static int bench_copy(const char* path, unsigned long long offset, unsigned long long length,
+                      const char* tmp, unsigned long long* bytes, double* flush_s) {
+    io_reader_t in;
+    if (io_open(&in, path) != 0) return -1;
+
+    HANDLE out = CreateFileA(tmp, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS,
+                             FILE_ATTRIBUTE_NORMAL, NULL);
+    BYTE*  buffer = io_alloc(BENCH_BUFFER);
+    int    rc     = out != INVALID_HANDLE_VALUE && buffer ? 0 : -1;
+
+    unsigned long long pos = 0, pending = 0;
+    while (rc == 0 && pos < length) {
+        DWORD n, written;
+        DWORD want = (DWORD)(length - pos < BENCH_BUFFER ? length - pos : BENCH_BUFFER);
+        if (io_read_at(&in, offset + pos, buffer, want, &n) != 0) {
+            rc = -1;
+            break;
+        }
+        if (n == 0) break;
+        if (!WriteFile(out, buffer, n, &written, NULL) || written != n) {
+            rc = -1;
+            break;
+        }
+        pos += n;
+        if (io_flush_due(&pending, n)) {
+            FlushFileBuffers(out);
+            io_drop_cache(out, 0, 0);
+        }
+    }
+
+    LARGE_INTEGER start;
+    QueryPerformanceCounter(&start);
+    if (out != INVALID_HANDLE_VALUE) {
+        if (rc == 0 && !FlushFileBuffers(out)) rc = -1;
+        io_drop_cache(out, 0, 0);
+        CloseHandle(out);
+    }
+    *flush_s = seconds_since(start);
+    *bytes   = pos;
+
+    io_free(buffer);
+    io_close(&in);
+    DeleteFileA(tmp);
+    return rc;
+}
+
+// Une passe par tranche : [hash, hash + slice) puis [copy, copy + slice)
+static int bench_policy(const char* path, io_policy_t policy, unsigned long long hash,
+                        unsigned long long copy, unsigned long long slice) {
+    io_policy_set(policy);
+    const char* name = io_policy_name(policy);
+
+    // ── Hachage ───────────────────────────────────────────────────────────
+    digest_result_t digest;
+    LARGE_INTEGER   start;
+    if (cold_size(path) < 0) {
+        fprintf(stderr, "[Erreur] Impossible d'ouvrir %s\n", path);
+        return -1;
+    }
+    QueryPerformanceCounter(&start);
+    if (digest_file_range(path, hash, slice, DIGEST_SHA256 | DIGEST_BLAKE3, &digest,
+                          NULL) != 0) {
+        fprintf(stderr, "[Erreur] Hachage de %s echoue (%s).\n", path, name);
+        return -1;
+    }
+    double hash_s = seconds_since(start);
+    printf("[Bench] %-8s : hachage %7.1f Mo/s, ", name,
+           hash_s > 0 ? (double)slice / MB / hash_s : 0.0);
+    print_cache(path);
+
+    // ── Copie ─────────────────────────────────────────────────────────────
+    char tmp[MAX_PATH];
+    snprintf(tmp, sizeof(tmp), "%s.bench.tmp", path);
+    unsigned long long copied;
+    double flush_s;
+    cold_size(path);
+    QueryPerformanceCounter(&start);
+    if (bench_copy(path, copy, slice, tmp, &copied, &flush_s) != 0) {
+        fprintf(stderr, "[Erreur] Copie vers %s echouee (%s).\n", tmp, name);
+        return -1;
+    }
+    double copy_s = seconds_since(start);
+    printf("[Bench] %-8s : copie   %7.1f Mo/s (vidage final %.2f s), ", name,
+           copy_s > 0 ? (double)copied / MB / copy_s : 0.0, flush_s);
+    print_cache(path);
+    return 0;
+}
+
+int bench_run(const char* path, int policy) {
+    io_policy_t saved = io_policy_get();
+    int         rc    = 0;
+
+    long long size = cold_size(path);
+    if (size < 0) {
+        fprintf(stderr, "[Erreur] Impossible d'ouvrir %s\n", path);
+        return -1;
+    }
+
+    // Deux tranches par politique (hachage, copie), alignées sur IO_ALIGN
+    int                passes = policy >= 0 ? 2 : 2 * IO_POLICY_COUNT;
+    unsigned long long slice  = (unsigned long long)size / passes / IO_ALIGN * IO_ALIGN;
+    if (slice == 0) {
+        fprintf(stderr, "[Erreur] %s est trop petit pour le banc d'essai.\n", path);
+        return -1;
+    }
+
+    printf("[Pleco] Banc d'essai des E/S sur %s (tranches de %.0f Mo)\n", path,
+           (double)slice / MB);
+    unsigned long long next = 0;
+    for (int p = 0; p < IO_POLICY_COUNT && rc == 0; p++) {
+        if (policy >= 0 && p != policy) continue;
+        rc = bench_policy(path, (io_policy_t)p, next, next + slice, slice);
+        next += 2 * slice;
+    }
+    io_policy_set(saved);
+    return rc;
+}
@@ -0,0 +1,9 @@
+@echo off
+rem Compilation de pleco.exe avec MinGW-w64 (gcc et windres dans le PATH).
+rem Le manifeste (pleco.rc) demande l'elevation ; BCrypt sert au SHA-2 et
+rem aux GUID de partition.
+
+cd /d "%~dp0"
+windres pleco.rc -O coff -o pleco_res.o || exit /b 1
+gcc -O2 -Wall -Wextra -o pleco.exe *.c pleco_res.o -lbcrypt -ladvapi32 || exit /b 1
+echo pleco.exe compile.
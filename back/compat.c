@@ -0,0 +1,598 @@
+// compat.c
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE     // O_DIRECT
+#endif
+#include "header/compat.h"
+
+#ifndef _WIN32
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#ifdef __linux__
+#include <sys/sysmacros.h>   // major, minor
+#endif
+#include <time.h>
+
+// Un HANDLE pointe sur l'un de ces objets
+enum { HANDLE_FILE = 1, HANDLE_FIND, HANDLE_THREAD };
+
+typedef struct {
+    int       kind;
+    int       fd;
+    int       stream;     // tube, terminal : lectures partielles rendues telles quelles
+    int       direct;     // sans cache : une lecture courte marque la fin du fichier
+    DIR*      dir;
+    char      dir_path[MAX_PATH];
+    pthread_t thread;
+    int       joined;
+} compat_handle_t;
+
+static __thread DWORD last_error = 0;
+
+static void set_error_from_errno(void) {
+    switch (errno) {
+        case ENOENT:  last_error = ERROR_FILE_NOT_FOUND;    break;
+        case ENOTDIR: last_error = ERROR_PATH_NOT_FOUND;    break;
+        case EACCES:
+        case EPERM:   last_error = ERROR_ACCESS_DENIED;     break;
+        case EEXIST:  last_error = ERROR_ALREADY_EXISTS;    break;
+        case ENOSPC:  last_error = ERROR_DISK_FULL;         break;
+        case ENOMEM:  last_error = ERROR_NOT_ENOUGH_MEMORY; break;
+        default:      last_error = (DWORD)errno;            break;
+    }
+}
+
+DWORD GetLastError(void) {
+    return last_error;
+}
+
+// "C:\dossier\fichier" reste tel quel hormis les séparateurs
+static void native_path(LPCSTR path, char* out, size_t out_size) {
+    snprintf(out, out_size, "%s", path);
+    for (char* p = out; *p; p++) {
+        if (*p == '\\') *p = '/';
+    }
+}
+
+static compat_handle_t* new_handle(int kind) {
+    compat_handle_t* h = calloc(1, sizeof(compat_handle_t));
+    if (h) {
+        h->kind = kind;
+        h->fd   = -1;
+    } else {
+        last_error = ERROR_NOT_ENOUGH_MEMORY;
+    }
+    return h;
+}
+
+static int file_fd(HANDLE h) {
+    compat_handle_t* c = (compat_handle_t*)h;
+    return (h && h != INVALID_HANDLE_VALUE && c->kind == HANDLE_FILE) ? c->fd : -1;
+}
+
+static void to_filetime(time_t t, FILETIME* ft) {
+    // Intervalles de 100 ns depuis 1601, comme Windows
+    unsigned long long v = ((unsigned long long)t + 11644473600ULL) * 10000000ULL;
+    ft->dwLowDateTime  = (DWORD)(v & 0xFFFFFFFFu);
+    ft->dwHighDateTime = (DWORD)(v >> 32);
+}
+
+// ── Fichiers ──────────────────────────────────────────────────────────────
+
+HANDLE CreateFileA(LPCSTR path, DWORD access, DWORD share, SECURITY_ATTRIBUTES* sa,
+                   DWORD disposition, DWORD flags, HANDLE template_file) {
+    (void)share; (void)sa; (void)template_file;
+    char native[MAX_PATH * 2];
+    native_path(path, native, sizeof(native));
+
+    int oflags = 0;
+    if ((access & GENERIC_READ) && (access & GENERIC_WRITE)) oflags = O_RDWR;
+    else if (access & GENERIC_WRITE)                         oflags = O_WRONLY;
+    else                                                     oflags = O_RDONLY;
+
+    if (disposition == CREATE_ALWAYS)    oflags |= O_CREAT | O_TRUNC;
+    else if (disposition == OPEN_ALWAYS) oflags |= O_CREAT;
+    if (flags & FILE_FLAG_WRITE_THROUGH) oflags |= O_DSYNC;
+#ifdef O_DIRECT
+    if (flags & FILE_FLAG_NO_BUFFERING)  oflags |= O_DIRECT;
+#endif
+
+    int fd = open(native, oflags | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        set_error_from_errno();
+        return INVALID_HANDLE_VALUE;
+    }
+
+#ifdef F_NOCACHE
+    if (flags & FILE_FLAG_NO_BUFFERING) fcntl(fd, F_NOCACHE, 1);
+#endif
+#ifdef POSIX_FADV_SEQUENTIAL
+    if (flags & FILE_FLAG_SEQUENTIAL_SCAN) posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    if (flags & FILE_FLAG_RANDOM_ACCESS)   posix_fadvise(fd, 0, 0, POSIX_FADV_RANDOM);
+#endif
+
+    compat_handle_t* h = new_handle(HANDLE_FILE);
+    if (!h) {
+        close(fd);
+        return INVALID_HANDLE_VALUE;
+    }
+    struct stat st;
+    h->fd     = fd;
+    h->stream = fstat(fd, &st) == 0 && !S_ISREG(st.st_mode) && !S_ISBLK(st.st_mode);
+    h->direct = (flags & FILE_FLAG_NO_BUFFERING) != 0;
+    return h;
+}
+
+BOOL ReadFile(HANDLE h, LPVOID buffer, DWORD size, LPDWORD read_bytes, void* overlapped) {
+    (void)overlapped;
+    int    fd     = file_fd(h);
+    int    valid  = h && h != INVALID_HANDLE_VALUE;
+    int    part   = valid && ((compat_handle_t*)h)->stream;
+    int    direct = valid && ((compat_handle_t*)h)->direct;
+    size_t total  = 0;
+    if (read_bytes) *read_bytes = 0;
+
+    // Comme ReadFile sur un fichier : on remplit le tampon sauf en fin de
+    // fichier. Sur un tube, une lecture partielle est rendue telle quelle.
+    while (total < size) {
+        ssize_t n = read(fd, (char*)buffer + total, size - total);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            set_error_from_errno();
+            return FALSE;
+        }
+        if (n == 0) break;
+        total += (size_t)n;
+        // Sans cache, relire à une position non alignée échouerait
+        if (part || (direct && total < size)) break;
+    }
+    if (read_bytes) *read_bytes = (DWORD)total;
+    return TRUE;
+}
+
+BOOL WriteFile(HANDLE h, const void* buffer, DWORD size, LPDWORD written, void* overlapped) {
+    (void)overlapped;
+    int    fd    = file_fd(h);
+    size_t total = 0;
+    if (written) *written = 0;
+
+    while (total < size) {
+        ssize_t n = write(fd, (const char*)buffer + total, size - total);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            set_error_from_errno();
+            return FALSE;
+        }
+        total += (size_t)n;
+    }
+    if (written) *written = (DWORD)total;
+    return TRUE;
+}
+
+BOOL CloseHandle(HANDLE h) {
+    if (!h || h == INVALID_HANDLE_VALUE) return FALSE;
+    compat_handle_t* c = (compat_handle_t*)h;
+    if (c->kind == HANDLE_FILE && c->fd >= 0) close(c->fd);
+    if (c->kind == HANDLE_FIND && c->dir)     closedir(c->dir);
+    if (c->kind == HANDLE_THREAD && !c->joined) pthread_detach(c->thread);
+    free(c);
+    return TRUE;
+}
+
+BOOL GetFileSizeEx(HANDLE h, LARGE_INTEGER* size) {
+    struct stat st;
+    if (fstat(file_fd(h), &st) != 0) {
+        set_error_from_errno();
+        return FALSE;
+    }
+    size->QuadPart = (LONGLONG)st.st_size;
+    return TRUE;
+}
+
+BOOL SetFilePointerEx(HANDLE h, LARGE_INTEGER distance, LARGE_INTEGER* new_pos, DWORD method) {
+    int   whence = method == FILE_END ? SEEK_END : method == FILE_CURRENT ? SEEK_CUR : SEEK_SET;
+    off_t pos    = lseek(file_fd(h), (off_t)distance.QuadPart, whence);
+    if (pos < 0) {
+        set_error_from_errno();
+        return FALSE;
+    }
+    if (new_pos) new_pos->QuadPart = (LONGLONG)pos;
+    return TRUE;
+}
+
+BOOL SetEndOfFile(HANDLE h) {
+    int   fd  = file_fd(h);
+    off_t pos = lseek(fd, 0, SEEK_CUR);
+    if (pos < 0 || ftruncate(fd, pos) != 0) {
+        set_error_from_errno();
+        return FALSE;
+    }
+    return TRUE;
+}
+
+void compat_drop_cache(HANDLE h, unsigned long long offset, unsigned long long length) {
+#ifdef POSIX_FADV_DONTNEED
+    int fd = file_fd(h);
+    if (fd >= 0) posix_fadvise(fd, (off_t)offset, (off_t)length, POSIX_FADV_DONTNEED);
+#else
+    (void)h; (void)offset; (void)length;
+#endif
+}
+
+long long compat_cached_bytes(LPCSTR path) {
+    char native[MAX_PATH * 2];
+    native_path(path, native, sizeof(native));
+    int fd = open(native, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+
+    struct stat st;
+    long long   cached = -1;
+    if (fstat(fd, &st) != 0) st.st_size = -1;
+    if (st.st_size == 0) cached = 0;
+    if (st.st_size > 0) {
+        long           page  = sysconf(_SC_PAGESIZE);
+        size_t         pages = (size_t)((st.st_size + page - 1) / page);
+        unsigned char* vec   = malloc(pages);
+        void*          map   = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (vec && map != MAP_FAILED && mincore(map, (size_t)st.st_size, (void*)vec) == 0) {
+            cached = 0;
+            for (size_t i = 0; i < pages; i++) cached += (vec[i] & 1) ? page : 0;
+        }
+        if (map != MAP_FAILED) munmap(map, (size_t)st.st_size);
+        free(vec);
+    }
+    close(fd);
+    return cached;
+}
+
+int compat_device_id(LPCSTR path, char* out, size_t size) {
+    char        native[MAX_PATH * 2];
+    struct stat st;
+    native_path(path, native, sizeof(native));
+    if (stat(native, &st) != 0) return -1;
+    snprintf(out, size, "dev-%u:%u", major(st.st_dev), minor(st.st_dev));
+    return 0;
+}
+
+HANDLE compat_fd_handle(int fd) {
+    compat_handle_t* h = new_handle(HANDLE_FILE);
+    if (!h) return INVALID_HANDLE_VALUE;
+    h->fd     = fd;
+    h->stream = 1;
+    return h;
+}
+
+BOOL FlushFileBuffers(HANDLE h) {
+    if (fsync(file_fd(h)) != 0) {
+        set_error_from_errno();
+        return FALSE;
+    }
+    return TRUE;
+}
+
+BOOL GetFileTime(HANDLE h, FILETIME* created, FILETIME* accessed, FILETIME* written) {
+    struct stat st;
+    if (fstat(file_fd(h), &st) != 0) {
+        set_error_from_errno();
+        return FALSE;
+    }
+    if (created)  to_filetime(st.st_ctime, created);
+    if (accessed) to_filetime(st.st_atime, accessed);
+    if (written)  to_filetime(st.st_mtime, written);
+    return TRUE;
+}
+
+BOOL DeleteFileA(LPCSTR path) {
+    char native[MAX_PATH * 2];
+    native_path(path, native, sizeof(native));
+    if (unlink(native) != 0) {
+        set_error_from_errno();
+        return FALSE;
+    }
+    return TRUE;
+}
+
+BOOL CopyFileA(LPCSTR from, LPCSTR to, BOOL fail_if_exists) {
+    HANDLE in = CreateFileA(from, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, 0, NULL);
+    if (in == INVALID_HANDLE_VALUE) return FALSE;
+    if (fail_if_exists && GetFileAttributesA(to) != INVALID_FILE_ATTRIBUTES) {
+        CloseHandle(in);
+        last_error = ERROR_FILE_EXISTS;
+        return FALSE;
+    }
+    HANDLE out = CreateFileA(to, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, 0, NULL);
+    if (out == INVALID_HANDLE_VALUE) {
+        CloseHandle(in);
+        return FALSE;
+    }
+
+    char  buffer[65536];
+    DWORD n, written;
+    BOOL  ok = TRUE;
+    while (ok && ReadFile(in, buffer, sizeof(buffer), &n, NULL) && n > 0) {
+        ok = WriteFile(out, buffer, n, &written, NULL);
+    }
+    CloseHandle(out);
+    CloseHandle(in);
+    return ok;
+}
+
+BOOL CreateDirectoryA(LPCSTR path, SECURITY_ATTRIBUTES* sa) {
+    (void)sa;
+    char native[MAX_PATH * 2];
+    native_path(path, native, sizeof(native));
+    if (mkdir(native, 0755) != 0) {
+        set_error_from_errno();
+        return FALSE;
+    }
+    return TRUE;
+}
+
+DWORD GetFileAttributesA(LPCSTR path) {
+    char        native[MAX_PATH * 2];
+    struct stat st;
+    native_path(path, native, sizeof(native));
+    if (stat(native, &st) != 0) {
+        set_error_from_errno();
+        return INVALID_FILE_ATTRIBUTES;
+    }
+    return S_ISDIR(st.st_mode) ? FILE_ATTRIBUTE_DIRECTORY : FILE_ATTRIBUTE_NORMAL;
+}
+
+BOOL GetFileAttributesExA(LPCSTR path, GET_FILEEX_INFO_LEVELS level, LPVOID out) {
+    (void)level;
+    char        native[MAX_PATH * 2];
+    struct stat st;
+    native_path(path, native, sizeof(native));
+    if (stat(native, &st) != 0) {
+        set_error_from_errno();
+        return FALSE;
+    }
+
+    WIN32_FILE_ATTRIBUTE_DATA* data = out;
+    memset(data, 0, sizeof(*data));
+    data->dwFileAttributes = S_ISDIR(st.st_mode) ? FILE_ATTRIBUTE_DIRECTORY : FILE_ATTRIBUTE_NORMAL;
+    data->nFileSizeHigh    = (DWORD)((unsigned long long)st.st_size >> 32);
+    data->nFileSizeLow     = (DWORD)((unsigned long long)st.st_size & 0xFFFFFFFFu);
+    to_filetime(st.st_mtime, &data->ftLastWriteTime);
+    return TRUE;
+}
+
+BOOL GetDiskFreeSpaceExA(LPCSTR path, ULARGE_INTEGER* free_caller,
+                         ULARGE_INTEGER* total, ULARGE_INTEGER* free_total) {
+    char           native[MAX_PATH * 2];
+    struct statvfs vfs;
+    native_path(path, native, sizeof(native));
+    if (statvfs(native, &vfs) != 0) {
+        set_error_from_errno();
+        return FALSE;
+    }
+    if (free_caller) free_caller->QuadPart = (ULONGLONG)vfs.f_bavail * vfs.f_frsize;
+    if (total)       total->QuadPart       = (ULONGLONG)vfs.f_blocks * vfs.f_frsize;
+    if (free_total)  free_total->QuadPart  = (ULONGLONG)vfs.f_bfree  * vfs.f_frsize;
+    return TRUE;
+}
+
+// ── Parcours de dossier ───────────────────────────────────────────────────
+
+static BOOL find_fill(compat_handle_t* h, WIN32_FIND_DATAA* data) {
+    struct dirent* e = readdir(h->dir);
+    if (!e) {
+        last_error = ERROR_FILE_NOT_FOUND;
+        return FALSE;
+    }
+
+    char        full[MAX_PATH * 2];
+    struct stat st;
+    memset(data, 0, sizeof(*data));
+    snprintf(data->cFileName, sizeof(data->cFileName), "%s", e->d_name);
+    snprintf(full, sizeof(full), "%s/%s", h->dir_path, e->d_name);
+    if (stat(full, &st) == 0) {
+        data->dwFileAttributes = S_ISDIR(st.st_mode) ? FILE_ATTRIBUTE_DIRECTORY
+                                                     : FILE_ATTRIBUTE_NORMAL;
+        data->nFileSizeHigh = (DWORD)((unsigned long long)st.st_size >> 32);
+        data->nFileSizeLow  = (DWORD)((unsigned long long)st.st_size & 0xFFFFFFFFu);
+        to_filetime(st.st_mtime, &data->ftLastWriteTime);
+    }
+    return TRUE;
+}
+
+HANDLE FindFirstFileA(LPCSTR pattern, WIN32_FIND_DATAA* data) {
+    compat_handle_t* h = new_handle(HANDLE_FIND);
+    if (!h) return INVALID_HANDLE_VALUE;
+
+    native_path(pattern, h->dir_path, sizeof(h->dir_path));
+    char* slash = strrchr(h->dir_path, '/');
+    if (slash && strcmp(slash + 1, "*") == 0) *slash = '\0';
+
+    h->dir = opendir(h->dir_path);
+    if (!h->dir) {
+        set_error_from_errno();
+        free(h);
+        return INVALID_HANDLE_VALUE;
+    }
+    if (!find_fill(h, data)) {
+        CloseHandle(h);
+        return INVALID_HANDLE_VALUE;
+    }
+    return h;
+}
+
+BOOL FindNextFileA(HANDLE h, WIN32_FIND_DATAA* data) {
+    return find_fill((compat_handle_t*)h, data);
+}
+
+BOOL FindClose(HANDLE h) {
+    return CloseHandle(h);
+}
+
+// ── Flux standard ─────────────────────────────────────────────────────────
+
+static compat_handle_t std_handles[3] = {
+    { .kind = HANDLE_FILE, .fd = 0, .stream = 1 },
+    { .kind = HANDLE_FILE, .fd = 1, .stream = 1 },
+    { .kind = HANDLE_FILE, .fd = 2, .stream = 1 },
+};
+
+HANDLE GetStdHandle(DWORD which) {
+    if (which == STD_INPUT_HANDLE)  return &std_handles[0];
+    if (which == STD_OUTPUT_HANDLE) return &std_handles[1];
+    return &std_handles[2];
+}
+
+// Les processus enfants n'existent pas hors Windows : rien à rediriger
+BOOL SetStdHandle(DWORD which, HANDLE h) {
+    (void)which; (void)h;
+    return TRUE;
+}
+
+HANDLE GetCurrentProcess(void) {
+    return NULL;
+}
+
+BOOL DuplicateHandle(HANDLE src_process, HANDLE src, HANDLE dst_process, HANDLE* dst,
+                     DWORD access, BOOL inherit, DWORD options) {
+    (void)src_process; (void)dst_process; (void)access; (void)inherit; (void)options;
+    int fd = dup(file_fd(src));
+    if (fd < 0) {
+        set_error_from_errno();
+        return FALSE;
+    }
+    compat_handle_t* h = new_handle(HANDLE_FILE);
+    if (!h) {
+        close(fd);
+        return FALSE;
+    }
+    h->fd     = fd;
+    h->stream = ((compat_handle_t*)src)->stream;
+    *dst      = h;
+    return TRUE;
+}
+
+// ── Threads et synchronisation ────────────────────────────────────────────
+
+typedef struct {
+    LPTHREAD_START_ROUTINE start;
+    LPVOID                 param;
+} thread_start_t;
+
+static void* thread_main(void* arg) {
+    thread_start_t s = *(thread_start_t*)arg;
+    free(arg);
+    s.start(s.param);
+    return NULL;
+}
+
+HANDLE CreateThread(SECURITY_ATTRIBUTES* sa, size_t stack, LPTHREAD_START_ROUTINE start,
+                    LPVOID param, DWORD flags, LPDWORD thread_id) {
+    (void)sa; (void)stack; (void)flags;
+    compat_handle_t* h = new_handle(HANDLE_THREAD);
+    thread_start_t*  s = malloc(sizeof(thread_start_t));
+    if (!h || !s) {
+        free(h);
+        free(s);
+        return NULL;
+    }
+    s->start = start;
+    s->param = param;
+    if (pthread_create(&h->thread, NULL, thread_main, s) != 0) {
+        free(h);
+        free(s);
+        return NULL;
+    }
+    if (thread_id) *thread_id = 0;
+    return h;
+}
+
+// Seule l'attente d'un thread est prise en charge
+DWORD WaitForSingleObject(HANDLE h, DWORD timeout_ms) {
+    (void)timeout_ms;
+    compat_handle_t* c = (compat_handle_t*)h;
+    if (c && c->kind == HANDLE_THREAD && !c->joined) {
+        pthread_join(c->thread, NULL);
+        c->joined = 1;
+    }
+    return 0;
+}
+
+void InitializeCriticalSection(CRITICAL_SECTION* cs) {
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);   // réentrant comme sous Windows
+    pthread_mutex_init(cs, &attr);
+    pthread_mutexattr_destroy(&attr);
+}
+
+void DeleteCriticalSection(CRITICAL_SECTION* cs) { pthread_mutex_destroy(cs); }
+void EnterCriticalSection(CRITICAL_SECTION* cs)  { pthread_mutex_lock(cs); }
+void LeaveCriticalSection(CRITICAL_SECTION* cs)  { pthread_mutex_unlock(cs); }
+
+void InitializeConditionVariable(CONDITION_VARIABLE* cv) {
+    pthread_cond_init(cv, NULL);
+}
+
+BOOL SleepConditionVariableCS(CONDITION_VARIABLE* cv, CRITICAL_SECTION* cs, DWORD timeout_ms) {
+    (void)timeout_ms;
+    return pthread_cond_wait(cv, cs) == 0;
+}
+
+void WakeAllConditionVariable(CONDITION_VARIABLE* cv) {
+    pthread_cond_broadcast(cv);
+}
+
+LONG InterlockedExchange(volatile LONG* target, LONG value) {
+    return __atomic_exchange_n(target, value, __ATOMIC_SEQ_CST);
+}
+
+// ── Divers ────────────────────────────────────────────────────────────────
+
+void Sleep(DWORD ms) {
+    struct timespec ts;
+    ts.tv_sec  = (time_t)(ms / 1000);
+    ts.tv_nsec = (long)(ms % 1000) * 1000000L;
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {}
+}
+
+// Compteur monotone en nanosecondes
+BOOL QueryPerformanceCounter(LARGE_INTEGER* count) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    count->QuadPart = (LONGLONG)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+    return TRUE;
+}
+
+BOOL QueryPerformanceFrequency(LARGE_INTEGER* frequency) {
+    frequency->QuadPart = 1000000000LL;
+    return TRUE;
+}
+
+void GetSystemInfo(SYSTEM_INFO* info) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    info->dwNumberOfProcessors = (DWORD)(n > 0 ? n : 1);
+}
+
+LONG BCryptGenRandom(HANDLE alg, BYTE* buffer, DWORD size, DWORD flags) {
+    if (alg || !(flags & BCRYPT_USE_SYSTEM_PREFERRED_RNG)) return (LONG)0xC000000D;
+    int fd = open("/dev/urandom", O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return (LONG)0xC0000001;
+    size_t done = 0;
+    while (done < size) {
+        ssize_t n = read(fd, buffer + done, size - done);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) continue;
+            close(fd);
+            return (LONG)0xC0000001;
+        }
+        done += (size_t)n;
+    }
+    close(fd);
+    return 0;
+}
+
+#endif
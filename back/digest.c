@@ -0,0 +1,1395 @@
+// digest.c
+#include "header/digest.h"
+#include "header/utils.h"
+#include "header/io_policy.h"
+#include "header/compat.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#define DIGEST_BUFFER_SIZE  (8 * 1024 * 1024)  // puissance de 2 : sous-arbres BLAKE3 alignés
+#define DIGEST_MIN_BUFFER   (64 * 1024)
+#define DIGEST_MAX_THREADS  32
+#define DIGEST_MAX_TASKS    1024
+#define DIGEST_CACHE_SIZE   16
+#define DIGEST_CACHE_MIN    (16ULL * 1024 * 1024)  // seuls les gros fichiers (ISO) sont mis en cache
+#define DIGEST_RATE_SAMPLE  (1024 * 1024)
+
+#define ROTR32(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+#define ROTR64(x, n) (((x) >> (n)) | ((x) << (64 - (n))))
+
+static uint32_t load32_le(const uint8_t* p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+#ifdef _WIN32
+// ── SHA-256 / SHA-512 (CNG) ───────────────────────────────────────────────
+// Sous Windows, SHA-2 passe par BCrypt : le fournisseur système utilise les
+// instructions SHA (SHA-NI) quand le processeur les a, bien plus rapide que
+// le code portable ci-dessous, réservé aux builds de compatibilité.
+
+typedef struct {
+    BCRYPT_HASH_HANDLE hash;
+    int                failed;
+} sha2_ctx_t;
+
+typedef sha2_ctx_t sha256_ctx_t;
+typedef sha2_ctx_t sha512_ctx_t;
+
+static INIT_ONCE         sha2_once = INIT_ONCE_STATIC_INIT;
+static BCRYPT_ALG_HANDLE sha256_alg;
+static BCRYPT_ALG_HANDLE sha512_alg;
+
+// Fournisseurs ouverts une fois pour toute la durée du processus
+static BOOL CALLBACK sha2_open(PINIT_ONCE once, PVOID param, PVOID* context) {
+    (void)once; (void)param; (void)context;
+    if (!BCRYPT_SUCCESS(BCryptOpenAlgorithmProvider(&sha256_alg, BCRYPT_SHA256_ALGORITHM,
+                                                    NULL, 0))) {
+        sha256_alg = NULL;
+    }
+    if (!BCRYPT_SUCCESS(BCryptOpenAlgorithmProvider(&sha512_alg, BCRYPT_SHA512_ALGORITHM,
+                                                    NULL, 0))) {
+        sha512_alg = NULL;
+    }
+    return TRUE;
+}
+
+static void sha2_init(sha2_ctx_t* c, BCRYPT_ALG_HANDLE* alg) {
+    c->hash   = NULL;
+    c->failed = 0;
+    InitOnceExecuteOnce(&sha2_once, sha2_open, NULL, NULL);
+    if (!*alg || !BCRYPT_SUCCESS(BCryptCreateHash(*alg, &c->hash, NULL, 0, NULL, 0, 0))) {
+        c->hash   = NULL;
+        c->failed = 1;
+    }
+}
+
+static void sha2_update(sha2_ctx_t* c, const uint8_t* p, size_t n) {
+    // BCryptHashData prend une longueur 32 bits
+    while (!c->failed && n > 0) {
+        ULONG part = (ULONG)(n > 0x40000000 ? 0x40000000 : n);
+        if (!BCRYPT_SUCCESS(BCryptHashData(c->hash, (PUCHAR)p, part, 0))) c->failed = 1;
+        p += part;
+        n -= part;
+    }
+}
+
+static int sha2_final(sha2_ctx_t* c, uint8_t* out, ULONG size) {
+    if (c->failed || !BCRYPT_SUCCESS(BCryptFinishHash(c->hash, out, size, 0))) {
+        memset(out, 0, size);
+        fprintf(stderr, "[Erreur] Calcul SHA-2 (BCrypt) echoue.\n");
+        return -1;
+    }
+    return 0;
+}
+
+static void sha2_free(sha2_ctx_t* c) {
+    if (c->hash) BCryptDestroyHash(c->hash);
+    c->hash = NULL;
+}
+
+static void sha256_init(sha256_ctx_t* c)                                { sha2_init(c, &sha256_alg); }
+static void sha256_update(sha256_ctx_t* c, const uint8_t* p, size_t n) { sha2_update(c, p, n); }
+static int  sha256_final(sha256_ctx_t* c, uint8_t out[32])              { return sha2_final(c, out, 32); }
+static void sha256_free(sha256_ctx_t* c)                                { sha2_free(c); }
+static void sha512_init(sha512_ctx_t* c)                                { sha2_init(c, &sha512_alg); }
+static void sha512_update(sha512_ctx_t* c, const uint8_t* p, size_t n) { sha2_update(c, p, n); }
+static int  sha512_final(sha512_ctx_t* c, uint8_t out[64])              { return sha2_final(c, out, 64); }
+static void sha512_free(sha512_ctx_t* c)                                { sha2_free(c); }
+
+#else
+static uint32_t load32_be(const uint8_t* p) {
+    return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+}
+
+static uint64_t load64_be(const uint8_t* p) {
+    return (uint64_t)load32_be(p) << 32 | load32_be(p + 4);
+}
+
+// ── SHA-256 ───────────────────────────────────────────────────────────────
+
+static const uint32_t K256[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+typedef struct {
+    uint32_t h[8];
+    uint64_t len;
+    uint8_t  buf[64];
+    size_t   buf_len;
+} sha256_ctx_t;
+
+static void sha256_init(sha256_ctx_t* c) {
+    static const uint32_t iv[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+        0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+    };
+    memcpy(c->h, iv, sizeof(iv));
+    c->len = 0;
+    c->buf_len = 0;
+}
+
+static void sha256_block(uint32_t h[8], const uint8_t* p) {
+    uint32_t w[64];
+    for (int i = 0; i < 16; i++) w[i] = load32_be(p + i * 4);
+    for (int i = 16; i < 64; i++) {
+        uint32_t s0 = ROTR32(w[i - 15], 7) ^ ROTR32(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = ROTR32(w[i - 2], 17) ^ ROTR32(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    uint32_t a = h[0], b = h[1], c = h[2], d = h[3];
+    uint32_t e = h[4], f = h[5], g = h[6], k = h[7];
+    for (int i = 0; i < 64; i++) {
+        uint32_t t1 = k + (ROTR32(e, 6) ^ ROTR32(e, 11) ^ ROTR32(e, 25))
+                        + ((e & f) ^ (~e & g)) + K256[i] + w[i];
+        uint32_t t2 = (ROTR32(a, 2) ^ ROTR32(a, 13) ^ ROTR32(a, 22))
+                        + ((a & b) ^ (a & c) ^ (b & c));
+        k = g; g = f; f = e; e = d + t1;
+        d = c; c = b; b = a; a = t1 + t2;
+    }
+    h[0] += a; h[1] += b; h[2] += c; h[3] += d;
+    h[4] += e; h[5] += f; h[6] += g; h[7] += k;
+}
+
+static void sha256_update(sha256_ctx_t* c, const uint8_t* p, size_t n) {
+    c->len += n;
+    if (c->buf_len > 0) {
+        size_t take = 64 - c->buf_len;
+        if (take > n) take = n;
+        memcpy(c->buf + c->buf_len, p, take);
+        c->buf_len += take;
+        p += take;
+        n -= take;
+        if (c->buf_len < 64) return;
+        sha256_block(c->h, c->buf);
+        c->buf_len = 0;
+    }
+    for (; n >= 64; p += 64, n -= 64) sha256_block(c->h, p);
+    memcpy(c->buf, p, n);
+    c->buf_len = n;
+}
+
+static int sha256_final(sha256_ctx_t* c, uint8_t out[32]) {
+    uint64_t bits = c->len * 8;
+    uint8_t  pad[72] = {0x80};
+    size_t   pad_len = (c->buf_len < 56) ? 56 - c->buf_len : 120 - c->buf_len;
+    for (int i = 0; i < 8; i++) pad[pad_len + i] = (uint8_t)(bits >> (56 - i * 8));
+    sha256_update(c, pad, pad_len + 8);
+    for (int i = 0; i < 8; i++) {
+        out[i * 4]     = (uint8_t)(c->h[i] >> 24);
+        out[i * 4 + 1] = (uint8_t)(c->h[i] >> 16);
+        out[i * 4 + 2] = (uint8_t)(c->h[i] >> 8);
+        out[i * 4 + 3] = (uint8_t)c->h[i];
+    }
+    return 0;
+}
+
+static void sha256_free(sha256_ctx_t* c) {
+    (void)c;
+}
+
+// ── SHA-512 ───────────────────────────────────────────────────────────────
+
+static const uint64_t K512[80] = {
+    0x428a2f98d728ae22ULL, 0x7137449123ef65cdULL, 0xb5c0fbcfec4d3b2fULL, 0xe9b5dba58189dbbcULL,
+    0x3956c25bf348b538ULL, 0x59f111f1b605d019ULL, 0x923f82a4af194f9bULL, 0xab1c5ed5da6d8118ULL,
+    0xd807aa98a3030242ULL, 0x12835b0145706fbeULL, 0x243185be4ee4b28cULL, 0x550c7dc3d5ffb4e2ULL,
+    0x72be5d74f27b896fULL, 0x80deb1fe3b1696b1ULL, 0x9bdc06a725c71235ULL, 0xc19bf174cf692694ULL,
+    0xe49b69c19ef14ad2ULL, 0xefbe4786384f25e3ULL, 0x0fc19dc68b8cd5b5ULL, 0x240ca1cc77ac9c65ULL,
+    0x2de92c6f592b0275ULL, 0x4a7484aa6ea6e483ULL, 0x5cb0a9dcbd41fbd4ULL, 0x76f988da831153b5ULL,
+    0x983e5152ee66dfabULL, 0xa831c66d2db43210ULL, 0xb00327c898fb213fULL, 0xbf597fc7beef0ee4ULL,
+    0xc6e00bf33da88fc2ULL, 0xd5a79147930aa725ULL, 0x06ca6351e003826fULL, 0x142929670a0e6e70ULL,
+    0x27b70a8546d22ffcULL, 0x2e1b21385c26c926ULL, 0x4d2c6dfc5ac42aedULL, 0x53380d139d95b3dfULL,
+    0x650a73548baf63deULL, 0x766a0abb3c77b2a8ULL, 0x81c2c92e47edaee6ULL, 0x92722c851482353bULL,
+    0xa2bfe8a14cf10364ULL, 0xa81a664bbc423001ULL, 0xc24b8b70d0f89791ULL, 0xc76c51a30654be30ULL,
+    0xd192e819d6ef5218ULL, 0xd69906245565a910ULL, 0xf40e35855771202aULL, 0x106aa07032bbd1b8ULL,
+    0x19a4c116b8d2d0c8ULL, 0x1e376c085141ab53ULL, 0x2748774cdf8eeb99ULL, 0x34b0bcb5e19b48a8ULL,
+    0x391c0cb3c5c95a63ULL, 0x4ed8aa4ae3418acbULL, 0x5b9cca4f7763e373ULL, 0x682e6ff3d6b2b8a3ULL,
+    0x748f82ee5defb2fcULL, 0x78a5636f43172f60ULL, 0x84c87814a1f0ab72ULL, 0x8cc702081a6439ecULL,
+    0x90befffa23631e28ULL, 0xa4506cebde82bde9ULL, 0xbef9a3f7b2c67915ULL, 0xc67178f2e372532bULL,
+    0xca273eceea26619cULL, 0xd186b8c721c0c207ULL, 0xeada7dd6cde0eb1eULL, 0xf57d4f7fee6ed178ULL,
+    0x06f067aa72176fbaULL, 0x0a637dc5a2c898a6ULL, 0x113f9804bef90daeULL, 0x1b710b35131c471bULL,
+    0x28db77f523047d84ULL, 0x32caab7b40c72493ULL, 0x3c9ebe0a15c9bebcULL, 0x431d67c49c100d4cULL,
+    0x4cc5d4becb3e42b6ULL, 0x597f299cfc657e2aULL, 0x5fcb6fab3ad6faecULL, 0x6c44198c4a475817ULL,
+};
+
+typedef struct {
+    uint64_t h[8];
+    uint64_t len;
+    uint8_t  buf[128];
+    size_t   buf_len;
+} sha512_ctx_t;
+
+static void sha512_init(sha512_ctx_t* c) {
+    static const uint64_t iv[8] = {
+        0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL, 0x3c6ef372fe94f82bULL, 0xa54ff53a5f1d36f1ULL,
+        0x510e527fade682d1ULL, 0x9b05688c2b3e6c1fULL, 0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL,
+    };
+    memcpy(c->h, iv, sizeof(iv));
+    c->len = 0;
+    c->buf_len = 0;
+}
+
+static void sha512_block(uint64_t h[8], const uint8_t* p) {
+    uint64_t w[80];
+    for (int i = 0; i < 16; i++) w[i] = load64_be(p + i * 8);
+    for (int i = 16; i < 80; i++) {
+        uint64_t s0 = ROTR64(w[i - 15], 1) ^ ROTR64(w[i - 15], 8) ^ (w[i - 15] >> 7);
+        uint64_t s1 = ROTR64(w[i - 2], 19) ^ ROTR64(w[i - 2], 61) ^ (w[i - 2] >> 6);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    uint64_t a = h[0], b = h[1], c = h[2], d = h[3];
+    uint64_t e = h[4], f = h[5], g = h[6], k = h[7];
+    for (int i = 0; i < 80; i++) {
+        uint64_t t1 = k + (ROTR64(e, 14) ^ ROTR64(e, 18) ^ ROTR64(e, 41))
+                        + ((e & f) ^ (~e & g)) + K512[i] + w[i];
+        uint64_t t2 = (ROTR64(a, 28) ^ ROTR64(a, 34) ^ ROTR64(a, 39))
+                        + ((a & b) ^ (a & c) ^ (b & c));
+        k = g; g = f; f = e; e = d + t1;
+        d = c; c = b; b = a; a = t1 + t2;
+    }
+    h[0] += a; h[1] += b; h[2] += c; h[3] += d;
+    h[4] += e; h[5] += f; h[6] += g; h[7] += k;
+}
+
+static void sha512_update(sha512_ctx_t* c, const uint8_t* p, size_t n) {
+    c->len += n;
+    if (c->buf_len > 0) {
+        size_t take = 128 - c->buf_len;
+        if (take > n) take = n;
+        memcpy(c->buf + c->buf_len, p, take);
+        c->buf_len += take;
+        p += take;
+        n -= take;
+        if (c->buf_len < 128) return;
+        sha512_block(c->h, c->buf);
+        c->buf_len = 0;
+    }
+    for (; n >= 128; p += 128, n -= 128) sha512_block(c->h, p);
+    memcpy(c->buf, p, n);
+    c->buf_len = n;
+}
+
+static int sha512_final(sha512_ctx_t* c, uint8_t out[64]) {
+    // Longueur sur 128 bits : les 64 bits de poids fort restent à zéro
+    uint64_t bits = c->len * 8;
+    uint8_t  pad[144] = {0x80};
+    size_t   pad_len = (c->buf_len < 112) ? 112 - c->buf_len : 240 - c->buf_len;
+    for (int i = 0; i < 8; i++) pad[pad_len + 8 + i] = (uint8_t)(bits >> (56 - i * 8));
+    sha512_update(c, pad, pad_len + 16);
+    for (int i = 0; i < 8; i++) {
+        for (int j = 0; j < 8; j++) out[i * 8 + j] = (uint8_t)(c->h[i] >> (56 - j * 8));
+    }
+    return 0;
+}
+
+static void sha512_free(sha512_ctx_t* c) {
+    (void)c;
+}
+#endif
+
+// ── BLAKE3 ────────────────────────────────────────────────────────────────
+// Implémentation portable du mode arbre : les chunks de 1 Ko sont regroupés
+// en sous-arbres alignés dont les feuilles sont hachées en parallèle.
+
+#define B3_BLOCK_LEN   64
+#define B3_CHUNK_LEN   1024
+#define B3_MAX_DEPTH   54
+
+#define B3_CHUNK_START 1
+#define B3_CHUNK_END   2
+#define B3_PARENT      4
+#define B3_ROOT        8
+
+static const uint32_t B3_IV[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+    0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+};
+
+static const uint8_t B3_SCHEDULE[7][16] = {
+    { 0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15},
+    { 2,  6,  3, 10,  7,  0,  4, 13,  1, 11, 12,  5,  9, 14, 15,  8},
+    { 3,  4, 10, 12, 13,  2,  7, 14,  6,  5,  9,  0, 11, 15,  8,  1},
+    {10,  7, 12,  9, 14,  3, 13, 15,  4,  0, 11,  2,  5,  8,  1,  6},
+    {12, 13,  9, 11, 15, 10, 14,  8,  7,  2,  5,  3,  0,  1,  6,  4},
+    { 9, 14, 11,  5,  8, 12, 15,  1, 13,  3,  0, 10,  2,  6,  4,  7},
+    {11, 15,  5,  0,  1,  9,  8,  6, 14, 10,  2, 12,  3,  4,  7, 13},
+};
+
+#define B3_G(s, a, b, c, d, x, y)                       \
+    do {                                                \
+        s[a] = s[a] + s[b] + (x); s[d] = ROTR32(s[d] ^ s[a], 16); \
+        s[c] = s[c] + s[d];       s[b] = ROTR32(s[b] ^ s[c], 12); \
+        s[a] = s[a] + s[b] + (y); s[d] = ROTR32(s[d] ^ s[a], 8);  \
+        s[c] = s[c] + s[d];       s[b] = ROTR32(s[b] ^ s[c], 7);  \
+    } while (0)
+
+static void b3_compress(const uint32_t cv[8], const uint32_t m[16],
+                        uint64_t counter, uint32_t block_len, uint32_t flags,
+                        uint32_t out[16]) {
+    uint32_t s[16] = {
+        cv[0], cv[1], cv[2], cv[3], cv[4], cv[5], cv[6], cv[7],
+        B3_IV[0], B3_IV[1], B3_IV[2], B3_IV[3],
+        (uint32_t)counter, (uint32_t)(counter >> 32), block_len, flags,
+    };
+    for (int r = 0; r < 7; r++) {
+        const uint8_t* k = B3_SCHEDULE[r];
+        B3_G(s, 0, 4,  8, 12, m[k[0]],  m[k[1]]);
+        B3_G(s, 1, 5,  9, 13, m[k[2]],  m[k[3]]);
+        B3_G(s, 2, 6, 10, 14, m[k[4]],  m[k[5]]);
+        B3_G(s, 3, 7, 11, 15, m[k[6]],  m[k[7]]);
+        B3_G(s, 0, 5, 10, 15, m[k[8]],  m[k[9]]);
+        B3_G(s, 1, 6, 11, 12, m[k[10]], m[k[11]]);
+        B3_G(s, 2, 7,  8, 13, m[k[12]], m[k[13]]);
+        B3_G(s, 3, 4,  9, 14, m[k[14]], m[k[15]]);
+    }
+    for (int i = 0; i < 8; i++) {
+        out[i]     = s[i] ^ s[i + 8];
+        out[i + 8] = s[i + 8] ^ cv[i];
+    }
+}
+
+static void b3_load_block(const uint8_t* p, uint32_t m[16]) {
+    for (int i = 0; i < 16; i++) m[i] = load32_le(p + i * 4);
+}
+
+// Nœud en attente de compression finale (chunk ou parent) : selon qu'il est
+// la racine ou non, on en tire la sortie ou la valeur de chaînage.
+typedef struct {
+    uint32_t cv[8];
+    uint32_t m[16];
+    uint64_t counter;
+    uint32_t block_len;
+    uint32_t flags;
+} b3_output_t;
+
+static void b3_output_cv(const b3_output_t* o, uint32_t cv[8]) {
+    uint32_t out[16];
+    b3_compress(o->cv, o->m, o->counter, o->block_len, o->flags, out);
+    memcpy(cv, out, 32);
+}
+
+static void b3_output_root(const b3_output_t* o, uint8_t hash[32]) {
+    uint32_t out[16];
+    b3_compress(o->cv, o->m, 0, o->block_len, o->flags | B3_ROOT, out);
+    for (int i = 0; i < 8; i++) {
+        hash[i * 4]     = (uint8_t)out[i];
+        hash[i * 4 + 1] = (uint8_t)(out[i] >> 8);
+        hash[i * 4 + 2] = (uint8_t)(out[i] >> 16);
+        hash[i * 4 + 3] = (uint8_t)(out[i] >> 24);
+    }
+}
+
+static b3_output_t b3_parent_output(const uint32_t left[8], const uint32_t right[8]) {
+    b3_output_t o;
+    memcpy(o.cv, B3_IV, 32);
+    memcpy(o.m, left, 32);
+    memcpy(o.m + 8, right, 32);
+    o.counter   = 0;
+    o.block_len = B3_BLOCK_LEN;
+    o.flags     = B3_PARENT;
+    return o;
+}
+
+static void b3_parent_cv(const uint32_t left[8], const uint32_t right[8], uint32_t cv[8]) {
+    b3_output_t o = b3_parent_output(left, right);
+    b3_output_cv(&o, cv);
+}
+
+// Chunk complet de 1 Ko, jamais racine
+static void b3_chunk_cv(const uint8_t* p, uint64_t counter, uint32_t cv[8]) {
+    uint32_t m[16], out[16];
+    memcpy(cv, B3_IV, 32);
+    for (int b = 0; b < B3_CHUNK_LEN / B3_BLOCK_LEN; b++) {
+        uint32_t flags = 0;
+        if (b == 0) flags |= B3_CHUNK_START;
+        if (b == B3_CHUNK_LEN / B3_BLOCK_LEN - 1) flags |= B3_CHUNK_END;
+        b3_load_block(p + b * B3_BLOCK_LEN, m);
+        b3_compress(cv, m, counter, B3_BLOCK_LEN, flags, out);
+        memcpy(cv, out, 32);
+    }
+}
+
+// Sous-arbre aligné de `chunks` chunks (puissance de 2), jamais racine
+static void b3_subtree_cv(const uint8_t* p, uint64_t chunks, uint64_t counter,
+                          uint32_t cv[8]) {
+    if (chunks == 1) {
+        b3_chunk_cv(p, counter, cv);
+        return;
+    }
+    uint32_t left[8], right[8];
+    uint64_t half = chunks / 2;
+    b3_subtree_cv(p, half, counter, left);
+    b3_subtree_cv(p + half * B3_CHUNK_LEN, half, counter + half, right);
+    b3_parent_cv(left, right, cv);
+}
+
+typedef struct {
+    uint32_t cv[8];
+    uint64_t counter;
+    uint8_t  buf[B3_BLOCK_LEN];
+    uint32_t buf_len;
+    uint32_t blocks_compressed;
+} b3_chunk_t;
+
+typedef struct {
+    b3_chunk_t chunk;
+    uint32_t   stack[B3_MAX_DEPTH][8];
+    int        stack_len;
+} blake3_ctx_t;
+
+static void b3_chunk_reset(b3_chunk_t* c, uint64_t counter) {
+    memset(c, 0, sizeof(*c));
+    memcpy(c->cv, B3_IV, 32);
+    c->counter = counter;
+}
+
+static size_t b3_chunk_len(const b3_chunk_t* c) {
+    return (size_t)c->blocks_compressed * B3_BLOCK_LEN + c->buf_len;
+}
+
+static void b3_chunk_update(b3_chunk_t* c, const uint8_t* p, size_t n) {
+    while (n > 0) {
+        if (c->buf_len == B3_BLOCK_LEN) {
+            uint32_t m[16], out[16];
+            b3_load_block(c->buf, m);
+            b3_compress(c->cv, m, c->counter, B3_BLOCK_LEN,
+                        c->blocks_compressed == 0 ? B3_CHUNK_START : 0, out);
+            memcpy(c->cv, out, 32);
+            c->blocks_compressed++;
+            c->buf_len = 0;
+            memset(c->buf, 0, sizeof(c->buf));
+        }
+        size_t take = B3_BLOCK_LEN - c->buf_len;
+        if (take > n) take = n;
+        memcpy(c->buf + c->buf_len, p, take);
+        c->buf_len += (uint32_t)take;
+        p += take;
+        n -= take;
+    }
+}
+
+static b3_output_t b3_chunk_output(const b3_chunk_t* c) {
+    b3_output_t o;
+    memcpy(o.cv, c->cv, 32);
+    b3_load_block(c->buf, o.m);
+    o.counter   = c->counter;
+    o.block_len = c->buf_len;
+    o.flags     = B3_CHUNK_END | (c->blocks_compressed == 0 ? B3_CHUNK_START : 0);
+    return o;
+}
+
+static void blake3_init(blake3_ctx_t* h) {
+    b3_chunk_reset(&h->chunk, 0);
+    h->stack_len = 0;
+}
+
+static int popcount64(uint64_t x) {
+    int n = 0;
+    for (; x; x &= x - 1) n++;
+    return n;
+}
+
+// Fusion paresseuse : la pile garde un nœud par bit à 1 du nombre de chunks
+// déjà traités, plus éventuellement un nœud tant qu'on ignore s'il est racine.
+static void b3_merge_stack(blake3_ctx_t* h, uint64_t total_chunks) {
+    int target = popcount64(total_chunks);
+    while (h->stack_len > target) {
+        uint32_t* left = h->stack[h->stack_len - 2];
+        b3_parent_cv(left, h->stack[h->stack_len - 1], left);
+        h->stack_len--;
+    }
+}
+
+static void b3_push_cv(blake3_ctx_t* h, const uint32_t cv[8], uint64_t chunk_counter) {
+    b3_merge_stack(h, chunk_counter);
+    memcpy(h->stack[h->stack_len], cv, 32);
+    h->stack_len++;
+}
+
+static void blake3_final(const blake3_ctx_t* h, uint8_t out[32]) {
+    if (h->stack_len == 0) {
+        b3_output_t o = b3_chunk_output(&h->chunk);
+        b3_output_root(&o, out);
+        return;
+    }
+
+    b3_output_t o;
+    int remaining;
+    if (b3_chunk_len(&h->chunk) > 0) {
+        remaining = h->stack_len;
+        o = b3_chunk_output(&h->chunk);
+    } else {
+        // Entrée terminée sur une frontière de sous-arbre : au moins deux nœuds
+        remaining = h->stack_len - 2;
+        o = b3_parent_output(h->stack[remaining], h->stack[remaining + 1]);
+    }
+    while (remaining > 0) {
+        uint32_t cv[8];
+        remaining--;
+        b3_output_cv(&o, cv);
+        o = b3_parent_output(h->stack[remaining], cv);
+    }
+    b3_output_root(&o, out);
+}
+
+// Complète un chunk commencé lors d'un appel précédent. Retourne 0 si
+// l'entrée est épuisée (le chunk reste en attente : il peut être racine).
+static int b3_fill_chunk(blake3_ctx_t* h, const uint8_t** p, size_t* n) {
+    if (b3_chunk_len(&h->chunk) == 0) return *n > 0;
+
+    size_t take = B3_CHUNK_LEN - b3_chunk_len(&h->chunk);
+    if (take > *n) take = *n;
+    b3_chunk_update(&h->chunk, *p, take);
+    *p += take;
+    *n -= take;
+    if (*n == 0) return 0;
+
+    uint32_t cv[8];
+    b3_output_t o = b3_chunk_output(&h->chunk);
+    b3_output_cv(&o, cv);
+    b3_push_cv(h, cv, h->chunk.counter);
+    b3_chunk_reset(&h->chunk, h->chunk.counter + 1);
+    return 1;
+}
+
+// Plus grand sous-arbre (en octets) qui tient dans n et reste aligné sur
+// le compteur de chunks courant
+static uint64_t b3_subtree_len(uint64_t counter, size_t n) {
+    uint64_t len = B3_CHUNK_LEN;
+    while (len * 2 <= n) len *= 2;
+    while (((len - 1) & (counter * B3_CHUNK_LEN)) != 0) len /= 2;
+    return len;
+}
+
+// Le dernier chunk (éventuellement complet) reste dans h->chunk
+static void b3_tail(blake3_ctx_t* h, const uint8_t* p, size_t n) {
+    if (n == 0) return;
+    b3_chunk_update(&h->chunk, p, n);
+    b3_merge_stack(h, h->chunk.counter);
+}
+
+static void blake3_update(blake3_ctx_t* h, const uint8_t* p, size_t n) {
+    if (!b3_fill_chunk(h, &p, &n)) return;
+
+    while (n > B3_CHUNK_LEN) {
+        uint64_t len    = b3_subtree_len(h->chunk.counter, n);
+        uint64_t chunks = len / B3_CHUNK_LEN;
+        uint32_t cv[8];
+
+        if (chunks == 1) {
+            b3_chunk_cv(p, h->chunk.counter, cv);
+            b3_push_cv(h, cv, h->chunk.counter);
+        } else {
+            uint32_t right[8];
+            b3_subtree_cv(p, chunks / 2, h->chunk.counter, cv);
+            b3_subtree_cv(p + len / 2, chunks / 2, h->chunk.counter + chunks / 2, right);
+            b3_push_cv(h, cv, h->chunk.counter);
+            b3_push_cv(h, right, h->chunk.counter + chunks / 2);
+        }
+        h->chunk.counter += chunks;
+        p += len;
+        n -= (size_t)len;
+    }
+    b3_tail(h, p, n);
+}
+
+// Version parallèle de blake3_update, en trois temps : b3_plan découpe le
+// tampon en sous-arbres alignés et en feuilles, le pool hache les feuilles,
+// b3_finish empile les résultats dans l'ordre. Chaque sous-arbre de plus
+// d'un chunk est empilé sous la forme de ses deux enfants, pour que
+// blake3_final puisse encore en faire la racine.
+typedef struct {
+    const uint8_t* data;
+    uint64_t       chunks;
+    uint64_t       counter;
+    uint32_t       cv[8];
+} b3_leaf_t;
+
+typedef struct {
+    uint64_t counter;
+    uint64_t chunks;
+    int      first_leaf;
+    int      leaf_count;
+} b3_subtree_t;
+
+typedef struct {
+    b3_subtree_t   subtrees[64];
+    int            subtree_count;
+    b3_leaf_t      leaves[DIGEST_MAX_TASKS];
+    int            leaf_count;
+    const uint8_t* tail;
+    size_t         tail_len;
+    size_t         consumed;      // octets couverts par ce lot
+    uint64_t       end_counter;
+} b3_batch_t;
+
+static void b3_plan(blake3_ctx_t* h, const uint8_t* p, size_t n,
+                    int leaves_per_subtree, b3_batch_t* batch) {
+    const uint8_t* start = p;
+
+    batch->subtree_count = 0;
+    batch->leaf_count    = 0;
+    batch->tail_len      = 0;
+
+    if (!b3_fill_chunk(h, &p, &n)) {
+        batch->consumed    = (size_t)(p - start);
+        batch->end_counter = h->chunk.counter;
+        return;
+    }
+
+    uint64_t counter = h->chunk.counter;
+    while (n > B3_CHUNK_LEN) {
+        uint64_t len    = b3_subtree_len(counter, n);
+        uint64_t chunks = len / B3_CHUNK_LEN;
+
+        int leaves = 1;
+        if (chunks > 1) {
+            leaves = 2;
+            while (leaves < leaves_per_subtree &&
+                   chunks / (uint64_t)(leaves * 2) >= 16) {
+                leaves *= 2;
+            }
+        }
+        // Lot plein : le reste du tampon passera dans un lot suivant
+        if (batch->subtree_count == 64 ||
+            batch->leaf_count + leaves > DIGEST_MAX_TASKS) {
+            break;
+        }
+
+        b3_subtree_t* st = &batch->subtrees[batch->subtree_count++];
+        st->counter    = counter;
+        st->chunks     = chunks;
+        st->first_leaf = batch->leaf_count;
+        st->leaf_count = leaves;
+        for (int i = 0; i < leaves; i++) {
+            b3_leaf_t* leaf = &batch->leaves[batch->leaf_count++];
+            leaf->chunks  = chunks / leaves;
+            leaf->counter = counter + leaf->chunks * i;
+            leaf->data    = p + leaf->chunks * i * B3_CHUNK_LEN;
+        }
+
+        counter += chunks;
+        p += len;
+        n -= (size_t)len;
+    }
+
+    if (n <= B3_CHUNK_LEN) {
+        batch->tail     = p;
+        batch->tail_len = n;
+        p += n;
+    }
+    batch->consumed    = (size_t)(p - start);
+    batch->end_counter = counter;
+}
+
+static void b3_finish(blake3_ctx_t* h, b3_batch_t* batch) {
+    for (int s = 0; s < batch->subtree_count; s++) {
+        b3_subtree_t* st     = &batch->subtrees[s];
+        b3_leaf_t*    leaves = &batch->leaves[st->first_leaf];
+
+        if (st->chunks == 1) {
+            b3_push_cv(h, leaves[0].cv, st->counter);
+            continue;
+        }
+        // Réduire les feuilles jusqu'aux deux enfants du sous-arbre
+        int count = st->leaf_count;
+        while (count > 2) {
+            for (int i = 0; i < count / 2; i++) {
+                b3_parent_cv(leaves[i * 2].cv, leaves[i * 2 + 1].cv, leaves[i].cv);
+            }
+            count /= 2;
+        }
+        b3_push_cv(h, leaves[0].cv, st->counter);
+        b3_push_cv(h, leaves[1].cv, st->counter + st->chunks / 2);
+    }
+
+    h->chunk.counter = batch->end_counter;
+    b3_tail(h, batch->tail, batch->tail_len);
+}
+
+// ── Empreintes d'un bloc mémoire ──────────────────────────────────────────
+
+void digest_sha256(const void* data, unsigned long long len, unsigned char out[32]) {
+    sha256_ctx_t c;
+    sha256_init(&c);
+    sha256_update(&c, data, (size_t)len);
+    sha256_final(&c, out);
+    sha256_free(&c);
+}
+
+void digest_sha512(const void* data, unsigned long long len, unsigned char out[64]) {
+    sha512_ctx_t c;
+    sha512_init(&c);
+    sha512_update(&c, data, (size_t)len);
+    sha512_final(&c, out);
+    sha512_free(&c);
+}
+
+void digest_blake3(const void* data, unsigned long long len, unsigned char out[32]) {
+    blake3_ctx_t h;
+    blake3_init(&h);
+    blake3_update(&h, data, (size_t)len);
+    blake3_final(&h, out);
+}
+
+// ── Pool de threads ───────────────────────────────────────────────────────
+// Créé au premier besoin et conservé : les appels suivants ne paient plus
+// le démarrage des threads. Un seul lot de tâches à la fois.
+
+typedef struct {
+    void (*fn)(void*);
+    void* arg;
+} digest_task_t;
+
+static struct {
+    int                started;
+    int                thread_count;
+    CRITICAL_SECTION   lock;
+    CRITICAL_SECTION   batch_lock;
+    CONDITION_VARIABLE work_ready;
+    CONDITION_VARIABLE work_done;
+    digest_task_t      tasks[DIGEST_MAX_TASKS + 2];
+    int                next;
+    int                count;
+    int                pending;
+} pool;
+
+static DWORD WINAPI pool_worker(LPVOID unused) {
+    (void)unused;
+    for (;;) {
+        EnterCriticalSection(&pool.lock);
+        while (pool.next >= pool.count) {
+            SleepConditionVariableCS(&pool.work_ready, &pool.lock, INFINITE);
+        }
+        digest_task_t task = pool.tasks[pool.next++];
+        LeaveCriticalSection(&pool.lock);
+
+        task.fn(task.arg);
+
+        EnterCriticalSection(&pool.lock);
+        if (--pool.pending == 0) WakeAllConditionVariable(&pool.work_done);
+        LeaveCriticalSection(&pool.lock);
+    }
+    return 0;
+}
+
+static int cpu_threads(void) {
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    int count = (int)si.dwNumberOfProcessors;
+    if (count < 1) count = 1;
+    if (count > DIGEST_MAX_THREADS) count = DIGEST_MAX_THREADS;
+    return count;
+}
+
+// Débit BLAKE3 d'un thread, mesuré une fois
+static double hash_rate(void) {
+    static double rate = 0;
+    if (rate > 0) return rate;
+
+    uint8_t* sample = calloc(1, DIGEST_RATE_SAMPLE);
+    if (!sample) return 0;
+    unsigned char out[32];
+    LARGE_INTEGER start, end, freq;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&start);
+    for (int i = 0; i < 4; i++) digest_blake3(sample, DIGEST_RATE_SAMPLE, out);
+    QueryPerformanceCounter(&end);
+    free(sample);
+
+    double elapsed = (double)(end.QuadPart - start.QuadPart) / (double)freq.QuadPart;
+    rate = elapsed > 0 ? 4.0 * DIGEST_RATE_SAMPLE / elapsed : 0;
+    return rate;
+}
+
+// Le pool garde un thread par cœur ; le débit limite le découpage
+int digest_threads_for(double bandwidth) {
+    int    count = cpu_threads();
+    double rate  = bandwidth > 0 ? hash_rate() : 0;
+    if (rate <= 0) return count;
+    int threads = (int)(bandwidth / rate) + 1;
+    return threads < count ? threads : count;
+}
+
+static void pool_start(void) {
+    if (pool.started) return;
+
+    pool.thread_count = cpu_threads();
+
+    InitializeCriticalSection(&pool.lock);
+    InitializeCriticalSection(&pool.batch_lock);
+    InitializeConditionVariable(&pool.work_ready);
+    InitializeConditionVariable(&pool.work_done);
+
+    for (int i = 0; i < pool.thread_count; i++) {
+        HANDLE t = CreateThread(NULL, 0, pool_worker, NULL, 0, NULL);
+        if (t) CloseHandle(t);
+    }
+    pool.started = 1;
+}
+
+static void pool_submit(const digest_task_t* tasks, int count) {
+    EnterCriticalSection(&pool.lock);
+    memcpy(pool.tasks, tasks, count * sizeof(digest_task_t));
+    pool.next    = 0;
+    pool.count   = count;
+    pool.pending = count;
+    WakeAllConditionVariable(&pool.work_ready);
+    LeaveCriticalSection(&pool.lock);
+}
+
+static void pool_wait(void) {
+    EnterCriticalSection(&pool.lock);
+    while (pool.pending > 0) {
+        SleepConditionVariableCS(&pool.work_done, &pool.lock, INFINITE);
+    }
+    LeaveCriticalSection(&pool.lock);
+}
+
+// ── Cache des empreintes ──────────────────────────────────────────────────
+// Clé : chemin + taille + date de modification. Protégé par pool.batch_lock.
+
+typedef struct {
+    char               path[MAX_PATH];
+    unsigned long long size;
+    unsigned long long mtime;
+    digest_result_t    result;
+} digest_cache_entry_t;
+
+static struct {
+    int                  enabled;
+    int                  next;
+    digest_cache_entry_t entries[DIGEST_CACHE_SIZE];
+} cache;
+
+void digest_cache_enable(int enabled) {
+    cache.enabled = enabled;
+}
+
+static digest_cache_entry_t* cache_lookup(const char* path, unsigned long long size,
+                                          unsigned long long mtime) {
+    for (int i = 0; i < DIGEST_CACHE_SIZE; i++) {
+        digest_cache_entry_t* e = &cache.entries[i];
+        if (e->result.algos && e->size == size && e->mtime == mtime &&
+            _stricmp(e->path, path) == 0) {
+            return e;
+        }
+    }
+    return NULL;
+}
+
+static void cache_store(const char* path, unsigned long long size,
+                        unsigned long long mtime, const digest_result_t* result) {
+    digest_cache_entry_t* e = cache_lookup(path, size, mtime);
+    if (!e) {
+        e = &cache.entries[cache.next];
+        cache.next = (cache.next + 1) % DIGEST_CACHE_SIZE;
+        memset(e, 0, sizeof(*e));
+        if (copy_string(e->path, sizeof(e->path), path) != 0) {
+            e->path[0] = '\0';   // chemin trop long : pas mis en cache
+            return;
+        }
+        e->size  = size;
+        e->mtime = mtime;
+    }
+    if (result->algos & DIGEST_SHA256) memcpy(e->result.sha256, result->sha256, 32);
+    if (result->algos & DIGEST_SHA512) memcpy(e->result.sha512, result->sha512, 64);
+    if (result->algos & DIGEST_BLAKE3) memcpy(e->result.blake3, result->blake3, 32);
+    e->result.algos |= result->algos;
+}
+
+// ── Hachage d'un fichier en une passe ─────────────────────────────────────
+// Double tampon : le thread principal lit le tampon suivant pendant que le
+// pool hache le tampon courant (SHA-256, SHA-512 et feuilles BLAKE3 en
+// parallèle).
+
+typedef struct {
+    sha256_ctx_t   sha256;
+    sha512_ctx_t   sha512;
+    blake3_ctx_t   blake3;
+    b3_batch_t     batch;
+    const uint8_t* data;
+    size_t         len;
+} digest_job_t;
+
+static void task_sha256(void* arg) {
+    digest_job_t* job = arg;
+    sha256_update(&job->sha256, job->data, job->len);
+}
+
+static void task_sha512(void* arg) {
+    digest_job_t* job = arg;
+    sha512_update(&job->sha512, job->data, job->len);
+}
+
+static void task_b3_leaf(void* arg) {
+    b3_leaf_t* leaf = arg;
+    b3_subtree_cv(leaf->data, leaf->chunks, leaf->counter, leaf->cv);
+}
+
+// Prépare les tâches d'un tampon. BLAKE3 peut laisser une partie du tampon
+// non traitée (trop de sous-arbres) : *consumed indique ce qui est couvert.
+static int prepare_tasks(digest_job_t* job, unsigned int algos, int threads,
+                         const uint8_t* p, size_t n, digest_task_t* tasks,
+                         size_t* consumed) {
+    int count = 0;
+    *consumed = n;
+
+    if (algos & DIGEST_BLAKE3) {
+        b3_plan(&job->blake3, p, n, threads * 2, &job->batch);
+        *consumed = job->batch.consumed;
+        for (int i = 0; i < job->batch.leaf_count; i++) {
+            tasks[count].fn  = task_b3_leaf;
+            tasks[count].arg = &job->batch.leaves[i];
+            count++;
+        }
+    }
+
+    job->data = p;
+    job->len  = *consumed;
+    if (algos & DIGEST_SHA256) {
+        tasks[count].fn  = task_sha256;
+        tasks[count].arg = job;
+        count++;
+    }
+    if (algos & DIGEST_SHA512) {
+        tasks[count].fn  = task_sha512;
+        tasks[count].arg = job;
+        count++;
+    }
+    return count;
+}
+
+static void run_tasks(digest_job_t* job, unsigned int algos, int threads,
+                      const uint8_t* p, size_t n, digest_task_t* tasks) {
+    while (n > 0) {
+        size_t consumed;
+        int count = prepare_tasks(job, algos, threads, p, n, tasks, &consumed);
+        pool_submit(tasks, count);
+        pool_wait();
+        if (algos & DIGEST_BLAKE3) b3_finish(&job->blake3, &job->batch);
+        p += consumed;
+        n -= consumed;
+    }
+}
+
+// Hache [offset, offset + length) du fichier (double tampon : la lecture du
+// bloc suivant recouvre le hachage du bloc courant). Lectures selon la
+// politique d'E/S (io_policy.h). BLAKE3 est découpé pour threads threads.
+// L'appelant tient pool.batch_lock.
+// Retourne 0, -1 en erreur, -2 si annulé.
+static int hash_stream(io_reader_t* reader, unsigned long long offset, unsigned long long length,
+                       unsigned int algos, int threads, digest_result_t* out,
+                       progress_callback_t progress_cb) {
+    // Taille de lecture du périphérique si elle est connue ; petits fichiers :
+    // tampon réduit. Toujours une puissance de 2.
+    size_t limit = DIGEST_BUFFER_SIZE;
+    while (reader->block && limit > DIGEST_MIN_BUFFER && limit > reader->block) limit /= 2;
+
+    size_t buffer_size = DIGEST_MIN_BUFFER;
+    while (buffer_size < limit && buffer_size < length) {
+        buffer_size *= 2;
+    }
+
+    digest_job_t*  job     = malloc(sizeof(digest_job_t));
+    digest_task_t* tasks   = malloc((DIGEST_MAX_TASKS + 2) * sizeof(digest_task_t));
+    uint8_t*       bufs[2] = { io_alloc(buffer_size), io_alloc(buffer_size) };
+    if (!job || !tasks || !bufs[0] || !bufs[1]) {
+        fprintf(stderr, "[Erreur] Memoire insuffisante pour le hachage.\n");
+        free(job); free(tasks); io_free(bufs[0]); io_free(bufs[1]);
+        return -1;
+    }
+
+    sha256_init(&job->sha256);
+    sha512_init(&job->sha512);
+    blake3_init(&job->blake3);
+
+    int                rc   = 0;
+    int                cur  = 0;
+    unsigned long long done = 0;
+    unsigned long long left = length;
+    DWORD              n_cur = 0, n_next = 0;
+    DWORD              want  = (DWORD)(left < buffer_size ? left : buffer_size);
+
+    if (want && io_read_at(reader, offset, bufs[cur], want, &n_cur) != 0) rc = -1;
+    left -= n_cur;
+
+    while (rc == 0 && n_cur > 0) {
+        if (cancel_requested()) {
+            rc = -2;
+            break;
+        }
+        size_t consumed;
+        int count = prepare_tasks(job, algos, threads, bufs[cur], n_cur, tasks, &consumed);
+        pool_submit(tasks, count);
+
+        n_next = 0;
+        want   = (DWORD)(left < buffer_size ? left : buffer_size);
+        if (want && io_read_at(reader, offset + (length - left), bufs[cur ^ 1], want,
+                               &n_next) != 0) {
+            rc = -1;
+        }
+        left -= n_next;
+
+        pool_wait();
+        if (algos & DIGEST_BLAKE3) b3_finish(&job->blake3, &job->batch);
+        if (consumed < n_cur) {
+            run_tasks(job, algos, threads, bufs[cur] + consumed, n_cur - consumed, tasks);
+        }
+
+        done += n_cur;
+        if (progress_cb) progress_cb(done, length);
+
+        cur  ^= 1;
+        n_cur = n_next;
+    }
+
+    if (rc == 0 && left > 0) rc = -1;   // fichier plus court que prévu
+    if (rc == 0) {
+        out->algos = algos;
+        if ((algos & DIGEST_SHA256) && sha256_final(&job->sha256, out->sha256) != 0) rc = -1;
+        if ((algos & DIGEST_SHA512) && sha512_final(&job->sha512, out->sha512) != 0) rc = -1;
+        if (algos & DIGEST_BLAKE3) blake3_final(&job->blake3, out->blake3);
+    }
+
+    sha256_free(&job->sha256);
+    sha512_free(&job->sha512);
+    free(job); free(tasks); io_free(bufs[0]); io_free(bufs[1]);
+    return rc;
+}
+
+static int report_hash_error(int rc, const char* path) {
+    if (rc == -2) {
+        fprintf(stderr, "[Pleco] Hachage annule : %s\n", path);
+    } else if (rc != 0) {
+        fprintf(stderr, "[Erreur] Lecture echouee : %s\n", path);
+    }
+    return rc == 0 ? 0 : -1;
+}
+
+int digest_file(const char* path, unsigned int algos, digest_result_t* out,
+                progress_callback_t progress_cb) {
+    memset(out, 0, sizeof(*out));
+
+    io_reader_t reader;
+    if (io_open(&reader, path) != 0) {
+        fprintf(stderr, "[Erreur] Impossible d'ouvrir : %s\n", path);
+        return -1;
+    }
+
+    LARGE_INTEGER size;
+    FILETIME      ft = {0};
+    size.QuadPart = 0;
+    GetFileSizeEx(reader.cached, &size);
+    GetFileTime(reader.cached, NULL, NULL, &ft);
+
+    unsigned long long mtime = (unsigned long long)ft.dwHighDateTime << 32 | ft.dwLowDateTime;
+    int cacheable = cache.enabled && (unsigned long long)size.QuadPart >= DIGEST_CACHE_MIN;
+
+    pool_start();
+    EnterCriticalSection(&pool.batch_lock);
+
+    digest_cache_entry_t* cached = cacheable ? cache_lookup(path, (unsigned long long)size.QuadPart, mtime) : NULL;
+    if (cached && (cached->result.algos & algos) == algos) {
+        *out = cached->result;
+        LeaveCriticalSection(&pool.batch_lock);
+        io_close(&reader);
+        if (progress_cb) progress_cb((unsigned long long)size.QuadPart,
+                                     (unsigned long long)size.QuadPart);
+        return 0;
+    }
+
+    int rc = hash_stream(&reader, 0, (unsigned long long)size.QuadPart, algos,
+                         digest_threads_for(reader.bandwidth), out, progress_cb);
+    io_close(&reader);
+    if (rc == 0 && cacheable) cache_store(path, (unsigned long long)size.QuadPart, mtime, out);
+    LeaveCriticalSection(&pool.batch_lock);
+
+    return report_hash_error(rc, path);
+}
+
+int digest_file_range(const char* path, unsigned long long offset, unsigned long long length,
+                      unsigned int algos, digest_result_t* out,
+                      progress_callback_t progress_cb) {
+    memset(out, 0, sizeof(*out));
+
+    io_reader_t reader;
+    if (io_open(&reader, path) != 0) {
+        fprintf(stderr, "[Erreur] Impossible d'ouvrir : %s\n", path);
+        return -1;
+    }
+
+    pool_start();
+    EnterCriticalSection(&pool.batch_lock);
+    int rc = hash_stream(&reader, offset, length, algos, digest_threads_for(reader.bandwidth),
+                         out, progress_cb);
+    LeaveCriticalSection(&pool.batch_lock);
+    io_close(&reader);
+
+    return report_hash_error(rc, path);
+}
+
+void digest_to_hex(const unsigned char* bytes, int len, char* out) {
+    static const char hex[] = "0123456789abcdef";
+    for (int i = 0; i < len; i++) {
+        out[i * 2]     = hex[bytes[i] >> 4];
+        out[i * 2 + 1] = hex[bytes[i] & 0xf];
+    }
+    out[len * 2] = '\0';
+}
+
+// ── Vérification de l'ISO ─────────────────────────────────────────────────
+
+typedef struct {
+    unsigned int algo;
+    char         hex[129];
+} expected_t;
+
+static const char* algo_name(unsigned int algo) {
+    switch (algo) {
+        case DIGEST_SHA256: return "SHA-256";
+        case DIGEST_SHA512: return "SHA-512";
+        case DIGEST_BLAKE3: return "BLAKE3";
+    }
+    return "?";
+}
+
+static int is_hex_string(const char* s, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        if (!isxdigit((unsigned char)s[i])) return 0;
+    }
+    return len > 0;
+}
+
+static int names_equal(const char* a, const char* b) {
+    for (; *a && *b; a++, b++) {
+        if (tolower((unsigned char)*a) != tolower((unsigned char)*b)) return 0;
+    }
+    return *a == *b;
+}
+
+static const char* base_name(const char* path) {
+    const char* base = path;
+    for (const char* p = path; *p; p++) {
+        if (*p == '\\' || *p == '/') base = p + 1;
+    }
+    return base;
+}
+
+// Algorithme d'un hash nu : la longueur tranche sauf pour 64 caractères,
+// où le nom du manifeste (B3SUMS, *.b3...) peut indiquer BLAKE3.
+static unsigned int algo_from_length(size_t len, unsigned int hint) {
+    if (len == 128) return DIGEST_SHA512;
+    if (len == 64)  return (hint == DIGEST_BLAKE3) ? DIGEST_BLAKE3 : DIGEST_SHA256;
+    return 0;
+}
+
+// Le nom du manifeste désigne-t-il BLAKE3 ? Seuls ses mots comptent
+// (B3SUMS, blake3sums.txt, ubuntu.iso.b3...), pas une sous-chaîne.
+static unsigned int algo_hint(const char* manifest_path) {
+    static const char* const tokens[] = { "B3", "B3SUM", "B3SUMS", "BLAKE3", "BLAKE3SUM",
+                                          "BLAKE3SUMS", NULL };
+    const char* p = base_name(manifest_path);
+    while (*p) {
+        while (*p && !isalnum((unsigned char)*p)) p++;
+        const char* word = p;
+        while (isalnum((unsigned char)*p)) p++;
+        size_t n = (size_t)(p - word);
+        for (int i = 0; n > 0 && tokens[i]; i++) {
+            if (strlen(tokens[i]) == n && _strnicmp(word, tokens[i], n) == 0) {
+                return DIGEST_BLAKE3;
+            }
+        }
+    }
+    return 0;
+}
+
+static int parse_manifest(const char* manifest_path, const char* iso_name,
+                          expected_t* out) {
+    FILE* f = fopen(manifest_path, "r");
+    if (!f) return -1;
+
+    unsigned int hint = algo_hint(manifest_path);
+
+    char line[1024];
+    int  found = -1;
+    while (found != 0 && fgets(line, sizeof(line), f)) {
+        line[strcspn(line, "\r\n")] = '\0';
+        char*        hash = NULL;
+        char*        name = NULL;
+        unsigned int algo = 0;
+
+        char* open  = strstr(line, " (");
+        char* close = strstr(line, ") = ");
+        if (open && close && close > open) {
+            // Format BSD : SHA256 (nom.iso) = hash
+            *open = '\0';
+            *close = '\0';
+            name = open + 2;
+            hash = close + 4;
+            if (names_equal(line, "SHA256"))      algo = DIGEST_SHA256;
+            else if (names_equal(line, "SHA512")) algo = DIGEST_SHA512;
+            else if (names_equal(line, "BLAKE3")) algo = DIGEST_BLAKE3;
+        } else {
+            // Format GNU : hash  nom.iso  (ou hash *nom.iso en mode binaire)
+            char* sep = strchr(line, ' ');
+            if (!sep) continue;
+            *sep = '\0';
+            hash = line;
+            name = sep + 1;
+            while (*name == ' ') name++;
+            if (*name == '*') name++;
+            algo = algo_from_length(strlen(hash), hint);
+        }
+
+        if (!algo || !is_hex_string(hash, strlen(hash))) continue;
+        if (strncmp(name, "./", 2) == 0) name += 2;
+        if (!names_equal(base_name(name), iso_name)) continue;
+
+        if (copy_string(out->hex, sizeof(out->hex), hash) != 0) continue;
+        out->algo = algo;
+        found = 0;
+    }
+
+    fclose(f);
+    if (found != 0) {
+        fprintf(stderr, "[Erreur] %s absent du manifeste %s.\n", iso_name, manifest_path);
+    }
+    return found;
+}
+
+static int parse_expected(const char* spec, const char* iso_name, expected_t* out) {
+    static const struct { const char* prefix; unsigned int algo; } prefixes[] = {
+        { "sha256:", DIGEST_SHA256 },
+        { "sha512:", DIGEST_SHA512 },
+        { "blake3:", DIGEST_BLAKE3 },
+    };
+
+    memset(out, 0, sizeof(*out));
+    for (int i = 0; i < 3; i++) {
+        size_t plen = strlen(prefixes[i].prefix);
+        if (strlen(spec) > plen && strncmp(spec, prefixes[i].prefix, plen) == 0) {
+            spec += plen;
+            out->algo = prefixes[i].algo;
+            break;
+        }
+    }
+
+    size_t len = strlen(spec);
+    if (is_hex_string(spec, len)) {
+        if (!out->algo) out->algo = algo_from_length(len, 0);
+        if (out->algo && len == (out->algo == DIGEST_SHA512 ? 128u : 64u)) {
+            memcpy(out->hex, spec, len + 1);
+            return 0;
+        }
+    }
+
+    if (!out->algo && parse_manifest(spec, iso_name, out) == 0) return 0;
+
+    fprintf(stderr, "[Erreur] Empreinte ou manifeste invalide : %s\n", spec);
+    return -1;
+}
+
+// Longueur du prochain élément de la liste : le plus long préfixe jusqu'à
+// une virgule qui désigne un fichier existant (un chemin peut contenir des
+// virgules), sinon jusqu'à la première virgule.
+static size_t next_spec(const char* spec) {
+    size_t first = strcspn(spec, ",");
+    if (!spec[first]) return first;
+
+    char* path = _strdup(spec);
+    if (!path) return first;
+    size_t len = strlen(path);
+    for (;;) {
+        path[len] = '\0';
+        if (GetFileAttributesA(path) != INVALID_FILE_ATTRIBUTES) break;
+        while (len > first && path[len - 1] != ',') len--;
+        if (len <= first) {
+            len = first;
+            break;
+        }
+        len--;
+    }
+    free(path);
+    return len;
+}
+
+int verify_iso_digest(const char* iso_path, const char* expected,
+                      progress_callback_t progress_cb) {
+    // Une entrée au plus par élément de la liste
+    size_t max = 1;
+    for (const char* c = expected; *c; c++) {
+        if (*c == ',') max++;
+    }
+    expected_t* list  = malloc(max * sizeof(expected_t));
+    char*       specs = _strdup(expected);
+    if (!list || !specs) {
+        fprintf(stderr, "[Erreur] Memoire insuffisante.\n");
+        free(list); free(specs);
+        return 0;
+    }
+
+    int          count = 0;
+    unsigned int algos = 0;
+    int          ok    = 1;
+    for (char* spec = specs; ok && *spec;) {
+        while (*spec == ' ' || *spec == ',') spec++;
+        if (!*spec) break;
+        size_t len = next_spec(spec);
+        char*  next = spec + len + (spec[len] ? 1 : 0);
+        spec[len] = '\0';
+        if (parse_expected(spec, base_name(iso_path), &list[count]) != 0) {
+            ok = 0;
+        } else {
+            algos |= list[count].algo;
+            count++;
+        }
+        spec = next;
+    }
+    free(specs);
+    if (!ok) {
+        free(list);
+        return 0;
+    }
+    if (count == 0) {
+        fprintf(stderr, "[Erreur] Aucune empreinte attendue.\n");
+        free(list);
+        return 0;
+    }
+
+    digest_result_t result;
+    if (digest_file(iso_path, algos, &result, progress_cb) != 0) {
+        free(list);
+        return 0;
+    }
+
+    for (int i = 0; i < count; i++) {
+        char computed[129];
+        if (list[i].algo == DIGEST_SHA256)      digest_to_hex(result.sha256, 32, computed);
+        else if (list[i].algo == DIGEST_SHA512) digest_to_hex(result.sha512, 64, computed);
+        else                                    digest_to_hex(result.blake3, 32, computed);
+
+        if (names_equal(computed, list[i].hex)) {
+            printf("[Pleco] Hash %s valide.\n", algo_name(list[i].algo));
+        } else {
+            fprintf(stderr, "[Erreur] Hash %s invalide !\n", algo_name(list[i].algo));
+            fprintf(stderr, "  Attendu  : %s\n", list[i].hex);
+            fprintf(stderr, "  Calcule  : %s\n", computed);
+            ok = 0;
+        }
+    }
+    free(list);
+    return ok;
+}
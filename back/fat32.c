@@ -0,0 +1,946 @@
+// fat32.c
+#include "header/fat32.h"
+#include "header/compat.h"
+#include "header/utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define SECTOR          512
+#define RESERVED_SECT   32
+#define FSINFO_SECT     1
+#define BACKUP_SECT     6
+#define ROOT_CLUSTER    2
+#define FAT_EOC         0x0FFFFFFFu
+#define FAT_MASK        0x0FFFFFFFu
+#define MIN_CLUSTERS    65525u
+#define DIR_ENTRY       32
+#define MAX_DIR_ENTRIES 65536          // limite FAT pour un dossier
+
+#define ATTR_READ_ONLY  0x01
+#define ATTR_HIDDEN     0x02
+#define ATTR_SYSTEM     0x04
+#define ATTR_VOLUME_ID  0x08
+#define ATTR_DIRECTORY  0x10
+#define ATTR_ARCHIVE    0x20
+#define ATTR_LFN        0x0F
+
+// ── Utilitaires ───────────────────────────────────────────────────────────
+
+static void put16(BYTE* p, unsigned int v) {
+    p[0] = (BYTE)v;
+    p[1] = (BYTE)(v >> 8);
+}
+
+static void put32(BYTE* p, unsigned int v) {
+    p[0] = (BYTE)v;
+    p[1] = (BYTE)(v >> 8);
+    p[2] = (BYTE)(v >> 16);
+    p[3] = (BYTE)(v >> 24);
+}
+
+static unsigned int get16(const BYTE* p) {
+    return p[0] | (p[1] << 8);
+}
+
+static unsigned int get32(const BYTE* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned int)p[3] << 24);
+}
+
+static unsigned long long cluster_offset(const fat32_t* fs, unsigned int cluster) {
+    return fs->offset +
+           ((unsigned long long)fs->data_start +
+            (unsigned long long)(cluster - 2) * fs->sectors_per_cluster) * SECTOR;
+}
+
+// Date/heure DOS de l'instant présent
+static void dos_now(unsigned int* dos_date, unsigned int* dos_time) {
+    time_t     now = time(NULL);
+    struct tm* t   = localtime(&now);
+    *dos_date = (unsigned int)(((t->tm_year - 80) << 9) | ((t->tm_mon + 1) << 5) | t->tm_mday);
+    *dos_time = (unsigned int)((t->tm_hour << 11) | (t->tm_min << 5) | (t->tm_sec / 2));
+}
+
+// Zones à blanc, écrites par blocs de 1 Mo
+static int write_zeros(gpt_disk_t* disk, unsigned long long offset, unsigned long long length) {
+    const unsigned int chunk = 1024 * 1024;
+    BYTE* zero = calloc(1, chunk);
+    if (!zero) return -1;
+
+    int rc = 0;
+    while (rc == 0 && length > 0) {
+        unsigned int n = length < chunk ? (unsigned int)length : chunk;
+        rc = gpt_write(disk, offset, zero, n);
+        offset += n;
+        length -= n;
+    }
+    free(zero);
+    return rc;
+}
+
+// ── Formatage ─────────────────────────────────────────────────────────────
+
+// Taille de cluster par défaut de format.exe pour FAT32
+static unsigned int default_cluster_sectors(unsigned long long size) {
+    unsigned long long mb = size / (1024 * 1024);
+    if (mb <= 260)       return 1;
+    if (mb <= 8 * 1024)  return 8;
+    if (mb <= 16 * 1024) return 16;
+    if (mb <= 32 * 1024) return 32;
+    return 64;
+}
+
+int fat32_format(gpt_disk_t* disk, unsigned long long offset, unsigned long long size,
+                 const char* label, unsigned int hidden_sectors) {
+    unsigned long long total = size / SECTOR;
+    if (disk->sector_size != SECTOR) {
+        fprintf(stderr, "[Erreur] Secteurs de %u octets : formatage FAT32 non gere.\n",
+                disk->sector_size);
+        return -1;
+    }
+    if (total > 0xFFFFFFFFULL) {
+        fprintf(stderr, "[Erreur] Partition trop grande pour FAT32.\n");
+        return -1;
+    }
+
+    // Taille de la FAT : formule de la spécification Microsoft. Si le
+    // volume compte trop peu de clusters, on réduit leur taille.
+    unsigned int spc = default_cluster_sectors(size);
+    unsigned int fat_sectors, clusters;
+    for (;;) {
+        unsigned long long tmp1 = total - RESERVED_SECT;
+        unsigned long long tmp2 = (256ULL * spc + 2) / 2;
+        fat_sectors = (unsigned int)((tmp1 + tmp2 - 1) / tmp2);
+        clusters    = (unsigned int)((total - RESERVED_SECT - 2ULL * fat_sectors) / spc);
+        if (clusters >= MIN_CLUSTERS || spc == 1) break;
+        spc /= 2;
+    }
+    if (clusters < MIN_CLUSTERS) {
+        fprintf(stderr, "[Erreur] Partition trop petite pour FAT32 (%llu Mo).\n",
+                size / (1024 * 1024));
+        return -1;
+    }
+
+    BYTE boot[SECTOR] = {0};
+    boot[0] = 0xEB; boot[1] = 0x58; boot[2] = 0x90;
+    memcpy(boot + 3, "MSWIN4.1", 8);
+    put16(boot + 11, SECTOR);
+    boot[13] = (BYTE)spc;
+    put16(boot + 14, RESERVED_SECT);
+    boot[16] = 2;                                   // deux FAT
+    boot[21] = 0xF8;                                // disque fixe
+    put16(boot + 24, 63);
+    put16(boot + 26, 255);
+    put32(boot + 28, hidden_sectors);
+    put32(boot + 32, (unsigned int)total);
+    put32(boot + 36, fat_sectors);
+    put32(boot + 44, ROOT_CLUSTER);
+    put16(boot + 48, FSINFO_SECT);
+    put16(boot + 50, BACKUP_SECT);
+    boot[64] = 0x80;
+    boot[66] = 0x29;
+    put32(boot + 67, (unsigned int)time(NULL) ^ (unsigned int)(offset >> 9));
+
+    char vol[11];
+    memset(vol, ' ', sizeof(vol));
+    for (int i = 0; i < 11 && label[i]; i++) {
+        vol[i] = (label[i] >= 'a' && label[i] <= 'z') ? (char)(label[i] - 32) : label[i];
+    }
+    memcpy(boot + 71, vol, 11);
+    memcpy(boot + 82, "FAT32   ", 8);
+    boot[510] = 0x55;
+    boot[511] = 0xAA;
+
+    BYTE fsinfo[SECTOR] = {0};
+    put32(fsinfo, 0x41615252);
+    put32(fsinfo + 484, 0x61417272);
+    put32(fsinfo + 488, clusters - 1);              // la racine occupe un cluster
+    put32(fsinfo + 492, ROOT_CLUSTER + 1);
+    put32(fsinfo + 508, 0xAA550000);
+
+    unsigned long long data_start = RESERVED_SECT + 2ULL * fat_sectors;
+    if (write_zeros(disk, offset, RESERVED_SECT * SECTOR) != 0 ||
+        write_zeros(disk, offset + RESERVED_SECT * SECTOR, 2ULL * fat_sectors * SECTOR) != 0 ||
+        write_zeros(disk, offset + data_start * SECTOR, (unsigned long long)spc * SECTOR) != 0) {
+        return -1;
+    }
+
+    // Secteurs entiers : un disque physique refuse les écritures partielles
+    BYTE fat_head[SECTOR] = {0};
+    put32(fat_head, 0x0FFFFFF8);
+    put32(fat_head + 4, FAT_EOC);
+    put32(fat_head + 8, FAT_EOC);                   // racine
+
+    BYTE root_label[SECTOR] = {0};
+    memcpy(root_label, vol, 11);
+    root_label[11] = ATTR_VOLUME_ID;
+
+    int rc = 0;
+    for (int copy = 0; copy < 2 && rc == 0; copy++) {
+        unsigned long long base = offset + (copy ? BACKUP_SECT * SECTOR : 0);
+        rc = gpt_write(disk, base, boot, SECTOR);
+        if (rc == 0) rc = gpt_write(disk, base + FSINFO_SECT * SECTOR, fsinfo, SECTOR);
+        if (rc == 0) {
+            rc = gpt_write(disk, offset + (RESERVED_SECT + (unsigned long long)copy * fat_sectors) * SECTOR,
+                           fat_head, sizeof(fat_head));
+        }
+    }
+    if (rc == 0) rc = gpt_write(disk, offset + data_start * SECTOR, root_label, sizeof(root_label));
+    return rc;
+}
+
+// ── Ouverture ─────────────────────────────────────────────────────────────
+
+int fat32_open(fat32_t* fs, gpt_disk_t* disk, unsigned long long offset) {
+    BYTE boot[SECTOR];
+    memset(fs, 0, sizeof(*fs));
+    fs->disk = disk;
+    if (gpt_read(disk, offset, boot, SECTOR) != 0) return -1;
+
+    if (get16(boot + 11) != SECTOR || boot[13] == 0 || get16(boot + 22) != 0 ||
+        memcmp(boot + 82, "FAT32", 5) != 0 || boot[510] != 0x55 || boot[511] != 0xAA) {
+        fprintf(stderr, "[Erreur] Volume FAT32 invalide a l'offset %llu.\n", offset);
+        return -1;
+    }
+
+    fs->offset              = offset;
+    fs->sectors_per_cluster = boot[13];
+    fs->bytes_per_cluster   = fs->sectors_per_cluster * SECTOR;
+    fs->fat_start           = get16(boot + 14);
+    fs->fat_sectors         = get32(boot + 36);
+    fs->data_start          = fs->fat_start + boot[16] * fs->fat_sectors;
+    fs->cluster_count       = (get32(boot + 32) - fs->data_start) / fs->sectors_per_cluster;
+
+    // Les entrées au-delà du dernier cluster ne sont jamais lues
+    size_t fat_bytes = (size_t)fs->fat_sectors * SECTOR;
+    fs->fat = malloc(fat_bytes);
+    if (!fs->fat ||
+        gpt_read(disk, offset + (unsigned long long)fs->fat_start * SECTOR, fs->fat,
+                 (unsigned int)fat_bytes) != 0) {
+        free(fs->fat);
+        fs->fat = NULL;
+        return -1;
+    }
+
+    fs->next_free = 0;
+    for (unsigned int c = 2; c < fs->cluster_count + 2; c++) {
+        if ((fs->fat[c] & FAT_MASK) == 0) {
+            if (!fs->next_free) fs->next_free = c;
+            fs->free_count++;
+        }
+    }
+    if (!fs->next_free) fs->next_free = 2;
+    return 0;
+}
+
+int fat32_close(fat32_t* fs) {
+    int rc = 0;
+    if (fs->fat && fs->dirty) {
+        unsigned int fat_bytes = fs->fat_sectors * SECTOR;
+        for (int copy = 0; copy < 2 && rc == 0; copy++) {
+            rc = gpt_write(fs->disk, fs->offset +
+                           ((unsigned long long)fs->fat_start + (unsigned long long)copy * fs->fat_sectors) * SECTOR,
+                           fs->fat, fat_bytes);
+        }
+
+        BYTE fsinfo[SECTOR];
+        if (rc == 0 && gpt_read(fs->disk, fs->offset + FSINFO_SECT * SECTOR, fsinfo, SECTOR) == 0) {
+            put32(fsinfo + 488, fs->free_count);
+            put32(fsinfo + 492, fs->next_free);
+            rc = gpt_write(fs->disk, fs->offset + FSINFO_SECT * SECTOR, fsinfo, SECTOR);
+            if (rc == 0) rc = gpt_write(fs->disk, fs->offset + (BACKUP_SECT + FSINFO_SECT) * SECTOR, fsinfo, SECTOR);
+        }
+    }
+    free(fs->fat);
+    fs->fat = NULL;
+    return rc;
+}
+
+// ── Allocation ────────────────────────────────────────────────────────────
+
+static unsigned int fat_next(const fat32_t* fs, unsigned int cluster) {
+    return fs->fat[cluster] & FAT_MASK;
+}
+
+static int is_eoc(unsigned int value) {
+    return value >= 0x0FFFFFF8u || value < 2;
+}
+
+// Première plage libre de count clusters à partir de next_free (puis depuis
+// le début du volume). Retourne son premier cluster, 0 si aucune.
+static unsigned int find_run(const fat32_t* fs, unsigned int count) {
+    unsigned int end = fs->cluster_count + 2;
+    for (unsigned int pass = 0; pass < 2; pass++) {
+        unsigned int c   = pass ? 2 : fs->next_free;
+        unsigned int lim = pass ? fs->next_free + count : end;
+        unsigned int run = 0;
+        if (lim > end) lim = end;
+        for (; c < lim; c++) {
+            run = (fs->fat[c] & FAT_MASK) ? 0 : run + 1;
+            if (run == count) return c - count + 1;
+        }
+    }
+    return 0;
+}
+
+static void mark_used(fat32_t* fs, unsigned int count) {
+    unsigned int end = fs->cluster_count + 2;
+    fs->free_count -= count;
+    fs->dirty = 1;
+    while (fs->next_free < end && (fs->fat[fs->next_free] & FAT_MASK)) fs->next_free++;
+    if (fs->next_free >= end) fs->next_free = 2;
+}
+
+// Réserve count clusters chaînés, d'un seul tenant si possible.
+// Retourne le premier cluster, 0 si le volume est plein.
+static unsigned int alloc_chain(fat32_t* fs, unsigned int count) {
+    if (count == 0) return 0;
+    if (count > fs->free_count) {
+        fprintf(stderr, "[Erreur] Volume FAT32 plein.\n");
+        return 0;
+    }
+
+    unsigned int first = find_run(fs, count);
+    if (first) {
+        for (unsigned int i = 0; i < count; i++) {
+            fs->fat[first + i] = (i + 1 < count) ? first + i + 1 : FAT_EOC;
+        }
+    } else {
+        // Volume fragmenté : chaîne des clusters libres dans l'ordre
+        unsigned int prev = 0, got = 0;
+        for (unsigned int c = 2; c < fs->cluster_count + 2 && got < count; c++) {
+            if (fs->fat[c] & FAT_MASK) continue;
+            if (prev) fs->fat[prev] = c;
+            else first = c;
+            fs->fat[c] = FAT_EOC;
+            prev = c;
+            got++;
+        }
+    }
+
+    mark_used(fs, count);
+    return first;
+}
+
+// ── Noms ──────────────────────────────────────────────────────────────────
+
+// UTF-8 -> UTF-16 (plan multilingue de base). Retourne le nombre d'unités.
+static int utf8_to_utf16(const char* in, unsigned short* out, int max) {
+    const BYTE* p = (const BYTE*)in;
+    int n = 0;
+    while (*p && n < max) {
+        unsigned int c;
+        if (*p < 0x80) {
+            c = *p++;
+        } else if ((*p & 0xE0) == 0xC0 && p[1]) {
+            c = ((p[0] & 0x1F) << 6) | (p[1] & 0x3F);
+            p += 2;
+        } else if ((*p & 0xF0) == 0xE0 && p[1] && p[2]) {
+            c = ((p[0] & 0x0F) << 12) | ((p[1] & 0x3F) << 6) | (p[2] & 0x3F);
+            p += 3;
+        } else {
+            c = '_';
+            p++;
+        }
+        out[n++] = (unsigned short)c;
+    }
+    return n;
+}
+
+static void utf16_to_utf8(const unsigned short* in, int len, char* out, size_t max) {
+    size_t n = 0;
+    for (int i = 0; i < len && in[i]; i++) {
+        unsigned int c = in[i];
+        if (c < 0x80 && n + 1 < max) {
+            out[n++] = (char)c;
+        } else if (c < 0x800 && n + 2 < max) {
+            out[n++] = (char)(0xC0 | (c >> 6));
+            out[n++] = (char)(0x80 | (c & 0x3F));
+        } else if (c >= 0x800 && n + 3 < max) {
+            out[n++] = (char)(0xE0 | (c >> 12));
+            out[n++] = (char)(0x80 | ((c >> 6) & 0x3F));
+            out[n++] = (char)(0x80 | (c & 0x3F));
+        }
+    }
+    out[n] = '\0';
+}
+
+static int short_char_ok(char c) {
+    return (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || strchr("$%'-_@~`!(){}^#&", c);
+}
+
+// Base 8.3 du nom. Retourne 1 si le nom long doit être conservé à part
+// (casse, caractères remplacés, troncature).
+static int short_base(const char* name, char out[11], int* base_len) {
+    int lossy = 0;
+    memset(out, ' ', 11);
+
+    const char* dot = strrchr(name, '.');
+    if (dot == name) dot = NULL;
+    if (dot && strchr(name, '.') != dot) lossy = 1;
+
+    int n = 0;
+    for (const char* p = name; *p && p != dot; p++) {
+        char c = *p;
+        if (c == '.' || c == ' ') { lossy = 1; continue; }
+        if (c >= 'a' && c <= 'z') { c = (char)(c - 32); lossy = 1; }
+        if (!short_char_ok(c)) { c = '_'; lossy = 1; }
+        if (n < 8) out[n++] = c;
+        else lossy = 1;
+    }
+    if (n == 0) { out[0] = '_'; n = 1; lossy = 1; }
+    *base_len = n;
+
+    if (dot) {
+        int e = 0;
+        for (const char* p = dot + 1; *p; p++) {
+            char c = *p;
+            if (c == ' ') { lossy = 1; continue; }
+            if (c >= 'a' && c <= 'z') { c = (char)(c - 32); lossy = 1; }
+            if (!short_char_ok(c)) { c = '_'; lossy = 1; }
+            if (e < 3) out[8 + e++] = c;
+            else lossy = 1;
+        }
+    }
+    return lossy;
+}
+
+static BYTE lfn_checksum(const BYTE* short_name) {
+    BYTE sum = 0;
+    for (int i = 0; i < 11; i++) sum = (BYTE)(((sum & 1) << 7) + (sum >> 1) + short_name[i]);
+    return sum;
+}
+
+// ── Dossiers ──────────────────────────────────────────────────────────────
+// Un dossier est chargé en entier (chaîne de clusters + contenu), modifié
+// en mémoire puis réécrit cluster par cluster.
+
+typedef struct {
+    unsigned int  first;
+    unsigned int* clusters;
+    unsigned int  cluster_count;
+    BYTE*         data;
+    unsigned int  entries;
+} fat_dir_t;
+
+static void dir_free(fat_dir_t* d) {
+    free(d->clusters);
+    free(d->data);
+    memset(d, 0, sizeof(*d));
+}
+
+static int dir_load(fat32_t* fs, unsigned int first, fat_dir_t* d) {
+    memset(d, 0, sizeof(*d));
+    d->first = first;
+
+    unsigned int cap = 0;
+    for (unsigned int c = first; !is_eoc(c); c = fat_next(fs, c)) {
+        if (d->cluster_count * (fs->bytes_per_cluster / DIR_ENTRY) >= MAX_DIR_ENTRIES) break;
+        if (d->cluster_count == cap) {
+            cap = cap ? cap * 2 : 4;
+            unsigned int* grown = realloc(d->clusters, cap * sizeof(unsigned int));
+            BYTE* data = realloc(d->data, (size_t)cap * fs->bytes_per_cluster);
+            if (grown) d->clusters = grown;
+            if (data) d->data = data;
+            if (!grown || !data) {
+                dir_free(d);
+                return -1;
+            }
+        }
+        if (gpt_read(fs->disk, cluster_offset(fs, c),
+                     d->data + (size_t)d->cluster_count * fs->bytes_per_cluster,
+                     fs->bytes_per_cluster) != 0) {
+            dir_free(d);
+            return -1;
+        }
+        d->clusters[d->cluster_count++] = c;
+    }
+    d->entries = d->cluster_count * (fs->bytes_per_cluster / DIR_ENTRY);
+    return 0;
+}
+
+// Réécrit les clusters contenant les entrées [from, from + count)
+static int dir_store(fat32_t* fs, const fat_dir_t* d, unsigned int from, unsigned int count) {
+    unsigned int per = fs->bytes_per_cluster / DIR_ENTRY;
+    for (unsigned int i = from / per; i <= (from + count - 1) / per && i < d->cluster_count; i++) {
+        if (gpt_write(fs->disk, cluster_offset(fs, d->clusters[i]),
+                      d->data + (size_t)i * fs->bytes_per_cluster,
+                      fs->bytes_per_cluster) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Ajoute un cluster vierge au dossier
+static int dir_grow(fat32_t* fs, fat_dir_t* d) {
+    if (d->entries + fs->bytes_per_cluster / DIR_ENTRY > MAX_DIR_ENTRIES) {
+        fprintf(stderr, "[Erreur] Dossier FAT32 plein.\n");
+        return -1;
+    }
+    unsigned int c = alloc_chain(fs, 1);
+    if (!c) return -1;
+
+    unsigned int* grown = realloc(d->clusters, (d->cluster_count + 1) * sizeof(unsigned int));
+    BYTE* data = realloc(d->data, (size_t)(d->cluster_count + 1) * fs->bytes_per_cluster);
+    if (grown) d->clusters = grown;
+    if (data) d->data = data;
+    if (!grown || !data) return -1;
+
+    memset(d->data + (size_t)d->cluster_count * fs->bytes_per_cluster, 0, fs->bytes_per_cluster);
+    fs->fat[d->clusters[d->cluster_count - 1]] = c;
+    d->clusters[d->cluster_count++] = c;
+    d->entries += fs->bytes_per_cluster / DIR_ENTRY;
+
+    return gpt_write(fs->disk, cluster_offset(fs, c),
+                     d->data + (size_t)(d->cluster_count - 1) * fs->bytes_per_cluster,
+                     fs->bytes_per_cluster);
+}
+
+// Cherche name (nom long ou 8.3, casse ignorée). Retourne l'indice de
+// l'entrée courte, -1 si absent.
+static int dir_lookup(const fat_dir_t* d, const char* name) {
+    unsigned short lfn[260];
+    int            lfn_valid = 0;
+
+    for (unsigned int i = 0; i < d->entries; i++) {
+        const BYTE* e = d->data + (size_t)i * DIR_ENTRY;
+        if (e[0] == 0x00) break;
+        if (e[0] == 0xE5) { lfn_valid = 0; continue; }
+
+        if (e[11] == ATTR_LFN) {
+            int ord = e[0] & 0x1F;
+            if (e[0] & 0x40) {
+                memset(lfn, 0, sizeof(lfn));
+                lfn_valid = 1;
+            }
+            if (ord < 1 || ord > 20) { lfn_valid = 0; continue; }
+            unsigned short* dst = lfn + (ord - 1) * 13;
+            for (int k = 0; k < 5; k++) dst[k]      = (unsigned short)get16(e + 1 + 2 * k);
+            for (int k = 0; k < 6; k++) dst[5 + k]  = (unsigned short)get16(e + 14 + 2 * k);
+            for (int k = 0; k < 2; k++) dst[11 + k] = (unsigned short)get16(e + 28 + 2 * k);
+            continue;
+        }
+        if (e[11] & ATTR_VOLUME_ID) { lfn_valid = 0; continue; }
+
+        char candidate[MAX_PATH];
+        if (lfn_valid) {
+            for (int k = 0; k < 260; k++) if (lfn[k] == 0xFFFF) lfn[k] = 0;
+            utf16_to_utf8(lfn, 260, candidate, sizeof(candidate));
+            if (_stricmp(candidate, name) == 0) return (int)i;
+        }
+        lfn_valid = 0;
+
+        int n = 0;
+        for (int k = 0; k < 8 && e[k] != ' '; k++) candidate[n++] = (char)e[k];
+        if (e[8] != ' ') {
+            candidate[n++] = '.';
+            for (int k = 8; k < 11 && e[k] != ' '; k++) candidate[n++] = (char)e[k];
+        }
+        candidate[n] = '\0';
+        if (_stricmp(candidate, name) == 0) return (int)i;
+    }
+    return -1;
+}
+
+static int short_exists(const fat_dir_t* d, const char short_name[11]) {
+    for (unsigned int i = 0; i < d->entries; i++) {
+        const BYTE* e = d->data + (size_t)i * DIR_ENTRY;
+        if (e[0] == 0x00) break;
+        if (e[0] != 0xE5 && e[11] != ATTR_LFN && memcmp(e, short_name, 11) == 0) return 1;
+    }
+    return 0;
+}
+
+static void fill_short(BYTE* e, const char short_name[11], BYTE attr,
+                       unsigned int cluster, unsigned int size) {
+    unsigned int dos_date, dos_time;
+    dos_now(&dos_date, &dos_time);
+    memset(e, 0, DIR_ENTRY);
+    memcpy(e, short_name, 11);
+    e[11] = attr;
+    put16(e + 14, dos_time);
+    put16(e + 16, dos_date);
+    put16(e + 18, dos_date);
+    put16(e + 20, cluster >> 16);
+    put16(e + 22, dos_time);
+    put16(e + 24, dos_date);
+    put16(e + 26, cluster & 0xFFFF);
+    put32(e + 28, size);
+}
+
+// Inscrit name dans le dossier en mémoire (entrées LFN si besoin + entrée
+// 8.3). slot/count reçoivent les entrées à réécrire.
+static int dir_insert(fat32_t* fs, fat_dir_t* d, const char* name, BYTE attr,
+                      unsigned int cluster, unsigned int size,
+                      unsigned int* out_slot, unsigned int* out_count) {
+    char short_name[11];
+    int  base_len;
+    int  need_lfn = short_base(name, short_name, &base_len);
+
+    if (need_lfn || short_exists(d, short_name)) {
+        need_lfn = 1;
+        // Suffixe ~N : la base est raccourcie pour laisser la place au numéro
+        char tail[8];
+        for (unsigned int n = 1; n < 1000000; n++) {
+            int tail_len = snprintf(tail, sizeof(tail), "~%u", n);
+            int keep = base_len < 8 - tail_len ? base_len : 8 - tail_len;
+            char candidate[11];
+            memcpy(candidate, short_name, 11);
+            memset(candidate + keep, ' ', 8 - keep);
+            memcpy(candidate + keep, tail, tail_len);
+            if (!short_exists(d, candidate)) {
+                memcpy(short_name, candidate, 11);
+                break;
+            }
+        }
+    }
+
+    unsigned short lfn[260];
+    int lfn_len = 0, lfn_entries = 0;
+    if (need_lfn) {
+        lfn_len     = utf8_to_utf16(name, lfn, 255);
+        lfn_entries = (lfn_len + 12) / 13;
+    }
+    unsigned int needed = (unsigned int)lfn_entries + 1;
+
+    // Première suite d'entrées libres assez longue, sinon on agrandit
+    int slot = -1;
+    for (;;) {
+        unsigned int run = 0;
+        for (unsigned int i = 0; i < d->entries; i++) {
+            BYTE first = d->data[(size_t)i * DIR_ENTRY];
+            run = (first == 0x00 || first == 0xE5) ? run + 1 : 0;
+            if (run == needed) {
+                slot = (int)(i - needed + 1);
+                break;
+            }
+        }
+        if (slot >= 0) break;
+        if (dir_grow(fs, d) != 0) return -1;
+    }
+
+    BYTE* e = d->data + (size_t)slot * DIR_ENTRY;
+    BYTE  sum = lfn_checksum((const BYTE*)short_name);
+    for (int k = 0; k < lfn_entries; k++) {
+        int   ord  = lfn_entries - k;
+        BYTE* le   = e + (size_t)k * DIR_ENTRY;
+        memset(le, 0, DIR_ENTRY);
+        le[0]  = (BYTE)(ord | (k == 0 ? 0x40 : 0));
+        le[11] = ATTR_LFN;
+        le[13] = sum;
+        static const int pos[13] = {1, 3, 5, 7, 9, 14, 16, 18, 20, 22, 24, 28, 30};
+        for (int j = 0; j < 13; j++) {
+            int idx = (ord - 1) * 13 + j;
+            unsigned int ch = idx < lfn_len ? lfn[idx] : (idx == lfn_len ? 0x0000 : 0xFFFF);
+            put16(le + pos[j], ch);
+        }
+    }
+    fill_short(e + (size_t)lfn_entries * DIR_ENTRY, short_name, attr, cluster, size);
+
+    *out_slot  = (unsigned int)slot;
+    *out_count = needed;
+    return 0;
+}
+
+static int dir_add(fat32_t* fs, fat_dir_t* d, const char* name, BYTE attr,
+                   unsigned int cluster, unsigned int size) {
+    unsigned int slot, count;
+    if (dir_insert(fs, d, name, attr, cluster, size, &slot, &count) != 0) return -1;
+    return dir_store(fs, d, slot, count);
+}
+
+// Résout le dossier parent de path. leaf reçoit le dernier composant.
+// Retourne le premier cluster du parent, 0 en erreur.
+static unsigned int resolve_parent(fat32_t* fs, const char* path, char* leaf, size_t leaf_size) {
+    char buf[MAX_PATH];
+    if (copy_string(buf, sizeof(buf), path) != 0) return 0;
+
+    // Même parent que l'appel précédent : les dossiers ne bougent jamais
+    char* last = buf + strlen(buf);
+    while (last > buf && last[-1] != '\\' && last[-1] != '/') last--;
+    size_t parent_len = (size_t)(last - buf);
+    if (fs->parent_cluster && *last && parent_len == strlen(fs->parent_path) &&
+        strncmp(buf, fs->parent_path, parent_len) == 0) {
+        return copy_string(leaf, leaf_size, last) == 0 ? fs->parent_cluster : 0;
+    }
+
+    unsigned int dir  = ROOT_CLUSTER;
+    char*        comp = buf;
+    for (;;) {
+        while (*comp == '\\' || *comp == '/') comp++;
+        char* sep = comp + strcspn(comp, "\\/");
+        if (*sep == '\0' || sep[1 + strspn(sep + 1, "\\/")] == '\0') {
+            *sep = '\0';
+            break;
+        }
+        *sep = '\0';
+
+        fat_dir_t d;
+        if (dir_load(fs, dir, &d) != 0) return 0;
+        int i = dir_lookup(&d, comp);
+        const BYTE* e = i >= 0 ? d.data + (size_t)i * DIR_ENTRY : NULL;
+        unsigned int next = e ? (get16(e + 20) << 16) | get16(e + 26) : 0;
+        int is_dir = e && (e[11] & ATTR_DIRECTORY);
+        dir_free(&d);
+
+        if (!is_dir) return 0;
+        dir  = next ? next : ROOT_CLUSTER;
+        comp = sep + 1;
+    }
+
+    if (*comp == '\0' || copy_string(leaf, leaf_size, comp) != 0) return 0;
+
+    if (*last && parent_len < sizeof(fs->parent_path)) {
+        memcpy(fs->parent_path, path, parent_len);
+        fs->parent_path[parent_len] = '\0';
+        fs->parent_cluster = dir;
+    }
+    return dir;
+}
+
+// ── API ───────────────────────────────────────────────────────────────────
+
+int fat32_find(fat32_t* fs, const char* path, int* is_dir, unsigned long long* size) {
+    char leaf[MAX_PATH];
+    unsigned int parent = resolve_parent(fs, path, leaf, sizeof(leaf));
+    if (!parent) return -1;
+
+    fat_dir_t d;
+    if (dir_load(fs, parent, &d) != 0) return -1;
+    int i = dir_lookup(&d, leaf);
+    if (i >= 0) {
+        const BYTE* e = d.data + (size_t)i * DIR_ENTRY;
+        if (is_dir) *is_dir = (e[11] & ATTR_DIRECTORY) != 0;
+        if (size) *size = get32(e + 28);
+    }
+    dir_free(&d);
+    return i >= 0 ? 0 : -1;
+}
+
+int fat32_mkdir(fat32_t* fs, const char* path) {
+    char leaf[MAX_PATH];
+    unsigned int parent = resolve_parent(fs, path, leaf, sizeof(leaf));
+    if (!parent) {
+        fprintf(stderr, "[Erreur] Dossier parent introuvable : %s\n", path);
+        return -1;
+    }
+
+    fat_dir_t d;
+    if (dir_load(fs, parent, &d) != 0) return -1;
+
+    int i = dir_lookup(&d, leaf);
+    if (i >= 0) {
+        int is_dir = (d.data[(size_t)i * DIR_ENTRY + 11] & ATTR_DIRECTORY) != 0;
+        dir_free(&d);
+        return is_dir ? 0 : -1;
+    }
+
+    unsigned int c = alloc_chain(fs, 1);
+    if (!c) {
+        dir_free(&d);
+        return -1;
+    }
+
+    // Contenu initial : "." et ".." (0 désigne la racine)
+    BYTE* block = calloc(1, fs->bytes_per_cluster);
+    int   rc    = -1;
+    if (block) {
+        char dot[11], dotdot[11];
+        memset(dot, ' ', 11);
+        memset(dotdot, ' ', 11);
+        dot[0] = '.';
+        dotdot[0] = dotdot[1] = '.';
+        fill_short(block, dot, ATTR_DIRECTORY, c, 0);
+        fill_short(block + DIR_ENTRY, dotdot, ATTR_DIRECTORY,
+                   parent == ROOT_CLUSTER ? 0 : parent, 0);
+        rc = gpt_write(fs->disk, cluster_offset(fs, c), block, fs->bytes_per_cluster);
+        free(block);
+    }
+    if (rc == 0) rc = dir_add(fs, &d, leaf, ATTR_DIRECTORY, c, 0);
+    dir_free(&d);
+    return rc;
+}
+
+int fat32_create(fat32_t* fs, const char* path, unsigned long long size, fat32_file_t* file) {
+    memset(file, 0, sizeof(*file));
+    if (size > 0xFFFFFFFFULL) {
+        fprintf(stderr, "[Erreur] Fichier trop grand pour FAT32 (4 Go max) : %s\n", path);
+        return -1;
+    }
+
+    char leaf[MAX_PATH];
+    unsigned int parent = resolve_parent(fs, path, leaf, sizeof(leaf));
+    if (!parent) {
+        fprintf(stderr, "[Erreur] Dossier parent introuvable : %s\n", path);
+        return -1;
+    }
+
+    fat_dir_t d;
+    if (dir_load(fs, parent, &d) != 0) return -1;
+    if (dir_lookup(&d, leaf) >= 0) {
+        fprintf(stderr, "[Erreur] Le fichier existe deja : %s\n", path);
+        dir_free(&d);
+        return -1;
+    }
+
+    unsigned int clusters = (unsigned int)((size + fs->bytes_per_cluster - 1) / fs->bytes_per_cluster);
+    unsigned int first    = alloc_chain(fs, clusters);
+    if (clusters && !first) {
+        dir_free(&d);
+        return -1;
+    }
+
+    int rc = dir_add(fs, &d, leaf, ATTR_ARCHIVE, first, (unsigned int)size);
+    dir_free(&d);
+    if (rc != 0) return -1;
+
+    file->first_cluster = first;
+    file->cluster       = first;
+    file->size          = size;
+    return 0;
+}
+
+int fat32_write(fat32_t* fs, fat32_file_t* file, const void* data, unsigned int len) {
+    const BYTE* p = data;
+    if (file->written + len > file->size) {
+        fprintf(stderr, "[Erreur] Ecriture au-dela de la taille annoncee.\n");
+        return -1;
+    }
+
+    while (len > 0) {
+        unsigned int in_cluster = (unsigned int)(file->written % fs->bytes_per_cluster);
+        unsigned long long room = fs->bytes_per_cluster - in_cluster;
+
+        // Étend la plage tant que les clusters suivants sont contigus
+        unsigned int last = file->cluster;
+        while (room < len && fat_next(fs, last) == last + 1) {
+            last++;
+            room += fs->bytes_per_cluster;
+        }
+
+        unsigned int n = room < len ? (unsigned int)room : len;
+        if (gpt_write(fs->disk, cluster_offset(fs, file->cluster) + in_cluster, p, n) != 0) return -1;
+
+        p             += n;
+        len           -= n;
+        file->written += n;
+
+        // Avance jusqu'au cluster qui contient la prochaine position
+        unsigned int end = in_cluster + n;
+        while (end >= fs->bytes_per_cluster && !is_eoc(file->cluster)) {
+            file->cluster = fat_next(fs, file->cluster);
+            end -= fs->bytes_per_cluster;
+        }
+    }
+    return 0;
+}
+
+int fat32_close_file(fat32_t* fs, fat32_file_t* file) {
+    (void)fs;
+    if (file->written != file->size) {
+        fprintf(stderr, "[Attention] Fichier incomplet (%llu/%llu octets).\n",
+                file->written, file->size);
+        return -1;
+    }
+    return 0;
+}
+
+// ── Écriture groupée ──────────────────────────────────────────────────────
+
+int fat32_write_batch(fat32_t* fs, const fat32_item_t* items, int count) {
+    unsigned long long total = 0;
+    for (int i = 0; i < count; i++) {
+        if (items[i].size > 0xFFFFFFFFULL) return 1;
+        total += (items[i].size + fs->bytes_per_cluster - 1) / fs->bytes_per_cluster;
+    }
+    if (total > fs->free_count || total * fs->bytes_per_cluster > 0xFFFFFFFFULL) return 1;
+
+    unsigned int clusters = (unsigned int)total;
+    unsigned int first    = clusters ? find_run(fs, clusters) : 0;
+    if (clusters && !first) return 1;
+
+    // Données du lot à leur place dans la plage, en une écriture
+    BYTE* run = clusters ? calloc(clusters, fs->bytes_per_cluster) : NULL;
+    if (clusters && !run) return 1;
+
+    unsigned int next = first;
+    unsigned int* starts = malloc((size_t)count * sizeof(unsigned int));
+    if (!starts) {
+        free(run);
+        return 1;
+    }
+    for (int i = 0; i < count; i++) {
+        unsigned int n = (unsigned int)((items[i].size + fs->bytes_per_cluster - 1) /
+                                        fs->bytes_per_cluster);
+        starts[i] = n ? next : 0;
+        if (n) {
+            memcpy(run + (size_t)(next - first) * fs->bytes_per_cluster,
+                   items[i].data, (size_t)items[i].size);
+            for (unsigned int k = 0; k < n; k++) {
+                fs->fat[next + k] = (k + 1 < n) ? next + k + 1 : FAT_EOC;
+            }
+        }
+        next += n;
+    }
+    if (clusters) mark_used(fs, clusters);
+
+    int rc = 0;
+    if (clusters) {
+        rc = gpt_write(fs->disk, cluster_offset(fs, first), run, clusters * fs->bytes_per_cluster);
+    }
+    free(run);
+
+    // Entrées de dossier : chaque dossier est chargé une fois, complété en
+    // mémoire et réécrit d'un bloc quand le lot passe au dossier suivant.
+    fat_dir_t    d;
+    unsigned int dir_cluster = 0;
+    unsigned int dirty_from  = 0, dirty_to = 0;
+    memset(&d, 0, sizeof(d));
+
+    for (int i = 0; rc == 0 && i < count; i++) {
+        char leaf[MAX_PATH];
+        unsigned int parent = resolve_parent(fs, items[i].path, leaf, sizeof(leaf));
+        if (!parent) {
+            fprintf(stderr, "[Erreur] Dossier parent introuvable : %s\n", items[i].path);
+            rc = -1;
+            break;
+        }
+
+        if (parent != dir_cluster) {
+            if (dir_cluster && dirty_to > dirty_from) {
+                rc = dir_store(fs, &d, dirty_from, dirty_to - dirty_from);
+            }
+            dir_free(&d);
+            dir_cluster = 0;
+            if (rc != 0 || dir_load(fs, parent, &d) != 0) {
+                rc = -1;
+                break;
+            }
+            dir_cluster = parent;
+            dirty_from  = d.entries;
+            dirty_to    = 0;
+        }
+
+        if (dir_lookup(&d, leaf) >= 0) {
+            fprintf(stderr, "[Erreur] Le fichier existe deja : %s\n", items[i].path);
+            rc = -1;
+            break;
+        }
+
+        unsigned int slot, n;
+        rc = dir_insert(fs, &d, leaf, ATTR_ARCHIVE, starts[i], (unsigned int)items[i].size,
+                        &slot, &n);
+        if (rc == 0) {
+            if (slot < dirty_from) dirty_from = slot;
+            if (slot + n > dirty_to) dirty_to = slot + n;
+        }
+    }
+    if (rc == 0 && dir_cluster && dirty_to > dirty_from) {
+        rc = dir_store(fs, &d, dirty_from, dirty_to - dirty_from);
+    }
+    dir_free(&d);
+    free(starts);
+    return rc;
+}
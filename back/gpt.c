@@ -0,0 +1,473 @@
+// gpt.c
+#include "header/gpt.h"
+#include "header/compat.h"
+#include "header/utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ENTRIES_BYTES (GPT_ENTRY_COUNT * GPT_ENTRY_SIZE)
+
+// C12A7328-F81F-11D2-BA4B-00A0C93EC93B
+const BYTE GPT_TYPE_ESP[16] = {
+    0x28, 0x73, 0x2A, 0xC1, 0x1F, 0xF8, 0xD2, 0x11,
+    0xBA, 0x4B, 0x00, 0xA0, 0xC9, 0x3E, 0xC9, 0x3B
+};
+
+// EBD0A0A2-B9E5-4433-87C0-68B6B72699C7 (données de base Windows)
+const BYTE GPT_TYPE_BASIC_DATA[16] = {
+    0xA2, 0xA0, 0xD0, 0xEB, 0xE5, 0xB9, 0x33, 0x44,
+    0x87, 0xC0, 0x68, 0xB6, 0xB7, 0x26, 0x99, 0xC7
+};
+
+// ── CRC32 ─────────────────────────────────────────────────────────────────
+// Polynôme réfléchi 0xEDB88320. La table est calculée par le compilateur :
+// chaque case applique les 8 décalages du calcul bit à bit.
+
+#define CRC_STEP(c)  (((c) >> 1) ^ (0xEDB88320u & (0u - ((c) & 1u))))
+#define CRC_CELL(n)  CRC_STEP(CRC_STEP(CRC_STEP(CRC_STEP( \
+                     CRC_STEP(CRC_STEP(CRC_STEP(CRC_STEP((unsigned int)(n)))))))))
+#define CRC_ROW(n)   CRC_CELL(n),     CRC_CELL(n + 1), CRC_CELL(n + 2), CRC_CELL(n + 3), \
+                     CRC_CELL(n + 4), CRC_CELL(n + 5), CRC_CELL(n + 6), CRC_CELL(n + 7)
+#define CRC_ROWS(n)  CRC_ROW(n),      CRC_ROW(n + 8),  CRC_ROW(n + 16), CRC_ROW(n + 24)
+
+static const unsigned int crc_table[256] = {
+    CRC_ROWS(0),   CRC_ROWS(32),  CRC_ROWS(64),  CRC_ROWS(96),
+    CRC_ROWS(128), CRC_ROWS(160), CRC_ROWS(192), CRC_ROWS(224)
+};
+
+unsigned int gpt_crc32(const void* data, size_t len) {
+    const BYTE*  p   = data;
+    unsigned int crc = 0xFFFFFFFFu;
+    while (len--) crc = crc_table[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+// ── Accès au disque ───────────────────────────────────────────────────────
+
+static int disk_io(gpt_disk_t* disk, int write, unsigned long long offset,
+                   void* buffer, unsigned int size) {
+    EnterCriticalSection(&disk->lock);
+    LARGE_INTEGER pos;
+    DWORD         n = 0;
+    BOOL          ok;
+    pos.QuadPart = (LONGLONG)offset;
+    ok = SetFilePointerEx(disk->handle, pos, NULL, FILE_BEGIN);
+    if (ok) {
+        ok = write ? WriteFile(disk->handle, buffer, size, &n, NULL)
+                   : ReadFile(disk->handle, buffer, size, &n, NULL);
+    }
+    LeaveCriticalSection(&disk->lock);
+
+    if (!ok || n != size) {
+        fprintf(stderr, "[Erreur] %s de %s echouee (offset %llu, code %lu).\n",
+                write ? "Ecriture" : "Lecture", disk->name, offset, GetLastError());
+        return -1;
+    }
+    return 0;
+}
+
+// Un disque physique n'accepte que des secteurs entiers : une requête qui
+// commence ou finit en cours de secteur (fin d'un fichier FAT32) passe par
+// les secteurs qui l'encadrent, relus avant écriture.
+static int disk_io_partial(gpt_disk_t* disk, int write, unsigned long long offset,
+                           void* buffer, unsigned int size) {
+    unsigned int       ss    = disk->sector_size;
+    unsigned long long start = offset / ss * ss;
+    unsigned long long end   = (offset + size + ss - 1) / ss * ss;
+    unsigned int       span  = (unsigned int)(end - start);
+    BYTE*              bounce = malloc(span);
+    if (!bounce) return -1;
+
+    int rc = 0;
+    if (!write) {
+        rc = disk_io(disk, 0, start, bounce, span);
+        if (rc == 0) memcpy(buffer, bounce + (offset - start), size);
+    } else {
+        if (offset != start) rc = disk_io(disk, 0, start, bounce, ss);
+        if (rc == 0 && offset + size != end && (span > ss || offset == start)) {
+            rc = disk_io(disk, 0, end - ss, bounce + span - ss, ss);
+        }
+        if (rc == 0) {
+            memcpy(bounce + (offset - start), buffer, size);
+            rc = disk_io(disk, 1, start, bounce, span);
+        }
+    }
+    free(bounce);
+    return rc;
+}
+
+int gpt_read(gpt_disk_t* disk, unsigned long long offset, void* buffer, unsigned int size) {
+    if (disk->physical && (offset % disk->sector_size || size % disk->sector_size)) {
+        return disk_io_partial(disk, 0, offset, buffer, size);
+    }
+    return disk_io(disk, 0, offset, buffer, size);
+}
+
+int gpt_write(gpt_disk_t* disk, unsigned long long offset, const void* buffer, unsigned int size) {
+    if (disk->physical && (offset % disk->sector_size || size % disk->sector_size)) {
+        return disk_io_partial(disk, 1, offset, (void*)buffer, size);
+    }
+    return disk_io(disk, 1, offset, (void*)buffer, size);
+}
+
+int gpt_flush(gpt_disk_t* disk) {
+    EnterCriticalSection(&disk->lock);
+    BOOL ok = FlushFileBuffers(disk->handle);
+    LeaveCriticalSection(&disk->lock);
+    return ok ? 0 : -1;
+}
+
+int gpt_open_image(gpt_disk_t* disk, const char* path, int create, unsigned long long size) {
+    memset(disk, 0, sizeof(*disk));
+    HANDLE h = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL,
+                           create ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (h == INVALID_HANDLE_VALUE) {
+        fprintf(stderr, "[Erreur] Impossible d'ouvrir le disque virtuel %s (code %lu).\n",
+                path, GetLastError());
+        return -1;
+    }
+
+    LARGE_INTEGER li;
+    if (create) {
+        li.QuadPart = (LONGLONG)size;
+        if (!SetFilePointerEx(h, li, NULL, FILE_BEGIN) || !SetEndOfFile(h)) {
+            fprintf(stderr, "[Erreur] Impossible de dimensionner %s (code %lu).\n",
+                    path, GetLastError());
+            CloseHandle(h);
+            return -1;
+        }
+    }
+    li.QuadPart = 0;
+    GetFileSizeEx(h, &li);
+
+    disk->handle      = h;
+    disk->sector_size = 512;
+    disk->sectors     = (unsigned long long)li.QuadPart / disk->sector_size;
+    copy_string(disk->name, sizeof(disk->name), path);   // messages seulement
+    InitializeCriticalSection(&disk->lock);
+    return 0;
+}
+
+#ifdef _WIN32
+
+int gpt_open_disk(gpt_disk_t* disk, unsigned long number) {
+    memset(disk, 0, sizeof(*disk));
+    snprintf(disk->name, sizeof(disk->name), "\\\\.\\PhysicalDrive%lu", number);
+
+    HANDLE h = CreateFileA(disk->name, GENERIC_READ | GENERIC_WRITE,
+                           FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, 0, NULL);
+    if (h == INVALID_HANDLE_VALUE) {
+        fprintf(stderr, "[Erreur] Impossible d'ouvrir %s (code %lu).\n",
+                disk->name, GetLastError());
+        return -1;
+    }
+
+    DISK_GEOMETRY_EX geometry;
+    DWORD            returned;
+    if (!DeviceIoControl(h, IOCTL_DISK_GET_DRIVE_GEOMETRY_EX, NULL, 0,
+                         &geometry, sizeof(geometry), &returned, NULL) ||
+        geometry.Geometry.BytesPerSector == 0 ||
+        geometry.Geometry.BytesPerSector > GPT_MAX_SECTOR) {
+        fprintf(stderr, "[Erreur] Geometrie de %s illisible (code %lu).\n",
+                disk->name, GetLastError());
+        CloseHandle(h);
+        return -1;
+    }
+
+    disk->handle      = h;
+    disk->physical    = 1;
+    disk->number      = number;
+    disk->sector_size = geometry.Geometry.BytesPerSector;
+    disk->sectors     = (unsigned long long)geometry.DiskSize.QuadPart / disk->sector_size;
+    InitializeCriticalSection(&disk->lock);
+    return 0;
+}
+
+int gpt_open_system_disk(gpt_disk_t* disk) {
+    char windows_dir[MAX_PATH];
+    char volume[8];
+    if (!GetSystemWindowsDirectoryA(windows_dir, sizeof(windows_dir))) return -1;
+    snprintf(volume, sizeof(volume), "\\\\.\\%c:", windows_dir[0]);
+
+    HANDLE h = CreateFileA(volume, 0, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                           OPEN_EXISTING, 0, NULL);
+    STORAGE_DEVICE_NUMBER device;
+    DWORD                 returned;
+    BOOL ok = h != INVALID_HANDLE_VALUE &&
+              DeviceIoControl(h, IOCTL_STORAGE_GET_DEVICE_NUMBER, NULL, 0,
+                              &device, sizeof(device), &returned, NULL);
+    if (h != INVALID_HANDLE_VALUE) CloseHandle(h);
+    if (!ok) {
+        fprintf(stderr, "[Erreur] Disque du volume systeme %c: introuvable (code %lu).\n",
+                windows_dir[0], GetLastError());
+        return -1;
+    }
+    return gpt_open_disk(disk, device.DeviceNumber);
+}
+
+int gpt_rescan(gpt_disk_t* disk) {
+    if (!disk->physical) return 0;
+    DWORD returned;
+    if (!DeviceIoControl(disk->handle, IOCTL_DISK_UPDATE_PROPERTIES, NULL, 0,
+                         NULL, 0, &returned, NULL)) {
+        fprintf(stderr, "[Attention] Relecture de la table de %s refusee (code %lu).\n",
+                disk->name, GetLastError());
+        return -1;
+    }
+    return 0;
+}
+
+#else
+
+int gpt_open_disk(gpt_disk_t* disk, unsigned long number) {
+    (void)disk;
+    fprintf(stderr, "[Erreur] Disque physique %lu : utiliser --image hors Windows.\n", number);
+    return -1;
+}
+
+int gpt_open_system_disk(gpt_disk_t* disk) {
+    return gpt_open_disk(disk, 0);
+}
+
+int gpt_rescan(gpt_disk_t* disk) {
+    (void)disk;
+    return 0;
+}
+
+#endif
+
+void gpt_close(gpt_disk_t* disk) {
+    if (!disk->handle || disk->handle == INVALID_HANDLE_VALUE) return;
+    CloseHandle(disk->handle);
+    DeleteCriticalSection(&disk->lock);
+    disk->handle = INVALID_HANDLE_VALUE;
+}
+
+// ── Table ─────────────────────────────────────────────────────────────────
+
+// GUID aléatoire (version 4) : ces identifiants nomment des partitions du
+// disque système, ils viennent du générateur cryptographique du système.
+static int random_guid(BYTE out[16]) {
+    if (!BCRYPT_SUCCESS(BCryptGenRandom(NULL, out, 16, BCRYPT_USE_SYSTEM_PREFERRED_RNG))) {
+        fprintf(stderr, "[Erreur] Generateur aleatoire du systeme indisponible.\n");
+        return -1;
+    }
+    out[7] = (BYTE)((out[7] & 0x0F) | 0x40);   // version 4 (octet fort de Data3)
+    out[8] = (BYTE)((out[8] & 0x3F) | 0x80);   // variante RFC 4122
+    return 0;
+}
+
+static unsigned long long entries_sectors(const gpt_disk_t* disk) {
+    return (ENTRIES_BYTES + disk->sector_size - 1) / disk->sector_size;
+}
+
+int gpt_entry_used(const gpt_entry_t* entry) {
+    static const BYTE zero[16] = {0};
+    return memcmp(entry->type, zero, 16) != 0;
+}
+
+void gpt_entry_name(const gpt_entry_t* entry, char* out, size_t size) {
+    size_t n = 0;
+    while (n + 1 < size && n < 36 && entry->name[n]) {
+        out[n] = entry->name[n] < 0x80 ? (char)entry->name[n] : '?';
+        n++;
+    }
+    out[n] = '\0';
+}
+
+// Lit et vérifie une copie (en-tête à lba + son tableau d'entrées)
+static int read_copy(gpt_disk_t* disk, unsigned long long lba, gpt_header_t* hdr,
+                     gpt_entry_t* entries) {
+    BYTE sector[GPT_MAX_SECTOR];
+    if (lba == 0 || lba >= disk->sectors ||
+        gpt_read(disk, lba * disk->sector_size, sector, disk->sector_size) != 0) {
+        return -1;
+    }
+    memcpy(hdr, sector, sizeof(*hdr));
+    if (memcmp(hdr->signature, "EFI PART", 8) != 0 ||
+        hdr->header_size < GPT_HEADER_SIZE || hdr->header_size > disk->sector_size ||
+        hdr->current_lba != lba) {
+        return -1;
+    }
+
+    unsigned int crc = hdr->header_crc;
+    ((gpt_header_t*)sector)->header_crc = 0;
+    if (gpt_crc32(sector, hdr->header_size) != crc) return -1;
+
+    // Windows et les outils courants écrivent toujours 128 entrées de 128 octets
+    if (hdr->entry_count != GPT_ENTRY_COUNT || hdr->entry_size != GPT_ENTRY_SIZE) return -1;
+    if (gpt_read(disk, hdr->entries_lba * disk->sector_size, entries, ENTRIES_BYTES) != 0) {
+        return -1;
+    }
+    return gpt_crc32(entries, ENTRIES_BYTES) == hdr->entries_crc ? 0 : -1;
+}
+
+int gpt_init(gpt_table_t* table, gpt_disk_t* disk) {
+    memset(table, 0, sizeof(*table));
+    table->disk = disk;
+
+    gpt_header_t* hdr = &table->header;
+    memcpy(hdr->signature, "EFI PART", 8);
+    hdr->revision     = 0x00010000;
+    hdr->header_size  = GPT_HEADER_SIZE;
+    hdr->current_lba  = 1;
+    hdr->backup_lba   = disk->sectors - 1;
+    hdr->entries_lba  = 2;
+    hdr->first_usable = 2 + entries_sectors(disk);
+    hdr->last_usable  = disk->sectors - 2 - entries_sectors(disk);
+    hdr->entry_count  = GPT_ENTRY_COUNT;
+    hdr->entry_size   = GPT_ENTRY_SIZE;
+    if (random_guid(hdr->disk_guid) != 0) return -1;
+
+    // MBR de protection : une seule partition 0xEE couvrant le disque
+    BYTE mbr[GPT_MAX_SECTOR] = {0};
+    unsigned long long mbr_sectors = disk->sectors - 1 > 0xFFFFFFFFULL
+                                   ? 0xFFFFFFFFULL : disk->sectors - 1;
+    BYTE* p = mbr + 446;
+    p[1] = 0x00; p[2] = 0x02; p[3] = 0x00;   // CHS de début
+    p[4] = 0xEE;
+    p[5] = 0xFF; p[6] = 0xFF; p[7] = 0xFF;   // CHS de fin
+    p[8] = 1;
+    for (int i = 0; i < 4; i++) p[12 + i] = (BYTE)(mbr_sectors >> (8 * i));
+    mbr[510] = 0x55;
+    mbr[511] = 0xAA;
+    return gpt_write(disk, 0, mbr, disk->sector_size);
+}
+
+int gpt_load(gpt_table_t* table, gpt_disk_t* disk) {
+    gpt_header_t backup;
+    gpt_entry_t* backup_entries = malloc(ENTRIES_BYTES);
+    if (!backup_entries) return -1;
+
+    memset(table, 0, sizeof(*table));
+    table->disk = disk;
+    int primary_ok = read_copy(disk, 1, &table->header, table->entries) == 0;
+    int backup_ok  = read_copy(disk, primary_ok ? table->header.backup_lba : disk->sectors - 1,
+                               &backup, backup_entries) == 0;
+
+    int rc = 0;
+    if (!primary_ok && !backup_ok) {
+        fprintf(stderr, "[Erreur] Table GPT invalide sur %s.\n", disk->name);
+        rc = -1;
+    } else if (!primary_ok) {
+        printf("[Attention] Table GPT principale invalide sur %s : copie de secours utilisee.\n",
+               disk->name);
+        table->header             = backup;
+        table->header.current_lba = 1;
+        table->header.backup_lba  = backup.current_lba;
+        table->header.entries_lba = 2;
+        memcpy(table->entries, backup_entries, ENTRIES_BYTES);
+        table->damaged = 1;
+    } else if (!backup_ok) {
+        printf("[Attention] Copie de secours de la table GPT invalide sur %s : "
+               "elle sera reecrite.\n", disk->name);
+        table->damaged = 1;
+    } else if (backup.entries_crc != table->header.entries_crc) {
+        printf("[Attention] Tables GPT principale et de secours differentes sur %s : "
+               "la principale fait foi.\n", disk->name);
+    }
+
+    free(backup_entries);
+    return rc;
+}
+
+int gpt_store(gpt_table_t* table) {
+    gpt_disk_t*        disk    = table->disk;
+    gpt_header_t       hdr     = table->header;
+    unsigned long long last    = hdr.backup_lba;
+    unsigned long long primary = hdr.entries_lba;
+    BYTE               sector[GPT_MAX_SECTOR];
+
+    hdr.header_size = GPT_HEADER_SIZE;
+    hdr.entries_crc = gpt_crc32(table->entries, ENTRIES_BYTES);
+    table->header.header_size = GPT_HEADER_SIZE;
+    table->header.entries_crc = hdr.entries_crc;
+
+    // Copie de secours d'abord, chaque copie vidée avant la suivante : une
+    // coupure laisse toujours une copie valide, l'ancienne table principale
+    // (qui fait foi) ou la nouvelle copie de secours (reprise par gpt_load)
+    for (int copy = 1; copy >= 0; copy--) {
+        hdr.current_lba = copy ? last : 1;
+        hdr.backup_lba  = copy ? 1 : last;
+        hdr.entries_lba = copy ? last - entries_sectors(disk) : primary;
+        hdr.header_crc  = 0;
+        hdr.header_crc  = gpt_crc32(&hdr, GPT_HEADER_SIZE);
+
+        memset(sector, 0, disk->sector_size);
+        memcpy(sector, &hdr, GPT_HEADER_SIZE);
+        if (gpt_write(disk, hdr.entries_lba * disk->sector_size, table->entries,
+                      ENTRIES_BYTES) != 0 ||
+            gpt_write(disk, hdr.current_lba * disk->sector_size, sector,
+                      disk->sector_size) != 0 ||
+            gpt_flush(disk) != 0) {
+            return -1;
+        }
+    }
+    table->damaged = 0;
+    return 0;
+}
+
+typedef struct {
+    unsigned long long first;
+    unsigned long long last;
+} lba_range_t;
+
+static int cmp_range(const void* a, const void* b) {
+    const lba_range_t* x = a;
+    const lba_range_t* y = b;
+    return (x->first > y->first) - (x->first < y->first);
+}
+
+unsigned long long gpt_find_free(const gpt_table_t* table, unsigned long long wanted,
+                                 unsigned long long* largest) {
+    const gpt_header_t* hdr   = &table->header;
+    unsigned long long  align = GPT_ALIGN_BYTES / table->disk->sector_size;
+    lba_range_t         used[GPT_ENTRY_COUNT + 1];
+    int                 n = 0;
+    for (int i = 0; i < GPT_ENTRY_COUNT; i++) {
+        if (!gpt_entry_used(&table->entries[i])) continue;
+        used[n].first = table->entries[i].first_lba;
+        used[n].last  = table->entries[i].last_lba;
+        n++;
+    }
+    qsort(used, n, sizeof(lba_range_t), cmp_range);
+    used[n].first = hdr->last_usable + 1;   // sentinelle : fin de la zone utilisable
+    used[n].last  = hdr->last_usable + 1;
+
+    unsigned long long found = 0;
+    unsigned long long start = hdr->first_usable;
+    if (largest) *largest = 0;
+
+    for (int i = 0; i <= n; i++) {
+        unsigned long long aligned = (start + align - 1) / align * align;
+        if (used[i].first > aligned) {
+            unsigned long long gap = used[i].first - aligned;
+            if (largest && gap > *largest) *largest = gap;
+            if (!found && gap >= wanted) found = aligned;
+        }
+        if (used[i].last + 1 > start) start = used[i].last + 1;
+    }
+    return found;
+}
+
+int gpt_add(gpt_table_t* table, const BYTE type[16], unsigned long long first,
+            unsigned long long sectors, const char* name) {
+    for (int i = 0; i < GPT_ENTRY_COUNT; i++) {
+        gpt_entry_t* e = &table->entries[i];
+        if (gpt_entry_used(e)) continue;
+        memset(e, 0, sizeof(*e));
+        if (random_guid(e->unique) != 0) return -1;
+        memcpy(e->type, type, 16);
+        e->first_lba = first;
+        e->last_lba  = first + sectors - 1;
+        for (int k = 0; k < 35 && name[k]; k++) e->name[k] = (unsigned char)name[k];
+        return i;
+    }
+    fprintf(stderr, "[Erreur] Table GPT pleine.\n");
+    return -1;
+}
+
+void gpt_remove(gpt_table_t* table, int index) {
+    memset(&table->entries[index], 0, sizeof(gpt_entry_t));
+}
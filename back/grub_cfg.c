@@ -0,0 +1,253 @@
+// grub_cfg.c
+#include "header/grub_cfg.h"
+#include "header/compat.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Commandes dont les arguments absolus désignent un fichier de l'image
+static const char* const FILE_COMMANDS[] = {
+    "linux", "linuxefi", "linux16", "initrd", "initrdefi", "initrd16",
+    "source", "configfile", "loopback", "loadfont", "background_image",
+    "chainloader", NULL
+};
+
+static const char* const KERNEL_COMMANDS[] = {
+    "linux", "linuxefi", "linux16", NULL
+};
+
+static const char* const INITRD_COMMANDS[] = {
+    "initrd", "initrdefi", "initrd16", NULL
+};
+
+// ── Texte extensible ──────────────────────────────────────────────────────
+
+typedef struct {
+    char*  data;
+    size_t len;
+    size_t cap;
+    int    failed;
+} text_t;
+
+static void text_put(text_t* t, const char* s, size_t n) {
+    if (t->failed) return;
+    if (t->len + n + 1 > t->cap) {
+        size_t cap = t->cap ? t->cap : 4096;
+        while (t->len + n + 1 > cap) cap *= 2;
+        char* grown = realloc(t->data, cap);
+        if (!grown) {
+            t->failed = 1;
+            return;
+        }
+        t->data = grown;
+        t->cap  = cap;
+    }
+    memcpy(t->data + t->len, s, n);
+    t->len += n;
+    t->data[t->len] = '\0';
+}
+
+static void text_str(text_t* t, const char* s) {
+    text_put(t, s, strlen(s));
+}
+
+// ── Réécriture ────────────────────────────────────────────────────────────
+
+static int is_space(char c) {
+    return c == ' ' || c == '\t';
+}
+
+static int in_list(const char* word, size_t n, const char* const* list) {
+    for (int i = 0; list[i]; i++) {
+        if (strlen(list[i]) == n && strncmp(word, list[i], n) == 0) return 1;
+    }
+    return 0;
+}
+
+// Premier mot de la ligne [p, end) : [*word, *word_end)
+static void first_word(const char* p, const char* end, const char** word,
+                       const char** word_end) {
+    *word = p;
+    while (*word < end && is_space(**word)) (*word)++;
+    *word_end = *word;
+    while (*word_end < end && !is_space(**word_end)) (*word_end)++;
+}
+
+// Chemin absolu porté par l'argument [token, end) : "/x", "\"/x" ou
+// "($root)/x". Retourne le début du chemin (/x), NULL si l'argument n'en
+// est pas un ; *path_end exclut le guillemet fermant.
+static const char* arg_path(const char* token, const char* end, const char** path_end) {
+    const char* path = token;
+    if (*path == '"' || *path == '\'') path++;
+    if ((size_t)(end - path) >= 8 && strncmp(path, "($root)/", 8) == 0) path += 7;
+    if (path >= end || *path != '/') return NULL;
+
+    *path_end = end;
+    int quoted = *token == '"' || *token == '\'';
+    if (quoted && end[-1] == *token && end - 1 > path) (*path_end)--;
+    return path;
+}
+
+// "---" sépare les arguments du système live de ceux transmis au système
+// installé
+static int is_separator(const char* token, const char* end) {
+    return end - token == 3 && strncmp(token, "---", 3) == 0;
+}
+
+// Le système live cherche son squashfs à la racine des volumes : dossier
+// des médias (/casper, /live) à lui passer par live-media-path, NULL si
+// les arguments [args, end) du noyau n'en citent pas ou le fixent déjà.
+static const char* live_media(const char* args, const char* end) {
+    const char* media = NULL;
+    for (const char* c = args; c < end;) {
+        if (is_space(*c)) {
+            c++;
+            continue;
+        }
+        const char* token = c;
+        while (c < end && !is_space(*c)) c++;
+        if (is_separator(token, c)) break;
+        if (strncmp(token, "live-media-path=", 16) == 0) return NULL;
+
+        const char* path_end;
+        const char* path = arg_path(token, c, &path_end);
+        if (!path || media) continue;
+        if (strncmp(path, "/casper/", 8) == 0) media = "/casper";
+        if (strncmp(path, "/live/", 6) == 0)   media = "/live";
+    }
+    return media;
+}
+
+static void put_media_path(text_t* t, const char* dir, const char* media) {
+    text_str(t, "live-media-path=");
+    text_str(t, dir);
+    text_str(t, media);
+}
+
+// Une ligne [p, end) sans son saut de ligne
+static void relocate_line(text_t* t, const char* p, const char* end, const char* dir,
+                          grub_cfg_map_fn map, void* ctx) {
+    const char *word, *word_end;
+    first_word(p, end, &word, &word_end);
+
+    size_t n = (size_t)(word_end - word);
+    if (!in_list(word, n, FILE_COMMANDS)) {
+        text_put(t, p, (size_t)(end - p));
+        return;
+    }
+
+    // Arguments : "/x", "\"/x" et "($root)/x" deviennent dir/x, ou le
+    // chemin donné par map (contenu partagé entre images). live-media-path
+    // s'insère avant "---", sinon en fin de ligne.
+    const char* media = in_list(word, n, KERNEL_COMMANDS) ? live_media(word_end, end) : NULL;
+    text_put(t, p, (size_t)(word_end - p));
+    for (const char* c = word_end; c < end;) {
+        if (is_space(*c)) {
+            text_put(t, c++, 1);
+            continue;
+        }
+        const char* token = c;
+        while (c < end && !is_space(*c)) c++;
+
+        if (media && is_separator(token, c)) {
+            put_media_path(t, dir, media);
+            text_put(t, " ", 1);
+            media = NULL;
+        }
+
+        const char* path_end;
+        const char* path = arg_path(token, c, &path_end);
+        if (path) {
+            const char* mapped = map ? map(ctx, path, (size_t)(path_end - path)) : NULL;
+            text_put(t, token, (size_t)(path - token));
+            if (mapped) {
+                text_str(t, mapped);
+                text_put(t, path_end, (size_t)(c - path_end));
+            } else {
+                text_str(t, dir);
+                text_put(t, path, (size_t)(c - path));
+            }
+        } else {
+            text_put(t, token, (size_t)(c - token));
+        }
+    }
+
+    if (media) {
+        text_put(t, " ", 1);
+        put_media_path(t, dir, media);
+    }
+}
+
+int grub_cfg_is_config(const char* rel_path, const char* loader_dir) {
+    size_t len = strlen(rel_path);
+    if (len < 4 || _stricmp(rel_path + len - 4, ".cfg") != 0) return 0;
+    if (_strnicmp(rel_path, "\\boot\\grub\\", 11) == 0) return 1;
+
+    size_t dir_len = strlen(loader_dir);
+    return dir_len > 0 && _strnicmp(rel_path, loader_dir, dir_len) == 0 &&
+           rel_path[dir_len] == '\\' && !strchr(rel_path + dir_len + 1, '\\');
+}
+
+void grub_cfg_boot_files(const char* cfg, size_t len, grub_cfg_file_fn fn, void* ctx) {
+    const char* end = cfg + len;
+    for (const char* p = cfg; p < end;) {
+        const char* eol      = memchr(p, '\n', (size_t)(end - p));
+        const char* line_end = eol ? eol : end;
+
+        const char *word, *word_end;
+        first_word(p, line_end, &word, &word_end);
+        size_t n      = (size_t)(word_end - word);
+        int    kernel = in_list(word, n, KERNEL_COMMANDS);
+        if (kernel || in_list(word, n, INITRD_COMMANDS)) {
+            // Noyau : premier argument seulement, la suite est sa ligne de
+            // commande. initrd : tous les arguments.
+            for (const char* c = word_end; c < line_end;) {
+                if (is_space(*c) || *c == '\r') {
+                    c++;
+                    continue;
+                }
+                const char* token = c;
+                while (c < line_end && !is_space(*c) && *c != '\r') c++;
+
+                const char* path_end;
+                const char* path = arg_path(token, c, &path_end);
+                if (path) fn(ctx, path, (size_t)(path_end - path));
+                if (kernel) break;
+            }
+        }
+        p = eol ? eol + 1 : end;
+    }
+}
+
+char* grub_cfg_relocate(const char* cfg, size_t len, const char* dir, const char* marker,
+                        grub_cfg_map_fn map, void* ctx, size_t* out_len) {
+    text_t t = {0};
+
+    text_str(&t, "# Pleco : image copiee dans ");
+    text_str(&t, dir);
+    text_str(&t, ", chemins reecrits\nsearch --no-floppy --set=root --file ");
+    text_str(&t, marker);
+    text_str(&t, "\nset prefix=($root)");
+    text_str(&t, dir);
+    text_str(&t, "/boot/grub\n\n");
+
+    const char* end = cfg + len;
+    for (const char* p = cfg; p < end;) {
+        const char* eol = memchr(p, '\n', (size_t)(end - p));
+        const char* line_end = eol ? eol : end;
+        const char* body_end = line_end;
+        if (body_end > p && body_end[-1] == '\r') body_end--;
+
+        relocate_line(&t, p, body_end, dir, map, ctx);
+        text_put(&t, body_end, (size_t)(line_end - body_end));
+        if (eol) text_put(&t, "\n", 1);
+        p = eol ? eol + 1 : end;
+    }
+
+    if (t.failed || !t.data) {
+        free(t.data);
+        return NULL;
+    }
+    *out_len = t.len;
+    return t.data;
+}
@@ -0,0 +1,21 @@
+#ifndef BCD_IMAGE_H
+#define BCD_IMAGE_H
+
+#include "compat.h"
+
+// Pendant de bcdedit pour le disque virtuel (vdisk.h). Le magasin BCD est
+// un fichier texte à côté de l'image (<image>.bcd) ; vbcd_run accepte les
+// mêmes arguments que bcdedit et produit une sortie équivalente, ce qui
+// laisse bcd_manager.c inchangé au-dessus.
+//
+// Commandes reconnues : /create, /set (device, path), /displayorder
+// /addfirst, /default, /timeout, /delete, /export, /import, /enum.
+// /set path vérifie que le binaire EFI existe sur la partition désignée.
+
+// Retourne 0 en succès, -1 en erreur (comme run_process_with_input)
+int vbcd_run(const char* args, char* output, DWORD output_size);
+
+// Sauvegarde utilisée à la place de BCD_BACKUP_PATH : <image>.bcd.bak
+const char* vbcd_backup_path(void);
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+// Banc d'essai des politiques d'E/S (io_policy.h) sur un gros fichier :
+// débit du hachage, débit de la copie, durée du vidage final et part du
+// fichier restée dans le cache système après chaque passe.
+//
+// Chaque passe (hachage puis copie, pour chaque politique) lit sa propre
+// tranche du fichier : aucune ne profite des pages laissées en cache par
+// une autre, même sous Windows où le banc ne peut pas les évincer.
+// La copie est écrite dans <path>.bench.tmp, supprimé à la fin.
+// policy -1 : toutes les politiques. Retourne 0 en succès, -1 en erreur.
+int bench_run(const char* path, int policy);
+
+#endif
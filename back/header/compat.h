@@ -0,0 +1,198 @@
+#ifndef COMPAT_H
+#define COMPAT_H
+
+// Sous Windows : l'API Win32 telle quelle. Ailleurs (Linux, CI) : le
+// sous-ensemble utilisé par les modules portables, réimplémenté sur POSIX
+// pour exécuter le pipeline contre un disque virtuel (voir vdisk.h).
+// Les chemins Windows (séparateur \) sont convertis à l'ouverture.
+//
+// Compilation hors Windows : gcc -O2 -o pleco *.c -lpthread
+
+#ifdef _WIN32
+
+#include <windows.h>
+#include <bcrypt.h>     // BCryptGenRandom (bcrypt.lib)
+#include <io.h>
+
+#else
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <strings.h>
+#include <string.h>
+#include <unistd.h>
+
+typedef int                BOOL;
+typedef unsigned char      BYTE;
+typedef unsigned short     WORD;
+typedef unsigned long      DWORD;   // comme sous Windows : formats %lu inchangés
+typedef long               LONG;
+typedef long long          LONGLONG;
+typedef unsigned long long ULONGLONG;
+typedef void*              HANDLE;
+typedef void*              LPVOID;
+typedef const char*        LPCSTR;
+typedef DWORD*             LPDWORD;
+
+typedef union {
+    struct { uint32_t LowPart; int32_t HighPart; };
+    LONGLONG QuadPart;
+} LARGE_INTEGER;
+
+typedef union {
+    struct { uint32_t LowPart; uint32_t HighPart; };
+    ULONGLONG QuadPart;
+} ULARGE_INTEGER;
+
+typedef struct {
+    DWORD dwLowDateTime;
+    DWORD dwHighDateTime;
+} FILETIME;
+
+typedef struct {
+    DWORD    dwFileAttributes;
+    FILETIME ftLastWriteTime;
+    DWORD    nFileSizeHigh;
+    DWORD    nFileSizeLow;
+    char     cFileName[260];
+} WIN32_FIND_DATAA;
+
+typedef struct {
+    DWORD    dwFileAttributes;
+    FILETIME ftLastWriteTime;
+    DWORD    nFileSizeHigh;
+    DWORD    nFileSizeLow;
+} WIN32_FILE_ATTRIBUTE_DATA;
+
+typedef enum { GetFileExInfoStandard } GET_FILEEX_INFO_LEVELS;
+
+typedef struct {
+    DWORD dwNumberOfProcessors;
+} SYSTEM_INFO;
+
+typedef struct {
+    void* unused;
+} SECURITY_ATTRIBUTES;
+
+typedef pthread_mutex_t CRITICAL_SECTION;
+typedef pthread_cond_t  CONDITION_VARIABLE;
+typedef DWORD (*LPTHREAD_START_ROUTINE)(LPVOID);
+
+#define WINAPI
+#define TRUE  1
+#define FALSE 0
+#define MAX_PATH 260
+#define INFINITE 0xFFFFFFFF
+#define INVALID_HANDLE_VALUE    ((HANDLE)(intptr_t)-1)
+#define INVALID_FILE_ATTRIBUTES ((DWORD)-1)
+
+#define GENERIC_READ              0x80000000
+#define GENERIC_WRITE             0x40000000
+#define FILE_SHARE_READ           0x00000001
+#define FILE_SHARE_WRITE          0x00000002
+#define CREATE_ALWAYS             2
+#define OPEN_EXISTING             3
+#define OPEN_ALWAYS               4
+#define FILE_ATTRIBUTE_DIRECTORY  0x00000010
+#define FILE_ATTRIBUTE_NORMAL     0x00000080
+#define FILE_FLAG_SEQUENTIAL_SCAN 0x08000000
+#define FILE_FLAG_RANDOM_ACCESS   0x10000000
+#define FILE_FLAG_NO_BUFFERING    0x20000000
+#define FILE_FLAG_WRITE_THROUGH   0x80000000
+#define FILE_BEGIN   0
+#define FILE_CURRENT 1
+#define FILE_END     2
+
+#define ERROR_FILE_NOT_FOUND   2
+#define ERROR_PATH_NOT_FOUND   3
+#define ERROR_ACCESS_DENIED    5
+#define ERROR_NOT_ENOUGH_MEMORY 8
+#define ERROR_HANDLE_EOF       38
+#define ERROR_NOT_SUPPORTED    50
+#define ERROR_FILE_EXISTS      80
+#define ERROR_DISK_FULL        112
+#define ERROR_ALREADY_EXISTS   183
+
+#define STD_INPUT_HANDLE      ((DWORD)-10)
+#define STD_OUTPUT_HANDLE     ((DWORD)-11)
+#define STD_ERROR_HANDLE      ((DWORD)-12)
+#define DUPLICATE_SAME_ACCESS 0x00000002
+
+// Fichiers
+HANDLE CreateFileA(LPCSTR path, DWORD access, DWORD share, SECURITY_ATTRIBUTES* sa,
+                   DWORD disposition, DWORD flags, HANDLE template_file);
+BOOL   ReadFile(HANDLE h, LPVOID buffer, DWORD size, LPDWORD read, void* overlapped);
+BOOL   WriteFile(HANDLE h, const void* buffer, DWORD size, LPDWORD written, void* overlapped);
+BOOL   CloseHandle(HANDLE h);
+BOOL   GetFileSizeEx(HANDLE h, LARGE_INTEGER* size);
+BOOL   SetFilePointerEx(HANDLE h, LARGE_INTEGER distance, LARGE_INTEGER* new_pos, DWORD method);
+BOOL   SetEndOfFile(HANDLE h);
+BOOL   FlushFileBuffers(HANDLE h);
+BOOL   GetFileTime(HANDLE h, FILETIME* created, FILETIME* accessed, FILETIME* written);
+BOOL   DeleteFileA(LPCSTR path);
+BOOL   CopyFileA(LPCSTR from, LPCSTR to, BOOL fail_if_exists);
+BOOL   CreateDirectoryA(LPCSTR path, SECURITY_ATTRIBUTES* sa);
+DWORD  GetFileAttributesA(LPCSTR path);
+BOOL   GetFileAttributesExA(LPCSTR path, GET_FILEEX_INFO_LEVELS level, LPVOID out);
+BOOL   GetDiskFreeSpaceExA(LPCSTR path, ULARGE_INTEGER* free_caller,
+                           ULARGE_INTEGER* total, ULARGE_INTEGER* free_total);
+
+// Parcours de dossier : seul le motif "dossier\*" est pris en charge
+HANDLE FindFirstFileA(LPCSTR pattern, WIN32_FIND_DATAA* data);
+BOOL   FindNextFileA(HANDLE h, WIN32_FIND_DATAA* data);
+BOOL   FindClose(HANDLE h);
+
+// Flux standard (mode serveur)
+HANDLE GetStdHandle(DWORD which);
+BOOL   SetStdHandle(DWORD which, HANDLE h);
+HANDLE GetCurrentProcess(void);
+BOOL   DuplicateHandle(HANDLE src_process, HANDLE src, HANDLE dst_process, HANDLE* dst,
+                       DWORD access, BOOL inherit, DWORD options);
+
+// Threads et synchronisation
+HANDLE CreateThread(SECURITY_ATTRIBUTES* sa, size_t stack, LPTHREAD_START_ROUTINE start,
+                    LPVOID param, DWORD flags, LPDWORD thread_id);
+DWORD  WaitForSingleObject(HANDLE h, DWORD timeout_ms);
+void   InitializeCriticalSection(CRITICAL_SECTION* cs);
+void   DeleteCriticalSection(CRITICAL_SECTION* cs);
+void   EnterCriticalSection(CRITICAL_SECTION* cs);
+void   LeaveCriticalSection(CRITICAL_SECTION* cs);
+void   InitializeConditionVariable(CONDITION_VARIABLE* cv);
+BOOL   SleepConditionVariableCS(CONDITION_VARIABLE* cv, CRITICAL_SECTION* cs, DWORD timeout_ms);
+void   WakeAllConditionVariable(CONDITION_VARIABLE* cv);
+LONG   InterlockedExchange(volatile LONG* target, LONG value);
+
+// Divers
+DWORD  GetLastError(void);
+void   Sleep(DWORD ms);
+void   GetSystemInfo(SYSTEM_INFO* info);
+BOOL   QueryPerformanceCounter(LARGE_INTEGER* count);
+BOOL   QueryPerformanceFrequency(LARGE_INTEGER* frequency);
+
+// Aléa du système (/dev/urandom). Seul le générateur par défaut existe :
+// alg doit être NULL avec BCRYPT_USE_SYSTEM_PREFERRED_RNG.
+#define BCRYPT_USE_SYSTEM_PREFERRED_RNG 0x00000002
+#define BCRYPT_SUCCESS(status)          ((LONG)(status) >= 0)
+LONG   BCryptGenRandom(HANDLE alg, BYTE* buffer, DWORD size, DWORD flags);
+
+// Extensions POSIX, sans équivalent Win32 (voir io_policy.h).
+// Libère du cache système les pages propres de [offset, offset + length),
+// length 0 : jusqu'à la fin du fichier.
+void      compat_drop_cache(HANDLE h, unsigned long long offset, unsigned long long length);
+// Octets du fichier présents dans le cache système, -1 si inconnu
+long long compat_cached_bytes(LPCSTR path);
+// Périphérique portant path ("dev-majeur:mineur"), 0 en succès
+int       compat_device_id(LPCSTR path, char* out, size_t size);
+// Handle sur un descripteur déjà ouvert (socket, tube) ; CloseHandle le ferme
+HANDLE    compat_fd_handle(int fd);
+
+#define _stricmp  strcasecmp
+#define _strnicmp strncasecmp
+#define _strdup   strdup
+#define _dup2     dup2
+#define _fileno   fileno
+
+#endif
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef DIGEST_H
+#define DIGEST_H
+
+#include "utils.h"
+
+// Algorithmes combinables : digest_file calcule toute combinaison en une
+// seule lecture du fichier.
+#define DIGEST_SHA256 0x1
+#define DIGEST_SHA512 0x2
+#define DIGEST_BLAKE3 0x4
+
+typedef struct {
+    unsigned int  algos;          // algorithmes effectivement calculés
+    unsigned char sha256[32];
+    unsigned char sha512[64];
+    unsigned char blake3[32];
+} digest_result_t;
+
+// Calcule les empreintes demandées (DIGEST_* combinés) en une passe.
+// BLAKE3 est réparti sur tous les cœurs (mode arbre).
+// Retourne 0 en succès, -1 en erreur.
+int digest_file(const char* path, unsigned int algos, digest_result_t* out,
+                progress_callback_t progress_cb);
+
+// Même calcul sur [offset, offset + length) du fichier, ex: un fichier
+// contenu dans une image ISO. Jamais mis en cache.
+int digest_file_range(const char* path, unsigned long long offset, unsigned long long length,
+                      unsigned int algos, digest_result_t* out,
+                      progress_callback_t progress_cb);
+
+// Threads du hachage BLAKE3 pour suivre un périphérique de bandwidth
+// octets/s, sans dépasser un par cœur ; 0 (débit inconnu) : un par cœur.
+// digest_file en tient compte via le profil de lecture (io_tuner.h).
+int  digest_threads_for(double bandwidth);
+
+// Cache process des empreintes des gros fichiers (clé : chemin, taille, date
+// de modification). Désactivé par défaut, activé par le mode serveur.
+void digest_cache_enable(int enabled);
+
+// Empreintes d'un bloc mémoire (mono-thread)
+void digest_sha256(const void* data, unsigned long long len, unsigned char out[32]);
+void digest_sha512(const void* data, unsigned long long len, unsigned char out[64]);
+void digest_blake3(const void* data, unsigned long long len, unsigned char out[32]);
+
+// out doit pouvoir contenir len * 2 + 1 caractères
+void digest_to_hex(const unsigned char* bytes, int len, char* out);
+
+// Vérifie l'ISO contre expected, liste séparée par des virgules de :
+//   - un hash hexa : SHA-256 (64 car.) ou SHA-512 (128 car.),
+//     préfixe "sha256:", "sha512:" ou "blake3:" pour lever l'ambiguïté ;
+//   - un fichier manifeste (SHA256SUMS, SHA512SUMS, B3SUMS, format BSD...) :
+//     la ligne correspondant au nom de l'ISO est utilisée. Un chemin qui
+//     contient des virgules est reconnu s'il désigne un fichier existant.
+// Toutes les empreintes de la liste sont vérifiées, sans limite de nombre.
+// progress_cb peut être NULL.
+// Retourne 1 si toutes les empreintes correspondent, 0 sinon.
+int verify_iso_digest(const char* iso_path, const char* expected,
+                      progress_callback_t progress_cb);
+
+#endif
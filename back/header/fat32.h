@@ -0,0 +1,77 @@
+#ifndef FAT32_H
+#define FAT32_H
+
+// FAT32 minimal écrit directement sur un disque (gpt.h) : formatage,
+// dossiers, fichiers (écriture seule) et recherche. Sert de "volume monté"
+// aux partitions d'une image disque, et à la partition temporaire d'un
+// disque physique tant qu'elle n'est pas dans la table (partitioning.h) :
+// Windows ne la monte qu'une fois remplie.
+//
+// La FAT est gardée en mémoire pendant que le volume est ouvert et écrite
+// (deux copies + FSInfo) par fat32_close.
+
+#include "compat.h"
+#include "gpt.h"
+
+typedef struct {
+    gpt_disk_t*        disk;
+    unsigned long long offset;             // début de la partition sur le disque
+    unsigned int       bytes_per_cluster;
+    unsigned int       sectors_per_cluster;
+    unsigned int       fat_start;          // secteurs, relatifs à la partition
+    unsigned int       fat_sectors;
+    unsigned int       data_start;
+    unsigned int       cluster_count;      // clusters de données (numérotés dès 2)
+    unsigned int*      fat;
+    unsigned int       next_free;
+    unsigned int       free_count;
+    int                dirty;
+
+    // Dernier dossier parent résolu : les fichiers d'un même dossier
+    // arrivent à la suite, inutile de reparcourir l'arborescence.
+    char               parent_path[MAX_PATH];
+    unsigned int       parent_cluster;
+} fat32_t;
+
+typedef struct {
+    unsigned int       first_cluster;      // 0 pour un fichier vide
+    unsigned int       cluster;            // cluster courant d'écriture
+    unsigned long long size;
+    unsigned long long written;
+} fat32_file_t;
+
+// Formate la zone [offset, offset + size) du disque (secteurs de 512
+// octets). Retourne 0 en succès, -1 en erreur.
+int  fat32_format(gpt_disk_t* disk, unsigned long long offset, unsigned long long size,
+                  const char* label, unsigned int hidden_sectors);
+
+int  fat32_open(fat32_t* fs, gpt_disk_t* disk, unsigned long long offset);
+int  fat32_close(fat32_t* fs);
+
+// Chemins relatifs à la racine, séparateurs \ ou /. fat32_mkdir crée un
+// seul niveau et réussit si le dossier existe déjà.
+int  fat32_mkdir(fat32_t* fs, const char* path);
+
+// Crée le fichier avec sa taille finale (clusters réservés d'avance, si
+// possible contigus) ; les données suivent via fat32_write.
+int  fat32_create(fat32_t* fs, const char* path, unsigned long long size, fat32_file_t* file);
+int  fat32_write(fat32_t* fs, fat32_file_t* file, const void* data, unsigned int len);
+int  fat32_close_file(fat32_t* fs, fat32_file_t* file);
+
+// Écriture groupée de petits fichiers : une seule plage de clusters
+// contiguë pour tout le lot, une seule écriture des données, puis les
+// entrées de chaque dossier en un bloc. Retourne 0 en succès, -1 en
+// erreur, 1 sans rien écrire si aucune plage contiguë n'est assez grande
+// (l'appelant écrit alors fichier par fichier).
+typedef struct {
+    const char*        path;
+    unsigned long long size;
+    const void*        data;
+} fat32_item_t;
+
+int  fat32_write_batch(fat32_t* fs, const fat32_item_t* items, int count);
+
+// Retourne 0 si le chemin existe, -1 sinon.
+int  fat32_find(fat32_t* fs, const char* path, int* is_dir, unsigned long long* size);
+
+#endif
@@ -0,0 +1,118 @@
+#ifndef GPT_H
+#define GPT_H
+
+// Éditeur GPT natif : remplace les scripts diskpart. Lit la table
+// principale et sa copie de secours, cherche un espace libre, ajoute ou
+// retire une entrée puis réécrit les deux copies avec leurs CRC32.
+//
+// Le même code sert au disque système (\\.\PhysicalDriveN, Windows) et aux
+// images disque (vdisk.h), ce qui permet de l'exercer hors Windows.
+
+#include "compat.h"
+
+#define GPT_ENTRY_COUNT   128
+#define GPT_ENTRY_SIZE    128
+#define GPT_HEADER_SIZE   92
+#define GPT_MAX_SECTOR    4096
+#define GPT_ALIGN_BYTES   (1024ULL * 1024ULL)              // comme diskpart
+
+// Disque : image ou disque physique. Accès par octets, sérialisés par lock.
+typedef struct {
+    HANDLE             handle;
+    char               name[MAX_PATH];   // pour les messages
+    unsigned int       sector_size;
+    unsigned long long sectors;
+    int                physical;
+    unsigned long      number;           // N de \\.\PhysicalDriveN
+    CRITICAL_SECTION   lock;
+} gpt_disk_t;
+
+// Disposition sur disque (little endian, champs naturellement alignés)
+typedef struct {
+    char               signature[8];     // "EFI PART"
+    unsigned int       revision;
+    unsigned int       header_size;
+    unsigned int       header_crc;
+    unsigned int       reserved;
+    unsigned long long current_lba;
+    unsigned long long backup_lba;
+    unsigned long long first_usable;
+    unsigned long long last_usable;
+    BYTE               disk_guid[16];
+    unsigned long long entries_lba;
+    unsigned int       entry_count;
+    unsigned int       entry_size;
+    unsigned int       entries_crc;
+} gpt_header_t;
+
+typedef struct {
+    BYTE               type[16];
+    BYTE               unique[16];
+    unsigned long long first_lba;
+    unsigned long long last_lba;         // inclus
+    unsigned long long attributes;
+    unsigned short     name[36];         // UTF-16LE
+} gpt_entry_t;
+
+// Table en mémoire : l'en-tête est toujours vu depuis la copie principale
+typedef struct {
+    gpt_disk_t*        disk;
+    gpt_header_t       header;
+    gpt_entry_t        entries[GPT_ENTRY_COUNT];
+    int                damaged;          // une copie invalide, à réécrire
+} gpt_table_t;
+
+extern const BYTE GPT_TYPE_ESP[16];
+extern const BYTE GPT_TYPE_BASIC_DATA[16];
+
+// ── Disques ───────────────────────────────────────────────────────────────
+// Retournent 0 en succès, -1 en erreur (message affiché).
+
+// Image disque, créée à size octets si create (secteurs de 512 octets)
+int  gpt_open_image(gpt_disk_t* disk, const char* path, int create, unsigned long long size);
+
+// Disque portant le volume Windows (numéro lu sur le volume système,
+// pas supposé égal à 0). Windows seulement.
+int  gpt_open_system_disk(gpt_disk_t* disk);
+int  gpt_open_disk(gpt_disk_t* disk, unsigned long number);
+void gpt_close(gpt_disk_t* disk);
+
+int  gpt_read(gpt_disk_t* disk, unsigned long long offset, void* buffer, unsigned int size);
+int  gpt_write(gpt_disk_t* disk, unsigned long long offset, const void* buffer, unsigned int size);
+int  gpt_flush(gpt_disk_t* disk);
+
+// Demande au système de relire la table (sans effet sur une image)
+int  gpt_rescan(gpt_disk_t* disk);
+
+// ── Table ─────────────────────────────────────────────────────────────────
+
+// Table vide (écrite par gpt_store) ; écrit aussitôt le MBR de protection
+int  gpt_init(gpt_table_t* table, gpt_disk_t* disk);
+
+// Lit les deux copies. Une copie invalide est signalée et remplacée par
+// l'autre au prochain gpt_store ; -1 si aucune n'est valide.
+int  gpt_load(gpt_table_t* table, gpt_disk_t* disk);
+
+// Réécrit la copie de secours en fin de disque puis la table principale
+// (LBA 1), chacune vidée sur le disque avant la suivante
+int  gpt_store(gpt_table_t* table);
+
+// Premier espace libre aligné sur 1 Mo d'au moins wanted secteurs (0 si
+// aucun). largest reçoit la taille du plus grand espace libre aligné.
+unsigned long long gpt_find_free(const gpt_table_t* table, unsigned long long wanted,
+                                 unsigned long long* largest);
+
+// Retourne l'index de la nouvelle entrée, -1 si la table est pleine (ou
+// sans aléa pour son GUID)
+int  gpt_add(gpt_table_t* table, const BYTE type[16], unsigned long long first,
+             unsigned long long sectors, const char* name);
+void gpt_remove(gpt_table_t* table, int index);
+
+int  gpt_entry_used(const gpt_entry_t* entry);
+
+// Nom de l'entrée en ASCII ('?' hors ASCII)
+void gpt_entry_name(const gpt_entry_t* entry, char* out, size_t size);
+
+unsigned int gpt_crc32(const void* data, size_t len);
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef GRUB_CFG_H
+#define GRUB_CFG_H
+
+#include "compat.h"
+
+// Démarrage d'une image copiée dans un sous-dossier (\pleco\N, mode
+// multi-images). Le GRUB des ISO Linux résout ses chemins depuis la racine
+// du volume (/boot/grub, /casper/vmlinuz, /.disk/info) : ses fichiers de
+// configuration sont réécrits pour viser le dossier de l'image.
+//
+// Chaque configuration réécrite commence par un en-tête qui fixe root
+// (recherche du chargeur EFI de l'image, propre à son dossier) et prefix
+// (dir/boot/grub). Le GRUB signé des ISO (Ubuntu, Debian...) ne trouve ni
+// son prefix intégré ni /.disk/info à la racine : il lit alors grub.cfg à
+// côté de son binaire ($cmdpath), d'où l'en-tête est chargé.
+//
+// Réécriture, ligne par ligne : les chemins absolus des commandes qui
+// chargent un fichier (linux, initrd, source, configfile, loopback...)
+// reçoivent le préfixe dir ; les noyaux casper et live-boot reçoivent
+// live-media-path=dir/casper (ou dir/live) pour trouver leur système de
+// fichiers, avant un éventuel "---" (la suite va au système installé). Les images qui cherchent leur volume par étiquette (Fedora,
+// root=live:CDLABEL=...) ne sont pas prises en charge.
+//
+// dir    : dossier de l'image, séparateurs /, ex: /pleco/2
+// marker : fichier propre à l'image, ex: /pleco/2/EFI/BOOT/BOOTx64.EFI
+// map    : chemin de remplacement d'un fichier de l'image (path, len octets,
+//          séparateurs /), ex: /pleco/cas/<hash> ; NULL si dir + path
+
+// Le fichier (chemin dans l'ISO, séparateurs \) est-il une configuration
+// GRUB à réécrire ? loader_dir : dossier du chargeur EFI, ex: \EFI\BOOT
+int   grub_cfg_is_config(const char* rel_path, const char* loader_dir);
+
+typedef const char* (*grub_cfg_map_fn)(void* ctx, const char* path, size_t len);
+typedef void        (*grub_cfg_file_fn)(void* ctx, const char* path, size_t len);
+
+// Fichiers lus par GRUB seul : noyau (premier argument de linux*) et
+// initrd (arguments de initrd*), chemins absolus de l'image passés à fn.
+void  grub_cfg_boot_files(const char* cfg, size_t len, grub_cfg_file_fn fn, void* ctx);
+
+// Réécrit cfg (len octets) précédé de l'en-tête. map peut être NULL.
+// out_len reçoit la taille du texte. Retourne un tampon à libérer (free),
+// NULL si mémoire insuffisante.
+char* grub_cfg_relocate(const char* cfg, size_t len, const char* dir, const char* marker,
+                        grub_cfg_map_fn map, void* ctx, size_t* out_len);
+
+#endif
@@ -0,0 +1,113 @@
+#ifndef IO_POLICY_H
+#define IO_POLICY_H
+
+// Politique d'E/S des gros transferts (hachage et copie des ISO) : ces
+// données ne sont lues qu'une fois, elles ne doivent pas chasser du cache
+// système le travail en cours de l'utilisateur.
+//
+//   buffered : cache système normal
+//   drop     : lecture en cache, pages libérées juste derrière le curseur
+//              (POSIX ; sous Windows, FILE_FLAG_SEQUENTIAL_SCAN seul)
+//   direct   : sans cache (FILE_FLAG_NO_BUFFERING / O_DIRECT) ; une plage
+//              non alignée est lue par secteurs entiers puis recopiée.
+//              drop si le volume refuse l'accès sans cache. Par défaut.
+//
+// Dans les deux derniers modes, les écritures sont vidées toutes les
+// IO_FLUSH_BYTES : le vidage final ne bloque plus sur des Go en attente.
+
+#include "compat.h"
+
+#define IO_ALIGN        4096                    // secteur 4Kn : couvre aussi 512 octets
+#define IO_FLUSH_BYTES  (64ULL * 1024 * 1024)
+#define IO_MAX_DEPTH    4                       // lectures sans cache simultanées
+#define IO_LANE_MIN     (64 * 1024)             // pas de découpage en deçà
+
+typedef enum {
+    IO_POLICY_BUFFERED,
+    IO_POLICY_DROP,
+    IO_POLICY_DIRECT
+} io_policy_t;
+
+#define IO_POLICY_COUNT 3
+
+void        io_policy_set(io_policy_t policy);
+io_policy_t io_policy_get(void);
+const char* io_policy_name(io_policy_t policy);
+
+// "buffered", "drop" ou "direct". Retourne 0 si reconnu, -1 sinon.
+int         io_policy_parse(const char* name, io_policy_t* out);
+
+// ── Voies parallèles ──────────────────────────────────────────────────────
+
+// Lecture synchrone sur son propre handle, à la position offset
+typedef struct {
+    HANDLE             handle;
+    unsigned long long offset;
+    BYTE*              buffer;
+    DWORD              size;
+    DWORD              done;       // octets transférés
+    int                rc;
+} io_request_t;
+
+// Threads persistants servant les voies 1.. (la voie 0 reste à l'appelant),
+// NULL avant la première requête découpée
+typedef struct io_lanes io_lanes_t;
+
+// Exécute les count requêtes simultanément (count <= IO_MAX_DEPTH).
+// Retourne 0 si toutes ont réussi, -1 sinon (rc de chaque requête).
+int  io_lanes_run(io_lanes_t** lanes, io_request_t* requests, int count);
+void io_lanes_free(io_lanes_t** lanes);
+
+// ── Lecture ───────────────────────────────────────────────────────────────
+
+// Les lectures en cache profitent de la lecture anticipée du système. Une
+// lecture sans cache est, elle, découpée en depth morceaux lus en parallèle
+// (un handle par voie) : le périphérique voit depth requêtes en attente.
+typedef struct {
+    HANDLE             cached;     // toujours ouvert : lectures non alignées, infos fichier
+    HANDLE             direct;     // sans cache, INVALID_HANDLE_VALUE si indisponible
+    HANDLE             lanes[IO_MAX_DEPTH];  // voies 1.. de direct, ouvertes à la demande
+    io_lanes_t*        workers;    // threads des voies, gardés jusqu'à io_close
+    io_policy_t        policy;
+    int                depth;      // 1 à IO_MAX_DEPTH
+    unsigned int       block;      // taille de lecture conseillée, 0 si inconnue
+    double             bandwidth;  // octets/s du périphérique, 0 si inconnu
+    char               path[MAX_PATH];
+    BYTE*              bounce;     // lectures sans cache non alignées, alloué à la demande
+    unsigned long long direct_bytes;
+    unsigned long long cached_bytes;
+    unsigned long long last;       // position de la lecture en cache précédente
+} io_reader_t;
+
+// depth et block viennent du profil du périphérique s'il est connu
+// (io_tuner.h), 1 et 0 sinon.
+// Retourne 0 en succès, -1 en erreur (fichier introuvable...)
+int  io_open(io_reader_t* reader, const char* path);
+void io_close(io_reader_t* reader);
+
+// Lit jusqu'à size octets à offset. Si offset et buffer sont alignés sur
+// IO_ALIGN, la lecture sans cache se fait en place : la capacité du tampon
+// doit alors être un multiple de IO_ALIGN au moins égal à size arrondi.
+// Sinon elle passe par un tampon intermédiaire. got < size seulement en
+// fin de fichier. Retourne 0 en succès, -1 en erreur.
+int  io_read_at(io_reader_t* reader, unsigned long long offset, void* buffer,
+                DWORD size, DWORD* got);
+
+// Tampon aligné sur IO_ALIGN
+void* io_alloc(size_t size);
+void  io_free(void* buffer);
+
+// ── Écriture ──────────────────────────────────────────────────────────────
+
+// Compte len octets écrits ; retourne 1 quand l'appelant doit vider ses
+// écritures (puis appeler io_drop_cache), 0 sinon.
+int  io_flush_due(unsigned long long* pending, unsigned long long len);
+
+// Libère les pages propres de [offset, offset + length) (length 0 : tout
+// le fichier). Sans effet sous Windows ou en mode buffered.
+void io_drop_cache(HANDLE h, unsigned long long offset, unsigned long long length);
+
+// Octets du fichier présents dans le cache système, -1 si inconnu (Windows)
+long long io_cached_bytes(const char* path);
+
+#endif
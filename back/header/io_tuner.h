@@ -0,0 +1,49 @@
+#ifndef IO_TUNER_H
+#define IO_TUNER_H
+
+// Réglage des E/S par périphérique : une clé USB 2, un disque dur et un
+// SSD NVMe n'ont ni la même taille de transfert idéale ni le même besoin
+// de requêtes en attente. La première fois qu'un périphérique est vu, une
+// courte mesure (quelques secondes au plus) essaie plusieurs tailles de
+// bloc, et pour les lectures plusieurs profondeurs de file, puis retient
+// la plus petite combinaison à moins de 5 % du meilleur débit.
+//
+// Les profils sont gardés par identifiant de périphérique, en mémoire et
+// dans io_profiles.txt (%LOCALAPPDATA%\Pleco, ~/.cache/pleco ailleurs),
+// et relus sans mesure par les lancements suivants. Une mesure impossible
+// (ISO de moins de IO_TUNE_MIN_FILE octets, volume sans accès direct)
+// n'est pas retentée avant le lancement suivant. La commande tune
+// remesure et détaille pourquoi une mesure échoue.
+//
+// Utilisation (réglages par défaut si le périphérique n'a pas de profil) :
+//   lecture  (ISO)  : io_open applique block et depth ; le hachage règle
+//                     son tampon et son nombre de threads BLAKE3
+//                     (digest_threads_for)
+//   écriture (cible): taille des écritures de la copie, lots de petits
+//                     fichiers (storage.h)
+
+#include "compat.h"
+
+#define IO_TUNE_MIN_FILE (64ULL * 1024 * 1024)
+
+typedef struct {
+    unsigned int block;      // octets par requête
+    int          depth;      // requêtes simultanées (1 à IO_MAX_DEPTH), 1 en écriture
+    double       latency;    // s, requête de 4 Ko
+    double       bandwidth;  // octets/s avec block et depth
+} io_profile_t;
+
+// Profil de lecture séquentielle du périphérique portant path. S'il est
+// inconnu, mesuré sans cache sur le fichier lui-même (au moins
+// IO_TUNE_MIN_FILE octets). Retourne 0 en succès, -1 sans profil.
+int  io_tune_source(const char* path, io_profile_t* out);
+
+// Profil d'écriture du périphérique portant le dossier dir. S'il est
+// inconnu, mesuré avec un fichier sonde temporaire (écritures synchrones).
+// Retourne 0 en succès, -1 sans profil.
+int  io_tune_target(const char* dir, io_profile_t* out);
+
+// refresh : ignore les profils connus, chaque périphérique est remesuré
+void io_tune_refresh(int refresh);
+
+#endif
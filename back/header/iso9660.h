@@ -0,0 +1,43 @@
+#ifndef ISO9660_H
+#define ISO9660_H
+
+#include "compat.h"
+
+// Lecture directe du système de fichiers ISO 9660 (noms Rock Ridge ou
+// Joliet), sans monter l'image. Côté Rock Ridge, les zones de continuation
+// (CE) et les répertoires déplacés (RE/CL) sont suivis : l'index reflète
+// l'arborescence d'origine. Au-delà de 32 niveaux, l'ouverture échoue.
+
+#define ISO_SECTOR_SIZE 2048
+
+typedef struct {
+    char               path[MAX_PATH];   // ex: \EFI\BOOT\BOOTx64.EFI
+    int                is_dir;
+    unsigned long long size;
+    unsigned int       extent;           // premier secteur ; les extents multiples sont contigus
+} iso_entry_t;
+
+typedef struct {
+    char               label[33];
+    unsigned long long image_size;
+    int                rock_ridge;
+    int                joliet;
+
+    iso_entry_t*       entries;          // dossiers avant leur contenu
+    int                count;
+    int                capacity;
+
+    unsigned long long file_bytes;       // somme des tailles de fichiers
+    int                file_count;
+    int                dir_count;
+    char               efi_path[MAX_PATH]; // vide si pas de bootx64.efi sous \EFI
+} iso_index_t;
+
+// Retourne 0 en succès, -1 si l'image est illisible ou n'est pas un ISO 9660
+int  iso_index_open(const char* iso_path, iso_index_t* index);
+void iso_index_free(iso_index_t* index);
+
+// Recherche insensible à la casse, NULL si absent
+const iso_entry_t* iso_index_find(const iso_index_t* index, const char* path);
+
+#endif
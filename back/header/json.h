@@ -0,0 +1,48 @@
+#ifndef JSON_H
+#define JSON_H
+
+// JSON minimal pour le protocole du mode serveur (JSON-RPC 2.0)
+
+typedef enum {
+    JSON_NULL,
+    JSON_BOOL,
+    JSON_NUMBER,
+    JSON_STRING,
+    JSON_ARRAY,
+    JSON_OBJECT
+} json_type_t;
+
+typedef struct json_value {
+    json_type_t         type;
+    int                 boolean;
+    double              number;
+    char*               string;
+    struct json_value*  items;   // éléments (tableau) ou valeurs (objet)
+    char**              keys;    // clés (objet uniquement)
+    int                 count;
+} json_value_t;
+
+// Retourne NULL si le texte n'est pas du JSON valide
+json_value_t* json_parse(const char* text);
+void          json_free(json_value_t* value);
+
+// Accès aux membres d'un objet, NULL / valeur par défaut si absent
+const json_value_t* json_get(const json_value_t* object, const char* key);
+const char*         json_get_string(const json_value_t* object, const char* key);
+double              json_get_number(const json_value_t* object, const char* key,
+                                    double fallback);
+
+// Tampon d'écriture extensible
+typedef struct {
+    char* data;
+    int   len;
+    int   cap;
+} json_buf_t;
+
+void json_buf_init(json_buf_t* buf);
+void json_buf_free(json_buf_t* buf);
+void json_buf_printf(json_buf_t* buf, const char* fmt, ...);
+void json_buf_string(json_buf_t* buf, const char* s);   // avec guillemets et échappement
+void json_buf_value(json_buf_t* buf, const json_value_t* value);
+
+#endif
@@ -1,7 +1,29 @@
 #ifndef PARTITIONING_H
 #define PARTITIONING_H
 
-int create_temp_partition(unsigned int size_mb, char drive_letter);
+#include "gpt.h"
+
+// Partition temporaire créée en deux temps. temp_partition_prepare
+// formate une zone libre du disque sans l'inscrire dans la table : aucun
+// volume n'y est monté, fat32.c peut la remplir directement
+// (storage_open_disk). temp_partition_commit ajoute ensuite l'entrée GPT,
+// fait relire la table et attend le volume sous sa lettre.
+// Sur disque virtuel (sans montage), l'entrée est créée dès la préparation.
+typedef struct {
+    gpt_disk_t*        disk;
+    unsigned long long offset;         // début de la partition, en octets
+    unsigned long long sectors;
+    char               drive_letter;
+    gpt_disk_t         system;         // disque système ouvert par prepare
+} temp_partition_t;
+
+// Retournent 0 en succès, -1 en erreur
+int  temp_partition_prepare(temp_partition_t* part, unsigned int size_mb, char drive_letter);
+int  temp_partition_commit(temp_partition_t* part);
+
+// Abandon avant commit : la zone formatée redevient de l'espace non alloué
+void temp_partition_abort(temp_partition_t* part);
+
 int delete_partition(char drive_letter);
 unsigned long long get_free_space_mb(void);
 
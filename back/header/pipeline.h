@@ -0,0 +1,36 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include "bcd_manager.h"
+#include "staging.h"
+
+// Étapes communes au mode ligne de commande et au mode serveur
+
+#define TEMP_DRIVE_LETTER  'P'
+#define BCD_BACKUP_PATH    "C:\\Windows\\Temp\\pleco_bcd_backup.bcd"
+#define ISO_SIZE_EXTRA_MB  512
+#define MIN_FREE_SPACE_MB  9000   // non alloué minimum sur le disque système
+
+int  is_admin(void);
+void reboot_in_seconds(int seconds);
+
+// Supprime l'entrée BCD (si fournie), restaure le BCD et la partition
+void emergency_cleanup(const char* bcd_id);
+
+// Retourne 1 si le plus grand espace non alloué du disque système (ou de
+// l'image) couvre required_mb, 0 sinon
+int check_free_space(unsigned long long required_mb);
+
+// Espace à exiger pour une partition de partition_mb : au moins
+// MIN_FREE_SPACE_MB sur un vrai disque, partition_mb seul sur un disque
+// virtuel (les images de test ne sont pas dimensionnées pour un système)
+unsigned long long required_space_mb(unsigned long long partition_mb);
+
+// Une entrée BCD par image du plan, la première image étant celle par
+// défaut. En cas d'échec, les entrées créées sont supprimées et le
+// nettoyage d'urgence est lancé.
+// Retourne 0 en succès, -1 en erreur.
+int configure_staged_boot(const staging_plan_t* plan,
+                          char bcd_ids[][BCD_ID_MAX]);
+
+#endif
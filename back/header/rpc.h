@@ -0,0 +1,20 @@
+#ifndef RPC_H
+#define RPC_H
+
+// Mode serveur : le backend reste lancé et reçoit des requêtes JSON-RPC 2.0,
+// un message JSON par ligne. L'état chaud (cache des empreintes, index des
+// ISO, plan monté, pool de hachage) est conservé d'un appel à l'autre.
+//
+// pipe_name NULL : requêtes sur stdin, réponses sur stdout (les journaux
+// des modules partent sur stderr). Sinon : canal nommé \\.\pipe\<pipe_name>
+// (socket Unix hors Windows, voir rpc.c), les clients se succèdent sans
+// perdre l'état. Le canal n'accepte que des clients locaux, lancés par le
+// même utilisateur ou par SYSTEM (root).
+//
+// Méthodes : inspect, verify, plan, stage, configure-boot, cleanup, cancel,
+// status, reboot, shutdown. Les opérations longues envoient des
+// notifications "progress" {id, done, total}. stage refuse un plan dont une
+// ISO n'a pas passé verify (ou a changé depuis : taille, date).
+int rpc_serve(const char* pipe_name);
+
+#endif
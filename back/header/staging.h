@@ -0,0 +1,83 @@
+#ifndef STAGING_H
+#define STAGING_H
+
+#include "compat.h"
+#include "iso9660.h"
+#include "partitioning.h"
+#include "utils.h"
+
+// Une image seule est copiée à la racine de la partition, comme sur l'ISO.
+// Mode multi-images : plusieurs ISO copiés sur la même partition, chacun
+// dans son propre dossier (\pleco\1, \pleco\2, ...), une entrée BCD par
+// image ; leurs configurations GRUB sont réécrites pour ce dossier
+// (grub_cfg.h).
+//
+// Magasin adressé par contenu (multi-images) : un noyau ou un initrd
+// identique dans plusieurs images est stocké une seule fois sous
+// \pleco\cas\<BLAKE3>, et les configurations réécrites y pointent. Seuls
+// ces fichiers, lus par GRUB et par personne d'autre, sont partagés : le
+// reste est copié dans le dossier de chaque image, et le volume reste un
+// FAT32 valide (aucune chaîne de clusters commune à deux fichiers).
+#define STAGING_MAX_IMAGES 8
+#define STAGING_ROOT       "\\pleco"
+#define STAGING_CAS        "\\pleco\\cas"
+
+typedef struct {
+    char               rel_path[MAX_PATH]; // relatif à la racine de l'ISO, ex: \EFI\BOOT\grubx64.efi
+    unsigned long long size;
+    unsigned int       extent;             // premier secteur du contenu dans l'ISO
+    int                image;              // index de l'image source
+    int                is_dir;
+    int                canonical;          // -1 : contenu propre, sinon index du fichier identique
+    int                boot_file;          // noyau ou initrd d'une configuration GRUB réécrite
+    int                shared;             // exemplaire écrit dans le magasin (STAGING_CAS)
+    int                hashed;
+    unsigned char      digest[32];         // BLAKE3, calculé seulement si la taille est partagée
+} staging_file_t;
+
+typedef struct {
+    const char* iso_path;
+    char        name[MAX_PATH];            // nom de fichier de l'ISO (description BCD)
+    char        dir[16];                   // dossier sur la partition, ex: \pleco\1 ("" : racine)
+    char        efi_path[MAX_PATH];        // chemin EFI sur la partition, ex: \pleco\1\EFI\BOOT\BOOTx64.EFI
+} staging_image_t;
+
+typedef struct {
+    staging_image_t    images[STAGING_MAX_IMAGES];
+    int                image_count;
+
+    staging_file_t*    files;
+    int                file_count;
+    int                file_capacity;
+
+    unsigned long long total_bytes;        // somme des fichiers de toutes les images
+    unsigned long long unique_bytes;       // contenu écrit après déduplication
+    int                duplicate_count;    // fichiers remplacés par le magasin
+} staging_plan_t;
+
+// Index d'une ISO fourni par l'appelant (cache du serveur RPC), qui en
+// reste propriétaire. NULL si l'image est illisible.
+typedef const iso_index_t* (*staging_index_fn)(const char* iso_path);
+
+// Lit l'arborescence de chaque ISO (sans montage) et inventorie les
+// fichiers. Plusieurs images : repère les noyaux et initrd identiques
+// (taille puis BLAKE3). index_fn peut être NULL : chaque index est alors
+// ouvert et libéré ici.
+// Retourne 0 en succès, -1 en erreur.
+int staging_plan(staging_plan_t* plan, const char* const* iso_paths, int count,
+                 staging_index_fn index_fn);
+
+// Taille de partition nécessaire en Mo (sans marge), magasin compris
+unsigned int staging_required_mb(const staging_plan_t* plan);
+
+// Copie toutes les images sur la partition préparée (pas encore montée,
+// voir partitioning.h), directement en FAT32. Les doublons ne sont écrits
+// qu'une fois, dans le magasin.
+// Retourne 0 en succès, -1 en erreur.
+int staging_execute(staging_plan_t* plan, temp_partition_t* part,
+                    progress_callback_t progress_cb);
+
+// Libère l'inventaire
+void staging_free(staging_plan_t* plan);
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef STORAGE_H
+#define STORAGE_H
+
+#include "compat.h"
+#include "fat32.h"
+
+// Volume cible de la copie : FAT32 écrit directement sur le disque par
+// fat32.c (partition du disque virtuel, ou partition temporaire pas encore
+// montée, voir partitioning.h), sans passer par le système de fichiers de
+// Windows. Chemins relatifs à la racine du volume, ex: \pleco\1\EFI.
+
+typedef struct {
+    char         drive_letter;
+    unsigned int alloc_unit;   // taille de cluster (octets)
+    unsigned int batch_bytes;  // taille de lot des petits fichiers, mesurée à l'ouverture
+    unsigned int write_block;  // taille d'écriture conseillée (profil du périphérique)
+    unsigned long long pending; // octets écrits depuis le dernier vidage (io_flush_due)
+    fat32_t      fat;
+} storage_volume_t;
+
+typedef struct {
+    fat32_file_t fat;
+} storage_file_t;
+
+// FAT32 commençant à offset octets sur disk. drive_letter ne sert qu'aux
+// messages. Reprend le profil d'écriture du périphérique (io_tuner.h,
+// mesuré s'il est inconnu) pour en déduire write_block et batch_bytes.
+// Retourne 0 en succès, -1 en erreur
+int  storage_open_disk(storage_volume_t* vol, gpt_disk_t* disk, unsigned long long offset,
+                       char drive_letter);
+int  storage_close(storage_volume_t* vol);
+
+// Réussit si le dossier existe déjà
+int  storage_mkdir(storage_volume_t* vol, const char* path);
+
+// size : taille finale du fichier (clusters réservés d'avance)
+int  storage_create(storage_volume_t* vol, const char* path, unsigned long long size,
+                    storage_file_t* file);
+int  storage_write(storage_volume_t* vol, storage_file_t* file, const void* data,
+                   unsigned int len);
+int  storage_close_file(storage_volume_t* vol, storage_file_t* file);
+
+// Selon la politique d'E/S (io_policy.h), les écritures sont vidées sur le
+// support toutes les IO_FLUSH_BYTES pour que la fermeture ne bloque pas.
+
+// Petits fichiers écrits en un lot (voir fat32_write_batch) ; fichier par
+// fichier seulement si le volume n'a plus de plage libre assez grande.
+typedef fat32_item_t storage_item_t;
+
+int  storage_write_batch(storage_volume_t* vol, const storage_item_t* items, int count);
+
+#endif
@@ -1,7 +1,7 @@
 #ifndef UTILS_H
 #define UTILS_H
 
-#include <windows.h>
+#include "compat.h"
 
 int run_process_with_input(
     const char* executable,
@@ -10,4 +10,17 @@ int run_process_with_input(
     DWORD output_buffer_size
 );
 
+// Copie bornée : dst (size octets) est toujours terminé par un zéro.
+// Retourne 0, -1 si src ne tient pas (dst reçoit alors le début de src).
+int  copy_string(char* dst, size_t size, const char* src);
+
+// Callback de progression : (valeur_actuelle, valeur_max)
+typedef void (*progress_callback_t)(unsigned long long written,
+                                     unsigned long long total);
+
+// Annulation coopérative (mode serveur) : les boucles longues (hachage,
+// copie) la consultent entre deux blocs et abandonnent proprement.
+void set_cancel_requested(int value);
+int  cancel_requested(void);
+
 #endif
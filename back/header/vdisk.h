@@ -0,0 +1,47 @@
+#ifndef VDISK_H
+#define VDISK_H
+
+// Disque virtuel : une image disque GPT dans un fichier remplace le disque
+// système et bcdedit. Une fois l'image ouverte, la partition temporaire,
+// la copie et la configuration BCD travaillent sur l'image : le pipeline
+// complet tourne sans toucher à un vrai disque (et hors Windows).
+// back/tests/e2e.py s'en sert pour le test de bout en bout.
+//
+// Une image n'a pas de lettres de lecteur : la lettre attribuée à une
+// partition est notée dans son nom GPT, ex: "PLECO_TEMP (P:)".
+
+#include "gpt.h"
+
+#define VDISK_SECTOR_SIZE 512
+
+// Crée une image GPT de size_mb Mo : ESP de 100 Mo puis une partition
+// "Windows" de system_mb Mo, le reste non alloué.
+// Retourne 0 en succès, -1 en erreur.
+int  vdisk_create(const char* image_path, unsigned int size_mb, unsigned int system_mb);
+
+// Ouvre l'image : toutes les opérations disque et BCD portent dessus
+// jusqu'à vdisk_close. Retourne 0 en succès, -1 en erreur.
+int  vdisk_open(const char* image_path);
+void vdisk_close(void);
+int  vdisk_is_open(void);
+const char* vdisk_path(void);
+
+// Accès brut à l'image (offsets en octets). Retourne 0 en succès, -1 en erreur.
+int  vdisk_read(unsigned long long offset, void* buffer, unsigned int size);
+int  vdisk_write(unsigned long long offset, const void* buffer, unsigned int size);
+int  vdisk_flush(void);
+
+// Disque de l'image ouverte (pour fat32_open), NULL si aucune
+gpt_disk_t* vdisk_device(void);
+
+// Équivalents de diskpart sur l'image (table éditée par gpt.c)
+int  vdisk_create_partition(unsigned int size_mb, char drive_letter);
+int  vdisk_delete_partition(char drive_letter);
+unsigned long long vdisk_free_space_mb(void);
+
+// Position de la partition portant la lettre, en octets. Retourne 0 si
+// trouvée, -1 sinon.
+int  vdisk_find_partition(char drive_letter, unsigned long long* offset,
+                          unsigned long long* size);
+
+#endif
@@ -0,0 +1,366 @@
+// io_policy.c
+#include "header/io_policy.h"
+#include "header/compat.h"
+#include "header/io_tuner.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static io_policy_t current_policy = IO_POLICY_DIRECT;
+
+#define IO_BOUNCE_SIZE (4 * 1024 * 1024)    // lectures sans cache non alignées
+
+static const char* const POLICY_NAMES[IO_POLICY_COUNT] = { "buffered", "drop", "direct" };
+
+void io_policy_set(io_policy_t policy) {
+    current_policy = policy;
+}
+
+io_policy_t io_policy_get(void) {
+    return current_policy;
+}
+
+const char* io_policy_name(io_policy_t policy) {
+    return (unsigned int)policy < IO_POLICY_COUNT ? POLICY_NAMES[policy] : "?";
+}
+
+int io_policy_parse(const char* name, io_policy_t* out) {
+    for (int i = 0; i < IO_POLICY_COUNT; i++) {
+        if (_stricmp(name, POLICY_NAMES[i]) == 0) {
+            *out = (io_policy_t)i;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+// ── Tampons ───────────────────────────────────────────────────────────────
+
+void* io_alloc(size_t size) {
+#ifdef _WIN32
+    return _aligned_malloc(size, IO_ALIGN);
+#else
+    void* p = NULL;
+    return posix_memalign(&p, IO_ALIGN, size) == 0 ? p : NULL;
+#endif
+}
+
+void io_free(void* buffer) {
+#ifdef _WIN32
+    _aligned_free(buffer);
+#else
+    free(buffer);
+#endif
+}
+
+// ── Cache ─────────────────────────────────────────────────────────────────
+
+void io_drop_cache(HANDLE h, unsigned long long offset, unsigned long long length) {
+    if (current_policy == IO_POLICY_BUFFERED) return;
+#ifdef _WIN32
+    // Pas de libération par plage sous Windows : FILE_FLAG_SEQUENTIAL_SCAN
+    // laisse le gestionnaire de cache recycler les vues derrière le curseur.
+    (void)h; (void)offset; (void)length;
+#else
+    compat_drop_cache(h, offset, length);
+#endif
+}
+
+long long io_cached_bytes(const char* path) {
+#ifdef _WIN32
+    (void)path;
+    return -1;
+#else
+    return compat_cached_bytes(path);
+#endif
+}
+
+int io_flush_due(unsigned long long* pending, unsigned long long len) {
+    *pending += len;
+    if (current_policy == IO_POLICY_BUFFERED || *pending < IO_FLUSH_BYTES) return 0;
+    *pending = 0;
+    return 1;
+}
+
+// ── Ouverture ─────────────────────────────────────────────────────────────
+
+static HANDLE open_direct(const char* path) {
+    return CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                       FILE_FLAG_NO_BUFFERING | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+}
+
+int io_open(io_reader_t* reader, const char* path) {
+    memset(reader, 0, sizeof(*reader));
+    reader->policy = current_policy;
+    reader->direct = INVALID_HANDLE_VALUE;
+    reader->depth  = 1;
+    for (int i = 0; i < IO_MAX_DEPTH; i++) reader->lanes[i] = INVALID_HANDLE_VALUE;
+    snprintf(reader->path, sizeof(reader->path), "%s", path);
+
+    io_profile_t profile;
+    if (io_tune_source(path, &profile) == 0) {
+        reader->depth = profile.depth;
+        reader->block     = profile.block;
+        reader->bandwidth = profile.bandwidth;
+    }
+
+    reader->cached = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL,
+                                 OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (reader->cached == INVALID_HANDLE_VALUE) return -1;
+
+    // Un volume qui refuse l'accès sans cache (tmpfs, partage réseau...)
+    // retombe sur les lectures en cache libérées au fur et à mesure.
+    if (reader->policy == IO_POLICY_DIRECT) {
+        reader->direct = open_direct(path);
+    }
+    return 0;
+}
+
+static void close_direct(io_reader_t* reader) {
+    io_lanes_free(&reader->workers);
+    for (int i = 0; i < IO_MAX_DEPTH; i++) {
+        if (reader->lanes[i] != INVALID_HANDLE_VALUE) CloseHandle(reader->lanes[i]);
+        reader->lanes[i] = INVALID_HANDLE_VALUE;
+    }
+    if (reader->direct != INVALID_HANDLE_VALUE) CloseHandle(reader->direct);
+    reader->direct = INVALID_HANDLE_VALUE;
+    io_free(reader->bounce);
+    reader->bounce = NULL;
+}
+
+void io_close(io_reader_t* reader) {
+    // Reste de la lecture anticipée
+    if (reader->cached_bytes) io_drop_cache(reader->cached, 0, 0);
+    close_direct(reader);
+    if (reader->cached != INVALID_HANDLE_VALUE) CloseHandle(reader->cached);
+    reader->cached = INVALID_HANDLE_VALUE;
+}
+
+static int read_handle(HANDLE h, unsigned long long offset, void* buffer, DWORD size, DWORD* got) {
+    LARGE_INTEGER pos;
+    pos.QuadPart = (LONGLONG)offset;
+    *got = 0;
+    return SetFilePointerEx(h, pos, NULL, FILE_BEGIN) &&
+           ReadFile(h, buffer, size, got, NULL) ? 0 : -1;
+}
+
+// ── Voies parallèles ──────────────────────────────────────────────────────
+// Un thread par voie (1..), créé à la première requête qui en a besoin et
+// conservé jusqu'à io_lanes_free : une lecture ou écriture découpée ne
+// paie plus le démarrage de ses threads. La voie 0 est servie par
+// l'appelant.
+
+typedef struct {
+    struct io_lanes* pool;
+    int              index;
+    unsigned int     seen;        // dernier tour traité
+} io_lane_worker_t;
+
+struct io_lanes {
+    CRITICAL_SECTION   lock;
+    CONDITION_VARIABLE ready;
+    CONDITION_VARIABLE done;
+    io_request_t*      requests;
+    int                count;     // requêtes du tour en cours
+    unsigned int       round;
+    int                pending;
+    int                stopping;
+    int                workers;   // voies 1..workers ont leur thread
+    HANDLE             threads[IO_MAX_DEPTH];
+    io_lane_worker_t   worker[IO_MAX_DEPTH];
+};
+
+static void run_request(io_request_t* r) {
+    LARGE_INTEGER pos;
+    pos.QuadPart = (LONGLONG)r->offset;
+    r->done = 0;
+    if (!SetFilePointerEx(r->handle, pos, NULL, FILE_BEGIN)) {
+        r->rc = -1;
+    } else {
+        r->rc = ReadFile(r->handle, r->buffer, r->size, &r->done, NULL) ? 0 : -1;
+    }
+}
+
+static DWORD WINAPI lane_main(LPVOID arg) {
+    io_lane_worker_t* w    = arg;
+    struct io_lanes*  pool = w->pool;
+    for (;;) {
+        EnterCriticalSection(&pool->lock);
+        while (!pool->stopping && pool->round == w->seen) {
+            SleepConditionVariableCS(&pool->ready, &pool->lock, INFINITE);
+        }
+        if (pool->stopping) {
+            LeaveCriticalSection(&pool->lock);
+            return 0;
+        }
+        w->seen = pool->round;
+        int active = w->index < pool->count;
+        LeaveCriticalSection(&pool->lock);
+        if (!active) continue;
+
+        run_request(&pool->requests[w->index]);
+
+        EnterCriticalSection(&pool->lock);
+        if (--pool->pending == 0) WakeAllConditionVariable(&pool->done);
+        LeaveCriticalSection(&pool->lock);
+    }
+}
+
+int io_lanes_run(io_lanes_t** lanes, io_request_t* requests, int count) {
+    struct io_lanes* pool = *lanes;
+    if (count > 1 && !pool) {
+        pool = calloc(1, sizeof(*pool));
+        if (pool) {
+            InitializeCriticalSection(&pool->lock);
+            InitializeConditionVariable(&pool->ready);
+            InitializeConditionVariable(&pool->done);
+            *lanes = pool;
+        }
+    }
+    // Threads manquants ; une voie sans thread est servie par l'appelant
+    while (pool && pool->workers < count - 1) {
+        io_lane_worker_t* w = &pool->worker[pool->workers + 1];
+        w->pool  = pool;
+        w->index = pool->workers + 1;
+        w->seen  = pool->round;
+        HANDLE t = CreateThread(NULL, 0, lane_main, w, 0, NULL);
+        if (!t) break;
+        pool->threads[++pool->workers] = t;
+    }
+
+    int served = pool ? (pool->workers < count - 1 ? pool->workers : count - 1) : 0;
+    if (served > 0) {
+        EnterCriticalSection(&pool->lock);
+        pool->requests = requests;
+        pool->count    = served + 1;
+        pool->pending  = served;
+        pool->round++;
+        WakeAllConditionVariable(&pool->ready);
+        LeaveCriticalSection(&pool->lock);
+    }
+
+    run_request(&requests[0]);
+    for (int i = served + 1; i < count; i++) run_request(&requests[i]);
+
+    if (served > 0) {
+        EnterCriticalSection(&pool->lock);
+        while (pool->pending > 0) SleepConditionVariableCS(&pool->done, &pool->lock, INFINITE);
+        LeaveCriticalSection(&pool->lock);
+    }
+
+    int rc = 0;
+    for (int i = 0; i < count; i++) {
+        if (requests[i].rc != 0) rc = -1;
+    }
+    return rc;
+}
+
+void io_lanes_free(io_lanes_t** lanes) {
+    struct io_lanes* pool = *lanes;
+    if (!pool) return;
+
+    EnterCriticalSection(&pool->lock);
+    pool->stopping = 1;
+    WakeAllConditionVariable(&pool->ready);
+    LeaveCriticalSection(&pool->lock);
+    for (int i = 1; i <= pool->workers; i++) {
+        WaitForSingleObject(pool->threads[i], INFINITE);
+        CloseHandle(pool->threads[i]);
+    }
+    DeleteCriticalSection(&pool->lock);
+    free(pool);
+    *lanes = NULL;
+}
+
+// Lecture sans cache de size octets (multiple de IO_ALIGN) découpée entre
+// les voies. Une voie courte (fin de fichier) laisse les suivantes vides :
+// la somme des octets lus reste contiguë.
+static int read_lanes(io_reader_t* reader, unsigned long long offset, BYTE* buffer,
+                      DWORD size, DWORD* got) {
+    int depth = reader->depth;
+    while (depth > 1 && size / depth < IO_LANE_MIN) depth--;
+
+    for (int i = 1; i < depth; i++) {
+        if (reader->lanes[i] == INVALID_HANDLE_VALUE) reader->lanes[i] = open_direct(reader->path);
+        if (reader->lanes[i] == INVALID_HANDLE_VALUE) {
+            reader->depth = depth = i;
+            break;
+        }
+    }
+    if (depth <= 1) return read_handle(reader->direct, offset, buffer, size, got);
+
+    io_request_t requests[IO_MAX_DEPTH];
+    DWORD        part = size / depth / IO_ALIGN * IO_ALIGN;
+    for (int i = 0; i < depth; i++) {
+        requests[i].handle = i == 0 ? reader->direct : reader->lanes[i];
+        requests[i].offset = offset + (unsigned long long)part * i;
+        requests[i].buffer = buffer + (size_t)part * i;
+        requests[i].size   = i == depth - 1 ? size - part * i : part;
+        requests[i].rc     = 0;
+    }
+    int rc = io_lanes_run(&reader->workers, requests, depth);
+
+    *got = 0;
+    for (int i = 0; i < depth; i++) *got += requests[i].done;
+    return rc;
+}
+
+// ── Lecture ───────────────────────────────────────────────────────────────
+
+// Plage quelconque sans cache : secteurs entiers depuis la position
+// arrondie en dessous, lus dans le tampon intermédiaire du lecteur, puis
+// recopie de la sous-plage demandée.
+static int read_bounced(io_reader_t* reader, unsigned long long offset, BYTE* buffer,
+                        DWORD size, DWORD* got) {
+    *got = 0;
+    if (!reader->bounce && !(reader->bounce = io_alloc(IO_BOUNCE_SIZE))) return -1;
+
+    while (*got < size) {
+        unsigned long long pos  = offset + *got;
+        DWORD              head = (DWORD)(pos % IO_ALIGN);
+        DWORD              want = size - *got;
+        if (want > IO_BOUNCE_SIZE - head) want = IO_BOUNCE_SIZE - head;
+
+        DWORD whole = (head + want + IO_ALIGN - 1) / IO_ALIGN * IO_ALIGN;
+        DWORD n;
+        if (read_lanes(reader, pos - head, reader->bounce, whole, &n) != 0) return -1;
+        if (n <= head) break;                           // fin de fichier
+
+        DWORD take = n - head < want ? n - head : want;
+        memcpy(buffer + *got, reader->bounce + head, take);
+        *got += take;
+        if (take < want) break;
+    }
+    return 0;
+}
+
+int io_read_at(io_reader_t* reader, unsigned long long offset, void* buffer,
+               DWORD size, DWORD* got) {
+    if (reader->direct != INVALID_HANDLE_VALUE) {
+        int rc;
+        if (offset % IO_ALIGN == 0 && (size_t)buffer % IO_ALIGN == 0) {
+            // Secteurs entiers : on rend au plus size octets
+            DWORD whole = (DWORD)((size + IO_ALIGN - 1) / IO_ALIGN * IO_ALIGN);
+            DWORD n;
+            rc   = read_lanes(reader, offset, buffer, whole, &n);
+            *got = n < size ? n : size;
+        } else {
+            rc = read_bounced(reader, offset, buffer, size, got);
+        }
+        if (rc == 0) {
+            reader->direct_bytes += *got;
+            return 0;
+        }
+        // Refus à la lecture (alignement exigé plus grand...) : plus de direct
+        close_direct(reader);
+    }
+
+    if (read_handle(reader->cached, offset, buffer, size, got) != 0) return -1;
+    reader->cached_bytes += *got;
+    // Les pages de la lecture en cours peuvent être encore verrouillées par
+    // la lecture anticipée : on relâche aussi la précédente, désormais libre.
+    unsigned long long from = reader->last < offset ? reader->last : offset;
+    io_drop_cache(reader->cached, from, offset + *got - from);
+    reader->last = offset;
+    return 0;
+}
@@ -0,0 +1,480 @@
+// io_tuner.c
+#include "header/io_tuner.h"
+#include "header/io_policy.h"
+#include "header/digest.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TUNE_MAX_DEVICES 32
+#define TUNE_BUDGET      0.15                  // s par combinaison, au moins une requête
+#define TUNE_READ_CAP    (32 * 1024 * 1024)    // octets par combinaison au plus
+#define TUNE_WRITE_CAP   (8 * 1024 * 1024)
+#define TUNE_PROBE       4096
+#define TUNE_PROBES      8                     // requêtes de 4 Ko pour la latence
+#define TUNE_MARGIN      1.05                  // gain exigé d'un bloc ou d'une file plus grands
+#define TUNE_FILE        "io_profiles.txt"
+
+static const unsigned int READ_BLOCKS[]  = { 256 * 1024, 1024 * 1024, 4 * 1024 * 1024,
+                                             8 * 1024 * 1024 };
+static const unsigned int WRITE_BLOCKS[] = { 256 * 1024, 1024 * 1024, 4 * 1024 * 1024 };
+static const int          DEPTHS[]       = { 1, 2, 4 };     // lectures seulement
+
+#define COUNT(a) ((int)(sizeof(a) / sizeof((a)[0])))
+
+typedef struct {
+    char         kind;       // 'r' lecture, 'w' écriture
+    char         id[96];
+    io_profile_t profile;
+    int          measured;   // dans ce processus : pas à remesurer
+} tune_entry_t;
+
+// Périphérique déjà essayé dans ce processus, mesure réussie ou non
+typedef struct {
+    char kind;
+    char id[96];
+} tune_try_t;
+
+static struct {
+    int          loaded;
+    int          refresh;
+    int          count;
+    tune_entry_t entries[TUNE_MAX_DEVICES];
+    int          tries;
+    tune_try_t   tried[TUNE_MAX_DEVICES];
+} tuner;
+
+static double seconds_since(LARGE_INTEGER start) {
+    LARGE_INTEGER now, freq;
+    QueryPerformanceCounter(&now);
+    QueryPerformanceFrequency(&freq);
+    return (double)(now.QuadPart - start.QuadPart) / (double)freq.QuadPart;
+}
+
+void io_tune_refresh(int refresh) {
+    tuner.refresh = refresh;
+}
+
+// ── Identifiant du périphérique ───────────────────────────────────────────
+
+#ifdef _WIN32
+// Ajoute src à out sans espaces ni caractères de contrôle (séparateurs du
+// fichier de profils)
+static void append_field(char* out, size_t size, const char* src, size_t max) {
+    size_t len = strlen(out);
+    for (size_t i = 0; i < max && src[i] && len + 1 < size; i++) {
+        if (isgraph((unsigned char)src[i])) out[len++] = src[i];
+    }
+    out[len] = '\0';
+}
+#endif
+
+// Modèle et numéro de série du disque sous Windows : stables d'un lancement
+// à l'autre, contrairement au numéro de série du volume (P: est reformaté à
+// chaque installation) ou au numéro de disque (clés USB).
+static int query_device_id(const char* path, char* out, size_t size) {
+#ifdef _WIN32
+    char root[MAX_PATH], volume[8];
+    if (!GetVolumePathNameA(path, root, sizeof(root)) ||
+        !isalpha((unsigned char)root[0]) || root[1] != ':') {
+        return -1;   // partage réseau : pas de profil
+    }
+    snprintf(volume, sizeof(volume), "\\\\.\\%c:", root[0]);
+
+    HANDLE h = CreateFileA(volume, 0, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                           OPEN_EXISTING, 0, NULL);
+    if (h == INVALID_HANDLE_VALUE) return -1;
+
+    STORAGE_PROPERTY_QUERY query;
+    BYTE                   buffer[1024] = {0};
+    DWORD                  returned     = 0;
+    memset(&query, 0, sizeof(query));
+    query.PropertyId = StorageDeviceProperty;
+    query.QueryType  = PropertyStandardQuery;
+    BOOL ok = DeviceIoControl(h, IOCTL_STORAGE_QUERY_PROPERTY, &query, sizeof(query),
+                              buffer, sizeof(buffer) - 1, &returned, NULL);
+    CloseHandle(h);
+    if (!ok || returned < sizeof(STORAGE_DEVICE_DESCRIPTOR)) return -1;
+
+    const STORAGE_DEVICE_DESCRIPTOR* desc = (const STORAGE_DEVICE_DESCRIPTOR*)buffer;
+    snprintf(out, size, "disk-");
+    if (desc->ProductIdOffset && desc->ProductIdOffset < returned) {
+        append_field(out, size, (const char*)buffer + desc->ProductIdOffset,
+                     returned - desc->ProductIdOffset);
+    }
+    if (desc->SerialNumberOffset && desc->SerialNumberOffset < returned) {
+        append_field(out, size, "-", 1);
+        append_field(out, size, (const char*)buffer + desc->SerialNumberOffset,
+                     returned - desc->SerialNumberOffset);
+    }
+    return 0;
+#else
+    return compat_device_id(path, out, size);
+#endif
+}
+
+// Le même ISO est rouvert pour chaque fichier haché dans l'image : on
+// garde le dernier chemin demandé.
+static int device_id(const char* path, char* out, size_t size) {
+    static char last_path[MAX_PATH], last_id[96];
+    static int  last_rc = -1;
+    if (!last_path[0] || strcmp(path, last_path) != 0) {
+        snprintf(last_path, sizeof(last_path), "%s", path);
+        last_rc = query_device_id(path, last_id, sizeof(last_id));
+    }
+    snprintf(out, size, "%s", last_rc == 0 ? last_id : "");
+    return last_rc;
+}
+
+// ── Profils connus ────────────────────────────────────────────────────────
+// Une ligne par périphérique : <r|w> <id> <bloc> <file> <latence s> <débit o/s>
+
+// Chemin trop long : pas de fichier de profils plutôt qu'un chemin tronqué
+static int store_dir(char* out, size_t size) {
+    int len;
+#ifdef _WIN32
+    const char* base = getenv("LOCALAPPDATA");
+    if (!base || !*base) return -1;
+    len = snprintf(out, size, "%s\\Pleco", base);
+#else
+    const char* xdg  = getenv("XDG_CACHE_HOME");
+    const char* home = getenv("HOME");
+    if (xdg && *xdg)         len = snprintf(out, size, "%s/pleco", xdg);
+    else if (home && *home)  len = snprintf(out, size, "%s/.cache/pleco", home);
+    else                     return -1;
+#endif
+    return len >= 0 && (size_t)len < size ? 0 : -1;
+}
+
+static int store_path(char* out, size_t size) {
+    char dir[MAX_PATH];
+    if (store_dir(dir, sizeof(dir)) != 0) return -1;
+#ifdef _WIN32
+    int len = snprintf(out, size, "%s\\%s", dir, TUNE_FILE);
+#else
+    int len = snprintf(out, size, "%s/%s", dir, TUNE_FILE);
+#endif
+    return len >= 0 && (size_t)len < size ? 0 : -1;
+}
+
+static int profile_valid(const io_profile_t* p) {
+    return p->block >= IO_ALIGN && p->block % IO_ALIGN == 0 && p->block <= 64 * 1024 * 1024 &&
+           p->depth >= 1 && p->depth <= IO_MAX_DEPTH && p->bandwidth > 0;
+}
+
+static void store_load(void) {
+    if (tuner.loaded) return;
+    tuner.loaded = 1;
+
+    char path[MAX_PATH];
+    if (store_path(path, sizeof(path)) != 0) return;
+    FILE* f = fopen(path, "r");
+    if (!f) return;
+
+    char line[256];
+    while (fgets(line, sizeof(line), f) && tuner.count < TUNE_MAX_DEVICES) {
+        tune_entry_t e;
+        memset(&e, 0, sizeof(e));
+        if (line[0] == '#') continue;
+        if (sscanf(line, "%c %95s %u %d %lf %lf", &e.kind, e.id, &e.profile.block,
+                   &e.profile.depth, &e.profile.latency, &e.profile.bandwidth) == 6 &&
+            (e.kind == 'r' || e.kind == 'w') && profile_valid(&e.profile)) {
+            tuner.entries[tuner.count++] = e;
+        }
+    }
+    fclose(f);
+}
+
+static void store_save(void) {
+    char dir[MAX_PATH], path[MAX_PATH];
+    if (store_dir(dir, sizeof(dir)) != 0 || store_path(path, sizeof(path)) != 0) return;
+    // Dossiers parents compris (~/.cache peut manquer)
+    for (char* p = dir + 1; *p; p++) {
+        if (*p != '\\' && *p != '/') continue;
+        char sep = *p;
+        *p = '\0';
+        CreateDirectoryA(dir, NULL);
+        *p = sep;
+    }
+    CreateDirectoryA(dir, NULL);
+
+    FILE* f = fopen(path, "w");
+    if (!f) {
+        fprintf(stderr, "[Attention] Profils d'E/S non enregistres : %s\n", path);
+        return;
+    }
+    fprintf(f, "# Pleco : profils d'E/S par peripherique (supprimer pour remesurer)\n");
+    for (int i = 0; i < tuner.count; i++) {
+        const tune_entry_t* e = &tuner.entries[i];
+        fprintf(f, "%c %s %u %d %.6f %.0f\n", e->kind, e->id, e->profile.block,
+                e->profile.depth, e->profile.latency, e->profile.bandwidth);
+    }
+    fclose(f);
+}
+
+static tune_entry_t* store_find(char kind, const char* id) {
+    store_load();
+    for (int i = 0; i < tuner.count; i++) {
+        if (tuner.entries[i].kind == kind && strcmp(tuner.entries[i].id, id) == 0) {
+            return &tuner.entries[i];
+        }
+    }
+    return NULL;
+}
+
+static void store_put(char kind, const char* id, const io_profile_t* profile) {
+    tune_entry_t* e = store_find(kind, id);
+    if (!e) {
+        // Table pleine : le plus ancien profil laisse sa place
+        if (tuner.count == TUNE_MAX_DEVICES) {
+            memmove(&tuner.entries[0], &tuner.entries[1],
+                    (TUNE_MAX_DEVICES - 1) * sizeof(tune_entry_t));
+            tuner.count--;
+        }
+        e = &tuner.entries[tuner.count++];
+        e->kind = kind;
+        snprintf(e->id, sizeof(e->id), "%s", id);
+    }
+    e->profile  = *profile;
+    e->measured = 1;
+    store_save();
+}
+
+// Profil connu et pas à remesurer
+static int known(char kind, const char* id, io_profile_t* out) {
+    tune_entry_t* e = store_find(kind, id);
+    if (!e || (tuner.refresh && !e->measured)) return -1;
+    *out = e->profile;
+    return 0;
+}
+
+// Une seule tentative de mesure par périphérique et par lancement : un
+// échec (fichier trop petit...) n'est pas retenté à chaque ouverture, et
+// le lecteur ouvert par la mesure elle-même ne relance pas de mesure.
+static int first_try(char kind, const char* id) {
+    for (int i = 0; i < tuner.tries; i++) {
+        if (tuner.tried[i].kind == kind && strcmp(tuner.tried[i].id, id) == 0) return 0;
+    }
+    if (tuner.tries < TUNE_MAX_DEVICES) {
+        tuner.tried[tuner.tries].kind = kind;
+        snprintf(tuner.tried[tuner.tries].id, sizeof(tuner.tried[0].id), "%s", id);
+        tuner.tries++;
+    }
+    return 1;
+}
+
+// Garde la plus petite combinaison sauf gain d'au moins TUNE_MARGIN
+static void keep_best(io_profile_t* best, unsigned int block, int depth, double bandwidth) {
+    if (bandwidth > best->bandwidth * TUNE_MARGIN) {
+        best->block     = block;
+        best->depth     = depth;
+        best->bandwidth = bandwidth;
+    }
+}
+
+// ── Lecture ───────────────────────────────────────────────────────────────
+
+// Chaque combinaison lit une zone différente du fichier, cache vidé : on
+// mesure le périphérique, pas la mémoire. Windows ne sait pas vider le
+// cache d'un fichier : la mesure n'y lit que sans cache (measure_read).
+static void evict(io_reader_t* reader) {
+#ifdef _WIN32
+    (void)reader;
+#else
+    compat_drop_cache(reader->cached, 0, 0);
+#endif
+}
+
+// Débit en octets/s, -1 en erreur
+static double read_run(io_reader_t* reader, BYTE* buffer, unsigned long long offset,
+                       unsigned long long size, unsigned int block, int depth) {
+    reader->depth = depth;
+    evict(reader);
+
+    LARGE_INTEGER      start;
+    unsigned long long bytes = 0;
+    QueryPerformanceCounter(&start);
+    while (bytes < TUNE_READ_CAP) {
+        DWORD got;
+        if (offset + block > size) offset = 0;
+        if (io_read_at(reader, offset, buffer, block, &got) != 0 || got != block) return -1;
+        offset += block;
+        bytes  += block;
+        if (seconds_since(start) >= TUNE_BUDGET) break;
+    }
+    double elapsed = seconds_since(start);
+    return elapsed > 0 ? (double)bytes / elapsed : -1;
+}
+
+// Sans refresh (mesure automatique), une mesure impossible d'emblée ne
+// dit rien : les réglages par défaut s'appliquent.
+static int measure_read(const char* path, const char* id, io_profile_t* out) {
+    // Lecteur sans cache quelle que soit la politique en cours
+    io_policy_t policy = io_policy_get();
+    io_reader_t reader;
+    io_policy_set(IO_POLICY_DIRECT);
+    int opened = io_open(&reader, path);
+    io_policy_set(policy);
+    if (opened != 0) return -1;
+
+#ifdef _WIN32
+    if (reader.direct == INVALID_HANDLE_VALUE) {
+        if (tuner.refresh) {
+            printf("[Info] Lecture sans cache impossible sur %s : pas de mesure.\n", path);
+        }
+        io_close(&reader);
+        return -1;
+    }
+#endif
+
+    LARGE_INTEGER size;
+    size.QuadPart = 0;
+    GetFileSizeEx(reader.cached, &size);
+    if ((unsigned long long)size.QuadPart < IO_TUNE_MIN_FILE) {
+        if (tuner.refresh) {
+            printf("[Info] Fichier trop petit pour la mesure (%llu Mo minimum) : %s\n",
+                   IO_TUNE_MIN_FILE / (1024 * 1024), path);
+        }
+        io_close(&reader);
+        return -1;
+    }
+    printf("[Pleco] Mesure des lectures sur %s...\n", id);
+
+    BYTE* buffer = io_alloc(READ_BLOCKS[COUNT(READ_BLOCKS) - 1]);
+    int   rc     = buffer ? 0 : -1;
+
+    // Latence : lectures de 4 Ko dispersées dans le fichier
+    unsigned long long length = rc == 0 ? (unsigned long long)size.QuadPart : 0;
+    LARGE_INTEGER      start;
+    evict(&reader);
+    QueryPerformanceCounter(&start);
+    for (int i = 0; rc == 0 && i < TUNE_PROBES; i++) {
+        DWORD got;
+        unsigned long long pos = length / TUNE_PROBES * i / IO_ALIGN * IO_ALIGN;
+        if (io_read_at(&reader, pos, buffer, TUNE_PROBE, &got) != 0) rc = -1;
+    }
+    memset(out, 0, sizeof(*out));
+    out->latency = seconds_since(start) / TUNE_PROBES;
+
+    // Lectures en cache (volume qui refuse l'accès sans cache, hors
+    // Windows) : la lecture anticipée du système tient déjà la file
+    // pleine, seule la taille de bloc compte.
+    int depths = reader.direct != INVALID_HANDLE_VALUE ? COUNT(DEPTHS) : 1;
+    int runs   = COUNT(READ_BLOCKS) * depths, run = 0;
+    for (int b = 0; rc == 0 && b < COUNT(READ_BLOCKS); b++) {
+        for (int d = 0; rc == 0 && d < depths; d++, run++) {
+            unsigned long long offset = length / runs * run / IO_ALIGN * IO_ALIGN;
+            double bw = read_run(&reader, buffer, offset, length, READ_BLOCKS[b], DEPTHS[d]);
+            if (bw < 0) rc = -1;
+            else        keep_best(out, READ_BLOCKS[b], DEPTHS[d], bw);
+        }
+    }
+
+    io_free(buffer);
+    io_close(&reader);
+    if (rc != 0 || !out->block) {
+        printf("[Info] Mesure des lectures impossible : reglages par defaut.\n");
+        return -1;
+    }
+    return 0;
+}
+
+int io_tune_source(const char* path, io_profile_t* out) {
+    char id[96];
+    if (device_id(path, id, sizeof(id)) != 0) return -1;
+    if (known('r', id, out) == 0) return 0;
+    if (!first_try('r', id) || measure_read(path, id, out) != 0) return -1;
+    store_put('r', id, out);
+
+    // Assez de threads BLAKE3 pour suivre le périphérique, pas plus : une
+    // clé USB 2 ne mobilise pas tous les cœurs.
+    printf("[Info] Lecture %s : %.0f Mo/s, latence %.2f ms : blocs de %u Ko x %d, "
+           "hachage sur %d thread(s).\n", id, out->bandwidth / (1024.0 * 1024.0),
+           out->latency * 1000.0, out->block / 1024, out->depth,
+           digest_threads_for(out->bandwidth));
+    return 0;
+}
+
+// ── Écriture ──────────────────────────────────────────────────────────────
+
+static int write_at(HANDLE h, unsigned long long offset, const void* buffer, DWORD size) {
+    LARGE_INTEGER pos;
+    DWORD         written;
+    pos.QuadPart = (LONGLONG)offset;
+    return SetFilePointerEx(h, pos, NULL, FILE_BEGIN) &&
+           WriteFile(h, buffer, size, &written, NULL) && written == size ? 0 : -1;
+}
+
+// Écritures synchrones successives de block octets, jusqu'au budget. La
+// copie écrit chaque fichier à la suite sur un seul handle : seule la
+// taille de bloc est mesurée, sans file de requêtes.
+static double write_run(HANDLE h, BYTE* buffer, unsigned int block) {
+    LARGE_INTEGER      start;
+    unsigned long long bytes = 0;
+    QueryPerformanceCounter(&start);
+    while (bytes < TUNE_WRITE_CAP) {
+        if (write_at(h, bytes, buffer, block) != 0) return -1;
+        bytes += block;
+        if (seconds_since(start) >= TUNE_BUDGET) break;
+    }
+    double elapsed = seconds_since(start);
+    return elapsed > 0 ? (double)bytes / elapsed : -1;
+}
+
+static int measure_write(const char* dir, const char* id, io_profile_t* out) {
+    char   probe[MAX_PATH];
+    size_t len = strlen(dir);
+    int    sep = len && dir[len - 1] != '\\' && dir[len - 1] != '/';
+    if (snprintf(probe, sizeof(probe), "%s%spleco_probe.tmp", dir, sep ? "\\" : "") >=
+        (int)sizeof(probe)) {
+        return -1;
+    }
+
+    HANDLE h = CreateFileA(probe, GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS,
+                           FILE_ATTRIBUTE_NORMAL | FILE_FLAG_WRITE_THROUGH, NULL);
+    if (h == INVALID_HANDLE_VALUE) {
+        if (tuner.refresh) printf("[Info] Fichier sonde impossible a creer : %s\n", probe);
+        return -1;
+    }
+    printf("[Pleco] Mesure des ecritures sur %s...\n", id);
+
+    BYTE* buffer = io_alloc(WRITE_BLOCKS[COUNT(WRITE_BLOCKS) - 1]);
+    int   rc     = buffer ? 0 : -1;
+    if (buffer) memset(buffer, 0, WRITE_BLOCKS[COUNT(WRITE_BLOCKS) - 1]);
+
+    memset(out, 0, sizeof(*out));
+    LARGE_INTEGER start;
+    QueryPerformanceCounter(&start);
+    for (int i = 0; rc == 0 && i < TUNE_PROBES; i++) {
+        rc = write_at(h, (unsigned long long)i * TUNE_PROBE, buffer, TUNE_PROBE);
+    }
+    out->latency = seconds_since(start) / TUNE_PROBES;
+
+    for (int b = 0; rc == 0 && b < COUNT(WRITE_BLOCKS); b++) {
+        double bw = write_run(h, buffer, WRITE_BLOCKS[b]);
+        if (bw < 0) rc = -1;
+        else        keep_best(out, WRITE_BLOCKS[b], 1, bw);
+    }
+
+    io_free(buffer);
+    CloseHandle(h);
+    DeleteFileA(probe);
+    if (rc != 0 || !out->block) {
+        printf("[Info] Mesure des ecritures impossible : reglages par defaut.\n");
+        return -1;
+    }
+    return 0;
+}
+
+int io_tune_target(const char* dir, io_profile_t* out) {
+    char id[96];
+    if (device_id(dir, id, sizeof(id)) != 0) return -1;
+    if (known('w', id, out) == 0) return 0;
+    if (!first_try('w', id) || measure_write(dir, id, out) != 0) return -1;
+    store_put('w', id, out);
+
+    printf("[Info] Ecriture %s : %.0f Mo/s, latence %.2f ms : blocs de %u Ko.\n",
+           id, out->bandwidth / (1024.0 * 1024.0), out->latency * 1000.0, out->block / 1024);
+    return 0;
+}
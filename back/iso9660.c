@@ -0,0 +1,388 @@
+// iso9660.c
+#include "header/iso9660.h"
+#include "header/utils.h"
+#include "header/compat.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ISO_FIRST_VD   16
+#define ISO_MAX_VD     64
+#define ISO_MAX_DEPTH  32
+
+// Zones de continuation Rock Ridge (CE) suivies par entrée, et leur taille
+#define RR_MAX_CONTINUATIONS 16
+#define RR_MAX_AREA          (8 * ISO_SECTOR_SIZE)
+
+#define ISO_FLAG_DIR   0x02
+#define ISO_FLAG_MULTI 0x80
+
+enum { NAMES_ISO, NAMES_ROCK_RIDGE, NAMES_JOLIET };
+
+static unsigned int le32(const BYTE* p) {
+    return (unsigned int)p[0] | (unsigned int)p[1] << 8 |
+           (unsigned int)p[2] << 16 | (unsigned int)p[3] << 24;
+}
+
+static int read_sectors(HANDLE h, unsigned int lba, unsigned int count, BYTE* out) {
+    LARGE_INTEGER pos;
+    DWORD         n = 0;
+    pos.QuadPart = (LONGLONG)lba * ISO_SECTOR_SIZE;
+    if (!SetFilePointerEx(h, pos, NULL, FILE_BEGIN)) return -1;
+    if (!ReadFile(h, out, count * ISO_SECTOR_SIZE, &n, NULL)) return -1;
+    return (n == count * ISO_SECTOR_SIZE) ? 0 : -1;
+}
+
+static int index_push(iso_index_t* index, const char* path, int is_dir,
+                      unsigned long long size, unsigned int extent) {
+    if (index->count == index->capacity) {
+        int cap = index->capacity ? index->capacity * 2 : 1024;
+        iso_entry_t* grown = realloc(index->entries, cap * sizeof(iso_entry_t));
+        if (!grown) return -1;
+        index->entries  = grown;
+        index->capacity = cap;
+    }
+    iso_entry_t* e = &index->entries[index->count];
+    memset(e, 0, sizeof(*e));
+    if (copy_string(e->path, sizeof(e->path), path) != 0) return -1;
+    index->count++;
+    e->is_dir = is_dir;
+    e->size   = size;
+    e->extent = extent;
+    return 0;
+}
+
+// ── Décodage des noms ─────────────────────────────────────────────────────
+
+// Nom ISO 9660 brut : on retire la version ";1" et le point final
+static void iso_name(const BYTE* name, int len, char* out, int out_size) {
+    int n = 0;
+    for (int i = 0; i < len && name[i] != ';' && n < out_size - 1; i++) {
+        out[n++] = (char)name[i];
+    }
+    if (n > 0 && out[n - 1] == '.') n--;
+    out[n] = '\0';
+}
+
+// Joliet : UCS-2 big endian converti en UTF-8
+static void joliet_name(const BYTE* name, int len, char* out, int out_size) {
+    int n = 0;
+    for (int i = 0; i + 1 < len; i += 2) {
+        unsigned int c = (unsigned int)name[i] << 8 | name[i + 1];
+        if (c == ';') break;
+        if (c < 0x80) {
+            if (n + 1 >= out_size) break;
+            out[n++] = (char)c;
+        } else if (c < 0x800) {
+            if (n + 2 >= out_size) break;
+            out[n++] = (char)(0xC0 | (c >> 6));
+            out[n++] = (char)(0x80 | (c & 0x3F));
+        } else {
+            if (n + 3 >= out_size) break;
+            out[n++] = (char)(0xE0 | (c >> 12));
+            out[n++] = (char)(0x80 | ((c >> 6) & 0x3F));
+            out[n++] = (char)(0x80 | (c & 0x3F));
+        }
+    }
+    out[n] = '\0';
+}
+
+// Entrées SUSP/Rock Ridge d'un enregistrement utiles au parcours
+typedef struct {
+    char         name[256];   // NM, vide si absent
+    int          relocated;   // RE : répertoire déplacé, listé via son CL
+    unsigned int child;       // CL : extent du répertoire déplacé, 0 sinon
+} rr_entry_t;
+
+// Lit la zone System Use puis ses zones de continuation (CE). Le nom NM
+// peut être découpé en plusieurs morceaux, y compris d'une zone à l'autre.
+// Retourne -1 si une zone de continuation est illisible ou invalide.
+static int rock_ridge_entry(HANDLE h, const BYTE* rec, int rec_len, rr_entry_t* rr) {
+    memset(rr, 0, sizeof(*rr));
+
+    int         name_len = rec[32];
+    int         skip     = 33 + name_len + ((name_len % 2 == 0) ? 1 : 0);
+    const BYTE* area     = rec + skip;
+    int         area_len = rec_len - skip;
+    BYTE*       cont     = NULL;
+    int         n = 0, dot = 0, rc = 0;
+
+    for (int hops = 0;; hops++) {
+        unsigned int ce_block = 0, ce_off = 0, ce_len = 0;
+
+        for (int off = 0; off + 4 <= area_len;) {
+            const BYTE* e = area + off;
+            int len = e[2];
+            if (len < 4 || off + len > area_len) break;
+
+            if (e[0] == 'N' && e[1] == 'M' && len >= 5) {
+                // CURRENT / PARENT : "." et ".."
+                if (e[4] & 0x06) dot = 1;
+                for (int i = 5; i < len && n < (int)sizeof(rr->name) - 1; i++) {
+                    rr->name[n++] = (char)e[i];
+                }
+            } else if (e[0] == 'R' && e[1] == 'E') {
+                rr->relocated = 1;
+            } else if (e[0] == 'C' && e[1] == 'L' && len >= 12) {
+                rr->child = le32(e + 4);
+            } else if (e[0] == 'C' && e[1] == 'E' && len >= 28) {
+                ce_block = le32(e + 4);
+                ce_off   = le32(e + 12);
+                ce_len   = le32(e + 20);
+            } else if (e[0] == 'S' && e[1] == 'T') {
+                break;
+            }
+            off += len;
+        }
+        if (ce_len == 0) break;
+
+        if (hops == RR_MAX_CONTINUATIONS || ce_len > RR_MAX_AREA) {
+            rc = -1;
+            break;
+        }
+        unsigned int first   = ce_block + ce_off / ISO_SECTOR_SIZE;
+        unsigned int start   = ce_off % ISO_SECTOR_SIZE;
+        unsigned int sectors = (start + ce_len + ISO_SECTOR_SIZE - 1) / ISO_SECTOR_SIZE;
+        BYTE*        grown   = realloc(cont, (size_t)sectors * ISO_SECTOR_SIZE);
+        if (!grown) {
+            rc = -1;
+            break;
+        }
+        cont = grown;
+        if (read_sectors(h, first, sectors, cont) != 0) {
+            rc = -1;
+            break;
+        }
+        area     = cont + start;
+        area_len = (int)ce_len;
+    }
+    free(cont);
+
+    rr->name[n] = '\0';
+    if (dot) rr->name[0] = '\0';
+    if (rc != 0) fprintf(stderr, "[Erreur] Zone de continuation Rock Ridge invalide.\n");
+    return rc;
+}
+
+// Taille d'un répertoire, lue dans son entrée "." (cible d'un CL)
+static int dir_size(HANDLE h, unsigned int extent, unsigned int* size) {
+    BYTE sector[ISO_SECTOR_SIZE];
+    if (read_sectors(h, extent, 1, sector) != 0 || sector[0] < 34) return -1;
+    *size = le32(sector + 10);
+    return 0;
+}
+
+// ── Parcours des répertoires ──────────────────────────────────────────────
+
+static int walk_dir(iso_index_t* index, HANDLE h, unsigned int extent,
+                    unsigned int size, const char* parent, int names, int depth) {
+    // Un arbre tronqué sans le dire donnerait une copie incomplète
+    if (depth > ISO_MAX_DEPTH) {
+        fprintf(stderr, "[Erreur] Arborescence ISO trop profonde (> %d niveaux) : %s\n",
+                ISO_MAX_DEPTH, parent);
+        return -1;
+    }
+    if (cancel_requested()) return -1;
+
+    unsigned int sectors = (size + ISO_SECTOR_SIZE - 1) / ISO_SECTOR_SIZE;
+    BYTE* buf = malloc((size_t)sectors * ISO_SECTOR_SIZE);
+    if (!buf) return -1;
+    if (read_sectors(h, extent, sectors, buf) != 0) {
+        free(buf);
+        return -1;
+    }
+
+    int          rc    = 0;
+    int          multi = -1;   // entrée multi-extent en cours d'assemblage
+    unsigned int off   = 0;
+    while (rc == 0 && off < size) {
+        const BYTE* rec = buf + off;
+        int rec_len = rec[0];
+        if (rec_len == 0) {
+            // Les enregistrements ne chevauchent pas les secteurs
+            off = (off / ISO_SECTOR_SIZE + 1) * ISO_SECTOR_SIZE;
+            continue;
+        }
+        if (rec_len < 34 || off + rec_len > size) break;
+        off += rec_len;
+
+        int name_len = rec[32];
+        if (name_len == 1 && (rec[33] == 0 || rec[33] == 1)) continue;   // . et ..
+
+        rr_entry_t rr;
+        memset(&rr, 0, sizeof(rr));
+        if (names == NAMES_ROCK_RIDGE) {
+            if (rock_ridge_entry(h, rec, rec_len, &rr) != 0) {
+                rc = -1;
+                break;
+            }
+            // Listé à sa place d'origine, là où pointe son CL
+            if (rr.relocated) continue;
+        }
+
+        char name[256];
+        if (names == NAMES_JOLIET) {
+            joliet_name(rec + 33, name_len, name, sizeof(name));
+        } else if (rr.name[0]) {
+            copy_string(name, sizeof(name), rr.name);   // même taille
+        } else {
+            iso_name(rec + 33, name_len, name, sizeof(name));
+        }
+
+        char path[MAX_PATH];
+        int  len = snprintf(path, sizeof(path), "%s\\%s", parent, name);
+        if (len < 0 || (size_t)len >= sizeof(path)) {
+            fprintf(stderr, "[Erreur] Chemin trop long dans l'ISO : %s\\%s\n", parent, name);
+            rc = -1;
+            break;
+        }
+
+        int          flags = rec[25];
+        unsigned int rec_extent = le32(rec + 2);
+        unsigned int rec_size   = le32(rec + 10);
+
+        if (multi >= 0) {
+            iso_entry_t* e = &index->entries[multi];
+            if (rec_extent != e->extent + (unsigned int)(e->size / ISO_SECTOR_SIZE)) {
+                fprintf(stderr, "[Attention] Extents non contigus : %s\n", e->path);
+            }
+            e->size           += rec_size;
+            index->file_bytes += rec_size;
+            if (!(flags & ISO_FLAG_MULTI)) multi = -1;
+            continue;
+        }
+
+        // Répertoire déplacé par Rock Ridge (profondeur > 8) : l'entrée est
+        // un fichier vide dont le CL donne le vrai répertoire
+        if (rr.child) {
+            flags      = ISO_FLAG_DIR;
+            rec_extent = rr.child;
+            if (dir_size(h, rec_extent, &rec_size) != 0) {
+                fprintf(stderr, "[Erreur] Repertoire deplace illisible : %s\n", path);
+                rc = -1;
+                break;
+            }
+        }
+
+        if (flags & ISO_FLAG_DIR) {
+            rc = index_push(index, path, 1, 0, rec_extent);
+            index->dir_count++;
+            if (rc == 0) {
+                rc = walk_dir(index, h, rec_extent, rec_size, path, names, depth + 1);
+            }
+        } else {
+            rc = index_push(index, path, 0, rec_size, rec_extent);
+            index->file_count++;
+            index->file_bytes += rec_size;
+            if (flags & ISO_FLAG_MULTI) multi = index->count - 1;
+        }
+    }
+
+    free(buf);
+    return rc;
+}
+
+// Rock Ridge est signalé par une entrée SP dans le "." de la racine
+static int has_rock_ridge(HANDLE h, unsigned int root_extent) {
+    BYTE sector[ISO_SECTOR_SIZE];
+    if (read_sectors(h, root_extent, 1, sector) != 0) return 0;
+
+    int rec_len  = sector[0];
+    int name_len = sector[32];
+    int off      = 33 + name_len + ((name_len % 2 == 0) ? 1 : 0);
+    return rec_len >= off + 7 &&
+           sector[off] == 'S' && sector[off + 1] == 'P' &&
+           sector[off + 4] == 0xBE && sector[off + 5] == 0xEF;
+}
+
+// ── API ───────────────────────────────────────────────────────────────────
+
+int iso_index_open(const char* iso_path, iso_index_t* index) {
+    memset(index, 0, sizeof(*index));
+
+    HANDLE h = CreateFileA(iso_path, GENERIC_READ, FILE_SHARE_READ, NULL,
+                           OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, NULL);
+    if (h == INVALID_HANDLE_VALUE) {
+        fprintf(stderr, "[Erreur] Impossible d'ouvrir l'ISO : %s\n", iso_path);
+        return -1;
+    }
+
+    LARGE_INTEGER size;
+    size.QuadPart = 0;
+    GetFileSizeEx(h, &size);
+    index->image_size = (unsigned long long)size.QuadPart;
+
+    BYTE         vd[ISO_SECTOR_SIZE];
+    unsigned int pvd_root = 0, pvd_root_size = 0;
+    unsigned int jol_root = 0, jol_root_size = 0;
+
+    for (unsigned int lba = ISO_FIRST_VD; lba < ISO_FIRST_VD + ISO_MAX_VD; lba++) {
+        if (read_sectors(h, lba, 1, vd) != 0 || memcmp(vd + 1, "CD001", 5) != 0) break;
+        if (vd[0] == 255) break;
+
+        if (vd[0] == 1 && !pvd_root) {
+            pvd_root      = le32(vd + 156 + 2);
+            pvd_root_size = le32(vd + 156 + 10);
+            memcpy(index->label, vd + 40, 32);
+            for (int i = 31; i >= 0 && index->label[i] == ' '; i--) index->label[i] = '\0';
+        } else if (vd[0] == 2 && vd[88] == '%' && vd[89] == '/' &&
+                   (vd[90] == '@' || vd[90] == 'C' || vd[90] == 'E')) {
+            jol_root      = le32(vd + 156 + 2);
+            jol_root_size = le32(vd + 156 + 10);
+        }
+    }
+
+    if (!pvd_root) {
+        fprintf(stderr, "[Erreur] %s n'est pas une image ISO 9660.\n", iso_path);
+        CloseHandle(h);
+        return -1;
+    }
+
+    index->joliet     = jol_root != 0;
+    index->rock_ridge = has_rock_ridge(h, pvd_root);
+
+    int rc;
+    if (index->rock_ridge) {
+        rc = walk_dir(index, h, pvd_root, pvd_root_size, "", NAMES_ROCK_RIDGE, 0);
+    } else if (index->joliet) {
+        rc = walk_dir(index, h, jol_root, jol_root_size, "", NAMES_JOLIET, 0);
+    } else {
+        rc = walk_dir(index, h, pvd_root, pvd_root_size, "", NAMES_ISO, 0);
+    }
+    CloseHandle(h);
+
+    if (rc != 0) {
+        if (cancel_requested()) {
+            printf("[Pleco] Lecture annulee : %s\n", iso_path);
+        } else {
+            fprintf(stderr, "[Erreur] Lecture de l'arborescence ISO echouee : %s\n", iso_path);
+        }
+        iso_index_free(index);
+        return -1;
+    }
+
+    for (int i = 0; i < index->count; i++) {
+        const iso_entry_t* e = &index->entries[i];
+        const char* base = strrchr(e->path, '\\');
+        if (!e->is_dir && _strnicmp(e->path, "\\EFI\\", 5) == 0 &&
+            base && _stricmp(base + 1, "bootx64.efi") == 0) {
+            copy_string(index->efi_path, sizeof(index->efi_path), e->path);   // même taille
+            break;
+        }
+    }
+    return 0;
+}
+
+void iso_index_free(iso_index_t* index) {
+    free(index->entries);
+    index->entries  = NULL;
+    index->count    = 0;
+    index->capacity = 0;
+}
+
+const iso_entry_t* iso_index_find(const iso_index_t* index, const char* path) {
+    for (int i = 0; i < index->count; i++) {
+        if (_stricmp(index->entries[i].path, path) == 0) return &index->entries[i];
+    }
+    return NULL;
+}
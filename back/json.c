@@ -0,0 +1,336 @@
+// json.c
+#include "header/json.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define JSON_MAX_DEPTH 32
+
+// ── Analyse ───────────────────────────────────────────────────────────────
+
+typedef struct {
+    const char* p;
+    int         depth;
+} json_parser_t;
+
+static void skip_ws(json_parser_t* ps) {
+    while (*ps->p == ' ' || *ps->p == '\t' || *ps->p == '\r' || *ps->p == '\n') ps->p++;
+}
+
+static int parse_value(json_parser_t* ps, json_value_t* out);
+
+static int hex4(const char* p, unsigned int* out) {
+    *out = 0;
+    for (int i = 0; i < 4; i++) {
+        char c = p[i];
+        *out <<= 4;
+        if (c >= '0' && c <= '9')      *out |= (unsigned int)(c - '0');
+        else if (c >= 'a' && c <= 'f') *out |= (unsigned int)(c - 'a' + 10);
+        else if (c >= 'A' && c <= 'F') *out |= (unsigned int)(c - 'A' + 10);
+        else return -1;
+    }
+    return 0;
+}
+
+// Chaîne décodée en UTF-8 (le résultat n'est jamais plus long que la source)
+static char* parse_string(json_parser_t* ps) {
+    if (*ps->p != '"') return NULL;
+    const char* start = ++ps->p;
+    const char* end = start;
+    while (*end && *end != '"') {
+        if (*end == '\\' && end[1]) end++;
+        end++;
+    }
+    if (*end != '"') return NULL;
+
+    char* out = malloc((size_t)(end - start) + 1);
+    if (!out) return NULL;
+
+    int n = 0;
+    const char* p = start;
+    while (p < end) {
+        if (*p != '\\') {
+            out[n++] = *p++;
+            continue;
+        }
+        p++;
+        switch (*p) {
+            case 'n': out[n++] = '\n'; p++; break;
+            case 't': out[n++] = '\t'; p++; break;
+            case 'r': out[n++] = '\r'; p++; break;
+            case 'b': out[n++] = '\b'; p++; break;
+            case 'f': out[n++] = '\f'; p++; break;
+            case 'u': {
+                unsigned int cp;
+                if (end - p < 5 || hex4(p + 1, &cp) != 0) { free(out); return NULL; }
+                p += 5;
+                // Paire de substitution UTF-16
+                if (cp >= 0xD800 && cp <= 0xDBFF && end - p >= 6 &&
+                    p[0] == '\\' && p[1] == 'u') {
+                    unsigned int lo;
+                    if (hex4(p + 2, &lo) == 0 && lo >= 0xDC00 && lo <= 0xDFFF) {
+                        cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+                        p += 6;
+                    }
+                }
+                if (cp < 0x80) {
+                    out[n++] = (char)cp;
+                } else if (cp < 0x800) {
+                    out[n++] = (char)(0xC0 | (cp >> 6));
+                    out[n++] = (char)(0x80 | (cp & 0x3F));
+                } else if (cp < 0x10000) {
+                    out[n++] = (char)(0xE0 | (cp >> 12));
+                    out[n++] = (char)(0x80 | ((cp >> 6) & 0x3F));
+                    out[n++] = (char)(0x80 | (cp & 0x3F));
+                } else {
+                    out[n++] = (char)(0xF0 | (cp >> 18));
+                    out[n++] = (char)(0x80 | ((cp >> 12) & 0x3F));
+                    out[n++] = (char)(0x80 | ((cp >> 6) & 0x3F));
+                    out[n++] = (char)(0x80 | (cp & 0x3F));
+                }
+                break;
+            }
+            default: out[n++] = *p++; break;   // \" \\ \/
+        }
+    }
+    out[n] = '\0';
+    ps->p = end + 1;
+    return out;
+}
+
+static int push_item(json_value_t* container, json_value_t* item, char* key) {
+    if ((container->count & (container->count - 1)) == 0) {
+        int cap = container->count ? container->count * 2 : 1;
+        json_value_t* items = realloc(container->items, cap * sizeof(json_value_t));
+        if (!items) return -1;
+        container->items = items;
+        if (container->type == JSON_OBJECT) {
+            char** keys = realloc(container->keys, cap * sizeof(char*));
+            if (!keys) return -1;
+            container->keys = keys;
+        }
+    }
+    container->items[container->count] = *item;
+    if (container->type == JSON_OBJECT) container->keys[container->count] = key;
+    container->count++;
+    return 0;
+}
+
+static void free_members(json_value_t* v);
+
+// En cas d'erreur, les éléments déjà ajoutés restent dans out : l'appelant
+// libère l'ensemble.
+static int parse_container(json_parser_t* ps, json_value_t* out, char close) {
+    out->type = (close == '}') ? JSON_OBJECT : JSON_ARRAY;
+    if (++ps->depth > JSON_MAX_DEPTH) return -1;
+    ps->p++;
+    skip_ws(ps);
+    if (*ps->p == close) {
+        ps->p++;
+        ps->depth--;
+        return 0;
+    }
+
+    for (;;) {
+        char* key = NULL;
+        json_value_t item;
+        memset(&item, 0, sizeof(item));
+
+        skip_ws(ps);
+        if (out->type == JSON_OBJECT) {
+            key = parse_string(ps);
+            if (!key) return -1;
+            skip_ws(ps);
+            if (*ps->p != ':') { free(key); return -1; }
+            ps->p++;
+        }
+        if (parse_value(ps, &item) != 0 || push_item(out, &item, key) != 0) {
+            free(key);
+            free_members(&item);
+            return -1;
+        }
+
+        skip_ws(ps);
+        if (*ps->p == ',') {
+            ps->p++;
+        } else if (*ps->p == close) {
+            ps->p++;
+            ps->depth--;
+            return 0;
+        } else {
+            return -1;
+        }
+    }
+}
+
+static int parse_value(json_parser_t* ps, json_value_t* out) {
+    skip_ws(ps);
+    switch (*ps->p) {
+        case '{': return parse_container(ps, out, '}');
+        case '[': return parse_container(ps, out, ']');
+        case '"':
+            out->type   = JSON_STRING;
+            out->string = parse_string(ps);
+            return out->string ? 0 : -1;
+        case 't':
+            if (strncmp(ps->p, "true", 4) != 0) return -1;
+            out->type = JSON_BOOL; out->boolean = 1; ps->p += 4;
+            return 0;
+        case 'f':
+            if (strncmp(ps->p, "false", 5) != 0) return -1;
+            out->type = JSON_BOOL; out->boolean = 0; ps->p += 5;
+            return 0;
+        case 'n':
+            if (strncmp(ps->p, "null", 4) != 0) return -1;
+            out->type = JSON_NULL; ps->p += 4;
+            return 0;
+        default: {
+            char* end;
+            out->type   = JSON_NUMBER;
+            out->number = strtod(ps->p, &end);
+            if (end == ps->p) return -1;
+            ps->p = end;
+            return 0;
+        }
+    }
+}
+
+static void free_members(json_value_t* v) {
+    if (v->type == JSON_STRING) {
+        free(v->string);
+    } else if (v->type == JSON_ARRAY || v->type == JSON_OBJECT) {
+        for (int i = 0; i < v->count; i++) {
+            free_members(&v->items[i]);
+            if (v->keys) free(v->keys[i]);
+        }
+        free(v->items);
+        free(v->keys);
+    }
+}
+
+json_value_t* json_parse(const char* text) {
+    json_parser_t ps = { text, 0 };
+    json_value_t* v = calloc(1, sizeof(json_value_t));
+    if (!v) return NULL;
+
+    if (parse_value(&ps, v) != 0) {
+        free_members(v);
+        free(v);
+        return NULL;
+    }
+    skip_ws(&ps);
+    if (*ps.p != '\0') {
+        json_free(v);
+        return NULL;
+    }
+    return v;
+}
+
+void json_free(json_value_t* value) {
+    if (!value) return;
+    free_members(value);
+    free(value);
+}
+
+const json_value_t* json_get(const json_value_t* object, const char* key) {
+    if (!object || object->type != JSON_OBJECT) return NULL;
+    for (int i = 0; i < object->count; i++) {
+        if (strcmp(object->keys[i], key) == 0) return &object->items[i];
+    }
+    return NULL;
+}
+
+const char* json_get_string(const json_value_t* object, const char* key) {
+    const json_value_t* v = json_get(object, key);
+    return (v && v->type == JSON_STRING) ? v->string : NULL;
+}
+
+double json_get_number(const json_value_t* object, const char* key, double fallback) {
+    const json_value_t* v = json_get(object, key);
+    return (v && v->type == JSON_NUMBER) ? v->number : fallback;
+}
+
+// ── Écriture ──────────────────────────────────────────────────────────────
+
+void json_buf_init(json_buf_t* buf) {
+    buf->data = NULL;
+    buf->len  = 0;
+    buf->cap  = 0;
+}
+
+void json_buf_free(json_buf_t* buf) {
+    free(buf->data);
+    json_buf_init(buf);
+}
+
+static int buf_reserve(json_buf_t* buf, int extra) {
+    if (buf->len + extra + 1 <= buf->cap) return 0;
+    int cap = buf->cap ? buf->cap : 256;
+    while (cap < buf->len + extra + 1) cap *= 2;
+    char* data = realloc(buf->data, cap);
+    if (!data) return -1;
+    buf->data = data;
+    buf->cap  = cap;
+    return 0;
+}
+
+void json_buf_printf(json_buf_t* buf, const char* fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(NULL, 0, fmt, ap);
+    va_end(ap);
+    if (n < 0 || buf_reserve(buf, n) != 0) return;
+
+    va_start(ap, fmt);
+    vsnprintf(buf->data + buf->len, buf->cap - buf->len, fmt, ap);
+    va_end(ap);
+    buf->len += n;
+}
+
+void json_buf_string(json_buf_t* buf, const char* s) {
+    if (buf_reserve(buf, (int)strlen(s) * 6 + 2) != 0) return;
+    buf->data[buf->len++] = '"';
+    for (; *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') {
+            buf->data[buf->len++] = '\\';
+            buf->data[buf->len++] = (char)c;
+        } else if (c == '\n') {
+            buf->data[buf->len++] = '\\';
+            buf->data[buf->len++] = 'n';
+        } else if (c < 0x20) {
+            buf->len += snprintf(buf->data + buf->len, 7, "\\u%04x", c);
+        } else {
+            buf->data[buf->len++] = (char)c;
+        }
+    }
+    buf->data[buf->len++] = '"';
+    buf->data[buf->len] = '\0';
+}
+
+void json_buf_value(json_buf_t* buf, const json_value_t* value) {
+    if (!value) {
+        json_buf_printf(buf, "null");
+        return;
+    }
+    switch (value->type) {
+        case JSON_NULL:   json_buf_printf(buf, "null"); break;
+        case JSON_BOOL:   json_buf_printf(buf, value->boolean ? "true" : "false"); break;
+        case JSON_NUMBER: json_buf_printf(buf, "%.17g", value->number); break;
+        case JSON_STRING: json_buf_string(buf, value->string); break;
+        case JSON_ARRAY:
+        case JSON_OBJECT:
+            json_buf_printf(buf, value->type == JSON_ARRAY ? "[" : "{");
+            for (int i = 0; i < value->count; i++) {
+                if (i > 0) json_buf_printf(buf, ",");
+                if (value->type == JSON_OBJECT) {
+                    json_buf_string(buf, value->keys[i]);
+                    json_buf_printf(buf, ":");
+                }
+                json_buf_value(buf, &value->items[i]);
+            }
+            json_buf_printf(buf, value->type == JSON_ARRAY ? "]" : "}");
+            break;
+    }
+}
@@ -1,19 +1,23 @@
 // main.c
-#include <windows.h>
+#include "header/compat.h"
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "header/partitioning.h"
-#include "header/iso_writer.h"
 #include "header/bcd_manager.h"
-
-#define TEMP_DRIVE_LETTER  'P'
-#define BCD_BACKUP_PATH    "C:\\Windows\\Temp\\pleco_bcd_backup.bcd"
-#define ISO_SIZE_EXTRA_MB  512
+#include "header/staging.h"
+#include "header/digest.h"
+#include "header/pipeline.h"
+#include "header/rpc.h"
+#include "header/vdisk.h"
+#include "header/io_policy.h"
+#include "header/bench.h"
+#include "header/io_tuner.h"
 
 // ── Callback de progression ───────────────────────────────────────────────
 // Signature : (unsigned long long, unsigned long long) pour correspondre
-// au typedef dans iso_writer.h
+// au typedef dans utils.h
 
 void on_progress(unsigned long long written, unsigned long long total) {
     int percent = (total > 0) ? (int)((written * 100ULL) / total) : 0;
@@ -23,190 +27,240 @@ void on_progress(unsigned long long written, unsigned long long total) {
     fflush(stdout);
 }
 
-// ── Vérifier les droits admin ─────────────────────────────────────────────
-
-int is_admin(void) {
-    BOOL result = FALSE;
-    HANDLE token;
-    if (OpenProcessToken(GetCurrentProcess(), TOKEN_QUERY, &token)) {
-        TOKEN_ELEVATION elevation;
-        DWORD size;
-        if (GetTokenInformation(token, TokenElevation, &elevation,
-                                sizeof(elevation), &size)) {
-            result = elevation.TokenIsElevated;
-        }
-        CloseHandle(token);
-    }
-    return result;
-}
+// ── Copie par inventaire ──────────────────────────────────────────────────
+// Lecture directe des ISO et écriture directe du FAT32 de la partition
+// temporaire, avant son montage : une image seule ou plusieurs.
 
-// ── Redémarrage ───────────────────────────────────────────────────────────
+static int run_staged(const char* install_mode, const char* const* iso_paths,
+                      const char* const* hashes, int count) {
+    char bcd_ids[STAGING_MAX_IMAGES][BCD_ID_MAX] = {{0}};
 
-void reboot_in_seconds(int seconds) {
-    char cmd[256];
-    snprintf(cmd, sizeof(cmd),
-        "shutdown /r /t %d /c \"Pleco va demarrer l'installateur Linux\"",
-        seconds);
-    system(cmd);
-}
+    printf("[Info] Mode   : %s\n", install_mode);
+    printf("[Info] Images : %d\n\n", count);
 
-// ── Nettoyage d'urgence ───────────────────────────────────────────────────
+    // Sur un vrai disque, inutile de hacher les ISO sans la marge minimale
+    if (!vdisk_is_open() && !check_free_space(MIN_FREE_SPACE_MB)) return 1;
 
-void emergency_cleanup(const char* bcd_id) {
-    fprintf(stderr, "\n[Pleco] Nettoyage en cours...\n");
+    // ── Étape 1 : Vérifier les hash ───────────────────────────────────────
 
-    if (bcd_id && strlen(bcd_id) > 0) {
-        fprintf(stderr, "[Pleco] Suppression entree BCD %s...\n", bcd_id);
-        bcd_delete_entry(bcd_id);
+    printf("\n[Etape 1/5] Verification des ISO...\n");
+    for (int i = 0; i < count; i++) {
+        printf("[Info] ISO %d : %s\n", i + 1, iso_paths[i]);
+        if (!verify_iso_digest(iso_paths[i], hashes[i], NULL)) {
+            fprintf(stderr, "[Erreur] Hash incorrect ou ISO corrompu.\n");
+            return 1;
+        }
     }
 
-    fprintf(stderr, "[Pleco] Restauration BCD original...\n");
-    if (bcd_restore(BCD_BACKUP_PATH) == 0) {
-        fprintf(stderr, "[Pleco] BCD restaure.\n");
-    } else {
-        fprintf(stderr,
-            "[ATTENTION] Restauration automatique echouee.\n"
-            "            Commande manuelle : bcdedit /import \"%s\"\n",
-            BCD_BACKUP_PATH);
+    staging_plan_t plan;
+    if (staging_plan(&plan, iso_paths, count, NULL) != 0) {
+        fprintf(stderr, "[Erreur] Analyse des ISO echouee.\n");
+        return 1;
     }
 
-    fprintf(stderr, "[Pleco] Suppression partition temporaire...\n");
-    delete_partition(TEMP_DRIVE_LETTER);
-
-    fprintf(stderr, "[Pleco] Nettoyage termine.\n\n");
-}
+    // Les noyaux et initrd communs à plusieurs images ne sont écrits
+    // qu'une fois (magasin, staging.h)
+    unsigned int partition_size_mb = staging_required_mb(&plan) + ISO_SIZE_EXTRA_MB;
+    if (!check_free_space(required_space_mb(partition_size_mb))) {
+        staging_free(&plan);
+        return 1;
+    }
 
-// ── Point d'entrée ────────────────────────────────────────────────────────
+    // ── Étape 2 : Sauvegarder le BCD ─────────────────────────────────────
 
-int main(int argc, char* argv[]) {
+    printf("\n[Etape 2/5] Sauvegarde BCD...\n");
+    if (bcd_backup(BCD_BACKUP_PATH) != 0) {
+        fprintf(stderr, "[Erreur] Sauvegarde BCD echouee. Abandon.\n");
+        staging_free(&plan);
+        return 1;
+    }
 
-    printf("=== Pleco - Linux Installer ===\n\n");
+    // ── Étape 3 : Créer la partition ──────────────────────────────────────
 
-    if (!is_admin()) {
-        fprintf(stderr,
-            "[Erreur] Droits administrateur requis.\n"
-            "         Clic droit -> Executer en tant qu'administrateur.\n");
+    printf("\n[Etape 3/5] Creation de la partition (%u Mo)...\n", partition_size_mb);
+    temp_partition_t part;
+    if (temp_partition_prepare(&part, partition_size_mb, TEMP_DRIVE_LETTER) != 0) {
+        fprintf(stderr, "[Erreur] Creation partition echouee.\n");
+        staging_free(&plan);
+        emergency_cleanup(NULL);
         return 1;
     }
-    printf("[OK] Droits administrateur confirmes.\n");
 
-    if (argc < 4) {
-        fprintf(stderr,
-            "Usage: pleco.exe <iso_path> <sha256_hash> <dualboot|replace>\n"
-            "Ex:    pleco.exe ubuntu.iso abc123... dualboot\n");
+    // ── Étape 4 : Copier les images ───────────────────────────────────────
+    // Copie sur la partition pas encore montée, qui n'est inscrite dans la
+    // table qu'une fois remplie.
+
+    printf("\n[Etape 4/5] Copie de %d image(s) vers %c:...\n", count, TEMP_DRIVE_LETTER);
+    int copied = staging_execute(&plan, &part, on_progress);
+    staging_free(&plan);
+    if (copied != 0) {
+        fprintf(stderr, "[Erreur] Copie des images echouee.\n");
+        temp_partition_abort(&part);
+        emergency_cleanup(NULL);
+        return 1;
+    }
+    if (temp_partition_commit(&part) != 0) {
+        fprintf(stderr, "[Erreur] Montage de la partition echoue.\n");
+        emergency_cleanup(NULL);
         return 1;
     }
 
-    const char* iso_path     = argv[1];
-    const char* iso_hash     = argv[2];
-    const char* install_mode = argv[3];
+    // ── Étape 5 : Une entrée BCD par image ────────────────────────────────
 
-    char bcd_id[BCD_ID_MAX]  = {0};
-    char efi_path[MAX_PATH]  = {0};
+    printf("\n[Etape 5/5] Configuration du demarrage...\n");
+    if (configure_staged_boot(&plan, bcd_ids) != 0) {
+        return 1;
+    }
 
-    printf("[Info] ISO  : %s\n", iso_path);
-    printf("[Info] Mode : %s\n\n", install_mode);
+    printf("\n");
+    printf("╔══════════════════════════════════════╗\n");
+    printf("║   Installation prete !               ║\n");
+    printf("║   Redemarrage dans 10 secondes...    ║\n");
+    printf("╚══════════════════════════════════════╝\n\n");
 
-    // ── Étape 0 : Espace disponible ───────────────────────────────────────
+    reboot_in_seconds(10);
+    return 0;
+}
 
-    unsigned long long free_mb = get_free_space_mb();
-    printf("[Info] Espace libre : %llu Mo\n", free_mb);
-    if (free_mb < 9000) {
-        fprintf(stderr,
-            "[Erreur] Espace insuffisant (%llu Mo, 9000 Mo requis).\n"
-            "         diskpart > select disk 0 > select partition 4\n"
-            "                  > shrink desired=15000 minimum=9000\n",
-            free_mb);
-        return 1;
-    }
+// ── Mode multi-images ─────────────────────────────────────────────────────
+// pleco.exe multi <dualboot|replace> <iso1> <hash1> [<iso2> <hash2> ...]
 
-    // ── Étape 1 : Vérifier le hash ────────────────────────────────────────
+int run_multi(int argc, char* argv[]) {
+    const char* iso_paths[STAGING_MAX_IMAGES];
+    const char* hashes[STAGING_MAX_IMAGES];
+    int         count = (argc - 3) / 2;
 
-    printf("\n[Etape 1/5] Verification de l'ISO...\n");
-    if (!verify_iso_sha256(iso_path, iso_hash)) {
-        fprintf(stderr, "[Erreur] Hash incorrect ou ISO corrompu.\n");
+    if (argc < 5 || (argc - 3) % 2 != 0 || count > STAGING_MAX_IMAGES) {
+        fprintf(stderr,
+            "Usage: pleco.exe multi <dualboot|replace> <iso1> <hash1> [<iso2> <hash2> ...]\n"
+            "       (%d images maximum)\n", STAGING_MAX_IMAGES);
         return 1;
     }
 
-    // Taille de partition nécessaire = taille ISO + marge
-    HANDLE hISO = CreateFileA(iso_path, GENERIC_READ, FILE_SHARE_READ,
-                              NULL, OPEN_EXISTING, 0, NULL);
-    if (hISO == INVALID_HANDLE_VALUE) {
-        fprintf(stderr, "[Erreur] Impossible d'ouvrir l'ISO.\n");
-        return 1;
+    for (int i = 0; i < count; i++) {
+        iso_paths[i] = argv[3 + i * 2];
+        hashes[i]    = argv[4 + i * 2];
     }
-    LARGE_INTEGER iso_size;
-    iso_size.QuadPart = 0;
-    GetFileSizeEx(hISO, &iso_size);
-    CloseHandle(hISO);
+    return run_staged(argv[2], iso_paths, hashes, count);
+}
 
-    unsigned int partition_size_mb =
-        (unsigned int)(iso_size.QuadPart / (1024 * 1024)) + ISO_SIZE_EXTRA_MB;
+// ── Point d'entrée ────────────────────────────────────────────────────────
 
-    // ── Étape 2 : Sauvegarder le BCD ─────────────────────────────────────
+int main(int argc, char* argv[]) {
 
-    printf("\n[Etape 2/5] Sauvegarde BCD...\n");
-    if (bcd_backup(BCD_BACKUP_PATH) != 0) {
-        fprintf(stderr, "[Erreur] Sauvegarde BCD echouee. Abandon.\n");
-        return 1;
+    // Options globales, dans n'importe quel ordre avant la commande :
+    //   --io <politique>      E/S des gros transferts : buffered, drop ou
+    //                         direct (voir io_policy.h)
+    //   --image <disque.img>  disque virtuel : partition, copie et BCD
+    //                         portent sur l'image au lieu du disque 0
+    // Toutes sont lues avant d'agir : l'image n'est ouverte qu'ensuite.
+    const char* image_path = NULL;
+    while (argc >= 2 && (strcmp(argv[1], "--io") == 0 || strcmp(argv[1], "--image") == 0)) {
+        if (argc < 3) {
+            fprintf(stderr, "[Erreur] Valeur manquante apres %s.\n", argv[1]);
+            return 1;
+        }
+        if (strcmp(argv[1], "--io") == 0) {
+            io_policy_t policy;
+            if (io_policy_parse(argv[2], &policy) != 0) {
+                fprintf(stderr, "[Erreur] Politique d'E/S inconnue : %s (buffered, drop, direct)\n",
+                        argv[2]);
+                return 1;
+            }
+            io_policy_set(policy);
+        } else if (image_path) {
+            fprintf(stderr, "[Erreur] --image ne peut etre donne qu'une fois.\n");
+            return 1;
+        } else {
+            image_path = argv[2];
+        }
+        argv[2] = argv[0];
+        argv += 2;
+        argc -= 2;
     }
+    if (image_path && vdisk_open(image_path) != 0) return 1;
 
-    // ── Étape 3 : Créer la partition ──────────────────────────────────────
-
-    printf("\n[Etape 3/5] Creation de la partition (%u Mo)...\n", partition_size_mb);
-    if (create_temp_partition(partition_size_mb, TEMP_DRIVE_LETTER) != 0) {
-        fprintf(stderr, "[Erreur] Creation partition echouee.\n");
-        emergency_cleanup(NULL);
-        return 1;
+    // pleco.exe mkimage <disque.img> <taille_mo> [windows_mo]
+    if (argc >= 4 && strcmp(argv[1], "mkimage") == 0) {
+        unsigned int system_mb = argc >= 5 ? (unsigned int)strtoul(argv[4], NULL, 10) : 1024;
+        return vdisk_create(argv[2], (unsigned int)strtoul(argv[3], NULL, 10), system_mb) == 0 ? 0 : 1;
     }
 
-    Sleep(3000);
+    // pleco.exe bench <fichier> [politique] : sans argument, les trois
+    if (argc >= 3 && strcmp(argv[1], "bench") == 0) {
+        io_policy_t policy = IO_POLICY_DIRECT;
+        if (argc >= 4 && io_policy_parse(argv[3], &policy) != 0) {
+            fprintf(stderr, "[Erreur] Politique d'E/S inconnue : %s\n", argv[3]);
+            return 1;
+        }
+        return bench_run(argv[2], argc >= 4 ? (int)policy : -1) == 0 ? 0 : 1;
+    }
 
-    // ── Étape 4 : Copier les fichiers ISO ─────────────────────────────────
+    // pleco.exe tune <fichier> [dossier] : remesure le périphérique du
+    // fichier (lecture) et celui du dossier (écriture), même s'ils ont
+    // déjà un profil enregistré.
+    if (argc >= 3 && strcmp(argv[1], "tune") == 0) {
+        io_profile_t profile;
+        io_tune_refresh(1);
+        int rc = io_tune_source(argv[2], &profile);
+        if (argc >= 4 && io_tune_target(argv[3], &profile) != 0) rc = -1;
+        return rc == 0 ? 0 : 1;
+    }
 
-    printf("\n[Etape 4/5] Copie de l'ISO vers %c:...\n", TEMP_DRIVE_LETTER);
-    if (write_iso_to_partition(iso_path, TEMP_DRIVE_LETTER, on_progress,
-                               efi_path, sizeof(efi_path)) != 0) {
-        fprintf(stderr, "[Erreur] Copie ISO echouee.\n");
-        emergency_cleanup(NULL);
+#ifndef _WIN32
+    // Hors Windows, seul le disque virtuel est disponible
+    if (!vdisk_is_open()) {
+        fprintf(stderr, "[Erreur] Hors Windows, --image <disque.img> est obligatoire.\n");
         return 1;
     }
-    printf("\n");
+#endif
+
+    // Mode serveur : stdout est réservé au protocole, pas de bannière.
+    // Les droits admin sont vérifiés par méthode.
+    // pleco.exe serve [--pipe <nom>]
+    if (argc >= 2 && strcmp(argv[1], "serve") == 0) {
+        const char* pipe_name = (argc >= 4 && strcmp(argv[2], "--pipe") == 0) ? argv[3] : NULL;
+        return rpc_serve(pipe_name);
+    }
+
+    printf("=== Pleco - Linux Installer ===\n\n");
 
-    // Vérifier que le chemin EFI a bien été détecté
-    if (strlen(efi_path) == 0) {
+    if (vdisk_is_open()) {
+        printf("[Info] Disque virtuel : %s (droits administrateur non requis)\n",
+               vdisk_path());
+    } else if (!is_admin()) {
         fprintf(stderr,
-            "[Erreur] Chemin EFI non detecte. ISO non UEFI ?\n");
-        emergency_cleanup(NULL);
+            "[Erreur] Droits administrateur requis.\n"
+            "         Clic droit -> Executer en tant qu'administrateur.\n");
         return 1;
+    } else {
+        printf("[OK] Droits administrateur confirmes.\n");
     }
-    printf("[Pleco] Chemin EFI : %s\n", efi_path);
-
-    // ── Étape 5 : Configurer le BCD ───────────────────────────────────────
-    // Uniquement si la copie ISO a réussi
-
-    printf("\n[Etape 5/5] Configuration du demarrage...\n");
 
-    if (bcd_create_entry("Pleco Linux Installer", bcd_id) != 0) {
-        fprintf(stderr, "[Erreur] Creation entree BCD echouee.\n");
-        emergency_cleanup(NULL);
-        return 1;
+    if (argc >= 2 && strcmp(argv[1], "multi") == 0) {
+        return run_multi(argc, argv);
     }
 
-    if (bcd_configure_entry(bcd_id, TEMP_DRIVE_LETTER, efi_path) != 0) {
-        fprintf(stderr, "[Erreur] Configuration BCD echouee.\n");
-        emergency_cleanup(bcd_id);
+    if (argc < 4) {
+        fprintf(stderr,
+            "Usage: pleco.exe <iso_path> <hash> <dualboot|replace>\n"
+            "       pleco.exe multi <dualboot|replace> <iso1> <hash1> [<iso2> <hash2> ...]\n"
+            "       pleco.exe serve [--pipe <nom>]   (JSON-RPC pour l'interface)\n"
+            "       pleco.exe mkimage <disque.img> <taille_mo> [windows_mo]\n"
+            "       pleco.exe [--image <disque.img>] [--io <buffered|drop|direct>] <commande...>\n"
+            "                 (disque virtuel ; E/S, defaut direct ; options dans tout ordre)\n"
+            "       pleco.exe bench <fichier> [buffered|drop|direct]   (debits des E/S)\n"
+            "       pleco.exe tune <fichier> [dossier]   (remesure les peripheriques)\n"
+            "       <hash> : SHA-256/SHA-512 hexa, sha256:/sha512:/blake3:<hexa>,\n"
+            "                fichier SHA256SUMS... ou liste separee par des virgules\n"
+            "Ex:    pleco.exe ubuntu.iso abc123... dualboot\n"
+            "       pleco.exe ubuntu.iso SHA256SUMS dualboot\n");
         return 1;
     }
 
-    // ── Succès ────────────────────────────────────────────────────────────
-
-    printf("\n");
-    printf("╔══════════════════════════════════════╗\n");
-    printf("║   Installation prete !               ║\n");
-    printf("║   Redemarrage dans 10 secondes...    ║\n");
-    printf("╚══════════════════════════════════════╝\n\n");
+    const char* iso_path     = argv[1];
+    const char* iso_hash     = argv[2];   // hash ou manifeste
+    const char* install_mode = argv[3];
 
-    reboot_in_seconds(10);
-    return 0;
+    return run_staged(install_mode, &iso_path, &iso_hash, 1);
 }
@@ -1,95 +1,296 @@
 // partitioning.c
 #include "header/partitioning.h"
-#include "header/utils.h"
-#include <windows.h>
+#include "header/gpt.h"
+#include "header/fat32.h"
+#include "header/vdisk.h"
+#include "header/compat.h"
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
-int create_temp_partition(unsigned int size_mb, char drive_letter) {
-    char script[1024];
-    char output[8192];
-
-    // Sur disque GPT (Windows 11 utilise toujours GPT) :
-    // - "efi" crée une partition de type EFI System Partition (ESP)
-    // - format fs=fat32 est obligatoire pour une ESP
-    // - L'UUID GPT EFI = c12a7328-f81f-11d2-ba4b-00a0c93ec93b est assigné
-    //   automatiquement par "create partition efi"
-    snprintf(script, sizeof(script),
-        "select disk 0\n"
-        "create partition efi size=%u\n"
-        "format fs=fat32 quick label=\"PLECO_TEMP\"\n"
-        "assign letter=%c\n"
-        "exit\n",
-        size_mb, drive_letter
-    );
+#define MB_BYTES        (1024ULL * 1024ULL)
+#define VOLUME_WAIT_MS  10000   // arrivée du volume après la relecture de la table
+#define VOLUME_POLL_MS  100
 
+#ifdef _WIN32
+
+// Disque et position du volume (\\?\Volume{...}\), premier extent
+static int volume_extent(const char* volume, DWORD* disk_number, unsigned long long* offset) {
+    char path[MAX_PATH];
+    snprintf(path, sizeof(path), "%s", volume);
+    size_t len = strlen(path);
+    if (len > 0 && path[len - 1] == '\\') path[len - 1] = '\0';
+
+    HANDLE h = CreateFileA(path, 0, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                           OPEN_EXISTING, 0, NULL);
+    if (h == INVALID_HANDLE_VALUE) return -1;
+
+    VOLUME_DISK_EXTENTS extents;
+    DWORD               returned;
+    BOOL ok = DeviceIoControl(h, IOCTL_VOLUME_GET_VOLUME_DISK_EXTENTS, NULL, 0,
+                              &extents, sizeof(extents), &returned, NULL);
+    CloseHandle(h);
+    if (!ok || extents.NumberOfDiskExtents == 0) return -1;
+
+    *disk_number = extents.Extents[0].DiskNumber;
+    *offset      = (unsigned long long)extents.Extents[0].StartingOffset.QuadPart;
+    return 0;
+}
+
+// Volume commençant à offset sur le disque ; -1 tant que Windows ne l'a
+// pas encore monté
+static int find_volume(DWORD disk_number, unsigned long long offset, char* out, size_t size) {
+    char   name[MAX_PATH];
+    HANDLE find = FindFirstVolumeA(name, sizeof(name));
+    if (find == INVALID_HANDLE_VALUE) return -1;
+
+    int found = 0;
+    do {
+        DWORD              number;
+        unsigned long long start;
+        if (volume_extent(name, &number, &start) == 0 && number == disk_number &&
+            start == offset) {
+            snprintf(out, size, "%s", name);
+            found = 1;
+        }
+    } while (!found && FindNextVolumeA(find, name, sizeof(name)));
+    FindVolumeClose(find);
+    return found ? 0 : -1;
+}
+
+// Attend le volume de la nouvelle partition et lui attribue la lettre
+static int assign_letter(const gpt_disk_t* disk, unsigned long long offset, char drive_letter) {
+    char root[4];
+    char volume[MAX_PATH];
+    snprintf(root, sizeof(root), "%c:\\", drive_letter);
+
+    for (int waited = 0; waited < VOLUME_WAIT_MS; waited += VOLUME_POLL_MS) {
+        if (find_volume((DWORD)disk->number, offset, volume, sizeof(volume)) == 0) {
+            if (SetVolumeMountPointA(root, volume)) return 0;
+            fprintf(stderr, "[Erreur] Attribution de la lettre %c: impossible (code %lu).\n",
+                    drive_letter, GetLastError());
+            return -1;
+        }
+        Sleep(VOLUME_POLL_MS);
+    }
+    fprintf(stderr, "[Erreur] Le volume de la nouvelle partition n'est pas apparu.\n");
+    return -1;
+}
+
+// Entrée GPT commençant à offset octets, -1 si aucune
+static int find_entry(const gpt_table_t* table, unsigned long long offset) {
+    for (int i = 0; i < GPT_ENTRY_COUNT; i++) {
+        const gpt_entry_t* e = &table->entries[i];
+        if (gpt_entry_used(e) && e->first_lba * table->disk->sector_size == offset) return i;
+    }
+    return -1;
+}
+
+#endif
+
+// ── Partition temporaire ──────────────────────────────────────────────────
+
+int temp_partition_prepare(temp_partition_t* part, unsigned int size_mb, char drive_letter) {
+    memset(part, 0, sizeof(*part));
+    part->drive_letter = drive_letter;
     printf("[Pleco] Creation de la partition EFI (%u Mo, lettre %c:)...\n",
            size_mb, drive_letter);
 
-    run_process_with_input("diskpart", script, output, sizeof(output));
-    printf("[Debug] Sortie diskpart :\n%s\n", output);
+    if (vdisk_is_open()) {
+        unsigned long long size;
+        if (vdisk_create_partition(size_mb, drive_letter) != 0 ||
+            vdisk_find_partition(drive_letter, &part->offset, &size) != 0) {
+            return -1;
+        }
+        part->disk    = vdisk_device();
+        part->sectors = size / part->disk->sector_size;
+        return 0;
+    }
 
-    Sleep(3000);
+    // Entrée GPT de type EFI System Partition
+    // (C12A7328-F81F-11D2-BA4B-00A0C93EC93B) sur le disque du volume
+    // Windows. La zone est formatée (et remplie) avant l'entrée : à la
+    // relecture de la table, Windows trouve directement un volume complet.
+    gpt_table_t* table = malloc(sizeof(gpt_table_t));
+    if (!table || gpt_open_system_disk(&part->system) != 0) {
+        free(table);
+        return -1;
+    }
+    part->disk = &part->system;
 
-    // Vérification réelle : le volume existe-t-il ?
-    char volume_path[8];
-    snprintf(volume_path, sizeof(volume_path), "%c:\\", drive_letter);
+    gpt_disk_t*        disk    = part->disk;
+    int                rc      = gpt_load(table, disk);
+    unsigned long long sectors = (unsigned long long)size_mb * MB_BYTES / disk->sector_size;
+    unsigned long long first   = rc == 0 ? gpt_find_free(table, sectors, NULL) : 0;
+    free(table);
+    if (rc == 0 && !first) {
+        fprintf(stderr, "[Erreur] Pas d'espace non alloue de %u Mo sur le disque %lu.\n",
+                size_mb, disk->number);
+        fprintf(stderr, "  -> Reduire C: (Gestion des disques, \"Reduire le volume\").\n");
+        rc = -1;
+    }
 
-    if (GetFileAttributesA(volume_path) == INVALID_FILE_ATTRIBUTES) {
-        fprintf(stderr, "[Erreur] La partition %c: n'existe pas apres diskpart.\n",
-                drive_letter);
-        fprintf(stderr, "  1. Espace insuffisant -> shrink desired=15000\n");
-        fprintf(stderr, "  2. Sortie diskpart :\n%s\n", output);
+    part->offset  = first * disk->sector_size;
+    part->sectors = sectors;
+    if (rc == 0) {
+        rc = fat32_format(disk, part->offset, sectors * disk->sector_size, "PLECO_TEMP",
+                          (unsigned int)first);
+    }
+    if (rc != 0) {
+        temp_partition_abort(part);
         return -1;
     }
+    return 0;
+}
 
-    // Vérification en écriture
-    char test_file[32];
-    snprintf(test_file, sizeof(test_file), "%c:\\pleco_test.tmp", drive_letter);
-    HANDLE hTest = CreateFileA(test_file, GENERIC_WRITE, 0, NULL,
-                               CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
-    if (hTest == INVALID_HANDLE_VALUE) {
-        fprintf(stderr, "[Erreur] Partition %c: non accessible en ecriture (code %lu).\n",
-                drive_letter, GetLastError());
-        return -1;
+void temp_partition_abort(temp_partition_t* part) {
+    if (part->disk == &part->system) {
+        gpt_close(&part->system);
+    } else if (part->disk) {
+        vdisk_delete_partition(part->drive_letter);
+    }
+    part->disk = NULL;
+}
+
+int temp_partition_commit(temp_partition_t* part) {
+    if (part->disk != &part->system) {
+        part->disk = NULL;
+        return 0;                                    // disque virtuel : déjà inscrite
+    }
+
+#ifdef _WIN32
+    gpt_disk_t*        disk  = part->disk;
+    unsigned long long first = part->offset / disk->sector_size;
+    unsigned long long last  = first + part->sectors - 1;
+    gpt_table_t*       table = malloc(sizeof(gpt_table_t));
+    int                rc    = table ? gpt_load(table, disk) : -1;
+
+    // La table a pu changer pendant la copie : la zone doit être restée libre
+    for (int i = 0; rc == 0 && i < GPT_ENTRY_COUNT; i++) {
+        const gpt_entry_t* e = &table->entries[i];
+        if (gpt_entry_used(e) && e->first_lba <= last && first <= e->last_lba) {
+            fprintf(stderr, "[Erreur] La zone de la partition a ete attribuee entre-temps.\n");
+            rc = -1;
+        }
+    }
+    if (rc == 0) rc = gpt_add(table, GPT_TYPE_ESP, first, part->sectors, "PLECO_TEMP") < 0 ? -1 : 0;
+    if (rc == 0) rc = gpt_store(table);
+    if (rc == 0) {
+        gpt_rescan(disk);
+        printf("[Info] Partition ajoutee au disque %lu (LBA %llu).\n", disk->number, first);
+        if (assign_letter(disk, part->offset, part->drive_letter) != 0) {
+            // Entrée retirée : le disque revient à son état initial
+            int index = find_entry(table, part->offset);
+            if (index >= 0) {
+                gpt_remove(table, index);
+                if (gpt_store(table) == 0) gpt_rescan(disk);
+            }
+            rc = -1;
+        }
+    }
+    gpt_close(disk);
+    part->disk = NULL;
+    free(table);
+    if (rc != 0) return -1;
+
+    // La lettre existe dès SetVolumeMountPointA, le montage du FAT32 peut
+    // suivre un peu plus tard : on l'attend au lieu d'une pause fixe.
+    char root[4];
+    snprintf(root, sizeof(root), "%c:\\", part->drive_letter);
+    for (int waited = 0;
+         !GetVolumeInformationA(root, NULL, 0, NULL, NULL, NULL, NULL, 0);
+         waited += VOLUME_POLL_MS) {
+        if (waited >= VOLUME_WAIT_MS) {
+            fprintf(stderr, "[Erreur] La partition %c: n'est pas accessible (code %lu).\n",
+                    part->drive_letter, GetLastError());
+            return -1;
+        }
+        Sleep(VOLUME_POLL_MS);
     }
-    CloseHandle(hTest);
-    DeleteFileA(test_file);
 
-    printf("[Pleco] Partition %c: creee et verifiee.\n", drive_letter);
+    printf("[Pleco] Partition %c: montee.\n", part->drive_letter);
     return 0;
+#else
+    return -1;
+#endif
 }
 
 int delete_partition(char drive_letter) {
-    char script[512];
-    char output[4096];
-
-    snprintf(script, sizeof(script),
-        "select disk 0\n"
-        "select volume %c\n"
-        "delete partition override\n"
-        "exit\n",
-        drive_letter
-    );
-
-    run_process_with_input("diskpart", script, output, sizeof(output));
-    Sleep(1000);
-
-    char volume_path[8];
-    snprintf(volume_path, sizeof(volume_path), "%c:\\", drive_letter);
-    if (GetFileAttributesA(volume_path) == INVALID_FILE_ATTRIBUTES) {
+    if (vdisk_is_open()) return vdisk_delete_partition(drive_letter);
+
+#ifdef _WIN32
+    // Étapes de la création en sens inverse : volume démonté et lettre
+    // retirée, puis entrée GPT effacée et table relue.
+    char               root[4];
+    char               volume[MAX_PATH];
+    DWORD              disk_number;
+    unsigned long long offset;
+    snprintf(root, sizeof(root), "%c:\\", drive_letter);
+
+    if (!GetVolumeNameForVolumeMountPointA(root, volume, sizeof(volume)) ||
+        volume_extent(volume, &disk_number, &offset) != 0) {
+        fprintf(stderr, "[Attention] Volume %c: introuvable.\n", drive_letter);
+        return -1;
+    }
+
+    char path[MAX_PATH];
+    snprintf(path, sizeof(path), "%s", volume);
+    path[strlen(path) - 1] = '\0';                   // sans la barre finale
+    HANDLE hVolume = CreateFileA(path, GENERIC_READ | GENERIC_WRITE,
+                                 FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                                 OPEN_EXISTING, 0, NULL);
+    DWORD returned;
+    if (hVolume != INVALID_HANDLE_VALUE) {
+        DeviceIoControl(hVolume, FSCTL_LOCK_VOLUME, NULL, 0, NULL, 0, &returned, NULL);
+        DeviceIoControl(hVolume, FSCTL_DISMOUNT_VOLUME, NULL, 0, NULL, 0, &returned, NULL);
+    }
+    DeleteVolumeMountPointA(root);
+
+    gpt_disk_t   disk;
+    gpt_table_t* table = malloc(sizeof(gpt_table_t));
+    int          rc    = table && gpt_open_disk(&disk, disk_number) == 0 ? 0 : -1;
+    if (rc == 0) {
+        int index = gpt_load(table, &disk) == 0 ? find_entry(table, offset) : -1;
+        rc = index >= 0 ? 0 : -1;
+        if (rc == 0) {
+            gpt_remove(table, index);
+            rc = gpt_store(table);
+        }
+        if (rc == 0) {
+            gpt_rescan(&disk);
+        }
+        gpt_close(&disk);
+    }
+    free(table);
+    if (hVolume != INVALID_HANDLE_VALUE) CloseHandle(hVolume);
+
+    if (rc == 0) {
         printf("[Pleco] Partition %c: supprimee.\n", drive_letter);
         return 0;
     }
+#endif
 
     fprintf(stderr, "[Attention] Impossible de supprimer la partition %c:.\n",
             drive_letter);
     return -1;
 }
 
+// Le plus grand espace non alloué du disque système (ou de l'image) :
+// c'est là que temp_partition_prepare taille la partition, pas dans
+// l'espace libre de C:
 unsigned long long get_free_space_mb(void) {
-    ULARGE_INTEGER free_bytes, total_bytes, total_free;
-    if (GetDiskFreeSpaceExA("C:\\", &free_bytes, &total_bytes, &total_free)) {
-        return free_bytes.QuadPart / (1024ULL * 1024ULL);
+    if (vdisk_is_open()) return vdisk_free_space_mb();
+
+    gpt_disk_t         disk;
+    unsigned long long largest = 0;
+    gpt_table_t*       table   = malloc(sizeof(gpt_table_t));
+    if (table && gpt_open_system_disk(&disk) == 0) {
+        if (gpt_load(table, &disk) == 0) {
+            gpt_find_free(table, ~0ULL, &largest);
+            largest = largest * disk.sector_size / MB_BYTES;
+        }
+        gpt_close(&disk);
     }
-    return 0;
+    free(table);
+    return largest;
 }
@@ -0,0 +1,116 @@
+// pipeline.c
+#include "header/pipeline.h"
+#include "header/partitioning.h"
+#include "header/vdisk.h"
+#include "header/compat.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ── Vérifier les droits admin ─────────────────────────────────────────────
+
+int is_admin(void) {
+#ifdef _WIN32
+    BOOL result = FALSE;
+    HANDLE token;
+    if (OpenProcessToken(GetCurrentProcess(), TOKEN_QUERY, &token)) {
+        TOKEN_ELEVATION elevation;
+        DWORD size;
+        if (GetTokenInformation(token, TokenElevation, &elevation,
+                                sizeof(elevation), &size)) {
+            result = elevation.TokenIsElevated;
+        }
+        CloseHandle(token);
+    }
+    return result;
+#else
+    return geteuid() == 0;
+#endif
+}
+
+// ── Redémarrage ───────────────────────────────────────────────────────────
+
+void reboot_in_seconds(int seconds) {
+    if (vdisk_is_open()) {
+        printf("[Info] Disque virtuel : redemarrage simule (%d s).\n", seconds);
+        return;
+    }
+
+    char cmd[256];
+    snprintf(cmd, sizeof(cmd),
+        "shutdown /r /t %d /c \"Pleco va demarrer l'installateur Linux\"",
+        seconds);
+    system(cmd);
+}
+
+// ── Nettoyage d'urgence ───────────────────────────────────────────────────
+
+void emergency_cleanup(const char* bcd_id) {
+    fprintf(stderr, "\n[Pleco] Nettoyage en cours...\n");
+
+    if (bcd_id && strlen(bcd_id) > 0) {
+        fprintf(stderr, "[Pleco] Suppression entree BCD %s...\n", bcd_id);
+        bcd_delete_entry(bcd_id);
+    }
+
+    fprintf(stderr, "[Pleco] Restauration BCD original...\n");
+    if (bcd_restore(BCD_BACKUP_PATH) == 0) {
+        fprintf(stderr, "[Pleco] BCD restaure.\n");
+    } else {
+        fprintf(stderr,
+            "[ATTENTION] Restauration automatique echouee.\n"
+            "            Commande manuelle : bcdedit /import \"%s\"\n",
+            BCD_BACKUP_PATH);
+    }
+
+    fprintf(stderr, "[Pleco] Suppression partition temporaire...\n");
+    delete_partition(TEMP_DRIVE_LETTER);
+
+    fprintf(stderr, "[Pleco] Nettoyage termine.\n\n");
+}
+
+// ── Espace disponible ─────────────────────────────────────────────────────
+
+int check_free_space(unsigned long long required_mb) {
+    unsigned long long free_mb = get_free_space_mb();
+    printf("[Info] Espace non alloue : %llu Mo\n", free_mb);
+    if (free_mb < required_mb) {
+        fprintf(stderr,
+            "[Erreur] Espace non alloue insuffisant (%llu Mo, %llu Mo requis).\n"
+            "         diskpart > select disk 0 > select partition 4\n"
+            "                  > shrink desired=15000 minimum=9000\n",
+            free_mb, required_mb);
+        return 0;
+    }
+    return 1;
+}
+
+unsigned long long required_space_mb(unsigned long long partition_mb) {
+    if (vdisk_is_open() || partition_mb > MIN_FREE_SPACE_MB) return partition_mb;
+    return MIN_FREE_SPACE_MB;
+}
+
+// ── Entrées BCD des images copiées ────────────────────────────────────────
+// bcd_configure_entry place l'entrée en tête : on configure dans l'ordre
+// inverse pour que la première image soit celle par défaut.
+
+int configure_staged_boot(const staging_plan_t* plan,
+                          char bcd_ids[][BCD_ID_MAX]) {
+    for (int i = plan->image_count - 1; i >= 0; i--) {
+        char description[128];
+        snprintf(description, sizeof(description), "Pleco - %s", plan->images[i].name);
+        printf("[Pleco] Chemin EFI : %s\n", plan->images[i].efi_path);
+
+        bcd_ids[i][0] = '\0';
+        if (bcd_create_entry(description, bcd_ids[i]) != 0 ||
+            bcd_configure_entry(bcd_ids[i], TEMP_DRIVE_LETTER,
+                                plan->images[i].efi_path) != 0) {
+            fprintf(stderr, "[Erreur] Configuration BCD echouee (%s).\n",
+                    plan->images[i].name);
+            for (int j = plan->image_count - 1; j > i; j--) bcd_delete_entry(bcd_ids[j]);
+            emergency_cleanup(bcd_ids[i]);
+            return -1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,923 @@
+// rpc.c
+#include "header/rpc.h"
+#include "header/json.h"
+#include "header/digest.h"
+#include "header/iso9660.h"
+#include "header/staging.h"
+#include "header/partitioning.h"
+#include "header/pipeline.h"
+#include "header/utils.h"
+#include "header/vdisk.h"
+#include "header/compat.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <errno.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#endif
+
+#define RPC_LINE_MAX      (1024 * 1024)
+#define RPC_INDEX_CACHE   8
+#define RPC_VERIFIED_MAX  16
+
+// Codes d'erreur JSON-RPC (les codes -32000 et au-delà sont propres à Pleco)
+#define RPC_ERR_PARSE     -32700
+#define RPC_ERR_REQUEST   -32600
+#define RPC_ERR_METHOD    -32601
+#define RPC_ERR_PARAMS    -32602
+#define RPC_ERR_FAILED    -32000
+#define RPC_ERR_BUSY      -32001
+#define RPC_ERR_CANCELLED -32800
+
+// Retourne 0 en succès (résultat JSON dans result), -1 en erreur (*error)
+typedef int (*rpc_handler_t)(const json_value_t* params, json_buf_t* result,
+                             const char** error);
+
+typedef struct {
+    const char*   name;
+    rpc_handler_t handler;
+    int           background;    // exécuté dans le thread de travail
+    int           needs_admin;
+} rpc_method_t;
+
+typedef struct {
+    const rpc_method_t* method;
+    json_value_t*       request;  // possédé par le travail
+    char*               id;       // id JSON sérialisé, NULL pour une notification
+} rpc_job_t;
+
+// Transport : stdin/stdout, canal nommé (en mode overlapped, pour que
+// lecture et écriture ne se bloquent pas mutuellement) ou socket Unix
+typedef struct {
+    HANDLE in;
+    HANDLE out;
+    int    overlapped;
+    char   buf[4096];
+    DWORD  pos;
+    DWORD  len;
+} rpc_transport_t;
+
+// Identité d'un fichier : chemin + taille + date de modification
+typedef struct {
+    char               path[MAX_PATH];
+    unsigned long long size;
+    unsigned long long mtime;
+} rpc_file_id_t;
+
+typedef struct {
+    rpc_file_id_t      file;
+    unsigned long      stamp;     // dernier accès, pour l'éviction
+    int                used;
+    iso_index_t        index;
+} rpc_index_slot_t;
+
+static struct {
+    rpc_transport_t* transport;
+    CRITICAL_SECTION out_lock;
+    int              stopping;
+
+    // Travail en cours (un seul à la fois)
+    CRITICAL_SECTION job_lock;
+    HANDLE           job_thread;
+    int              job_busy;
+    const char*      job_id;
+    int              job_percent;
+
+    // État chaud
+    staging_plan_t   plan;
+    int              plan_ready;
+    int              plan_staged;
+    char*            plan_paths[STAGING_MAX_IMAGES];
+    char             bcd_ids[STAGING_MAX_IMAGES][BCD_ID_MAX];
+    rpc_index_slot_t indexes[RPC_INDEX_CACHE];
+    unsigned long    stamp;
+
+    // ISO dont les empreintes ont été vérifiées (verify), exigées par stage
+    rpc_file_id_t    verified[RPC_VERIFIED_MAX];
+    int              verified_next;
+} server;
+
+// ── Transport ─────────────────────────────────────────────────────────────
+
+static BOOL transport_io(rpc_transport_t* t, int write, void* data, DWORD len, DWORD* n) {
+    HANDLE h = write ? t->out : t->in;
+    *n = 0;
+    if (!t->overlapped) {
+        return write ? WriteFile(h, data, len, n, NULL) : ReadFile(h, data, len, n, NULL);
+    }
+
+#ifdef _WIN32
+    OVERLAPPED ov;
+    memset(&ov, 0, sizeof(ov));
+    ov.hEvent = CreateEventA(NULL, TRUE, FALSE, NULL);
+    if (!ov.hEvent) return FALSE;
+
+    BOOL ok = write ? WriteFile(h, data, len, NULL, &ov) : ReadFile(h, data, len, NULL, &ov);
+    if (ok || GetLastError() == ERROR_IO_PENDING) ok = GetOverlappedResult(h, &ov, n, TRUE);
+    CloseHandle(ov.hEvent);
+    return ok;
+#else
+    return FALSE;                       // canal nommé : Windows seulement
+#endif
+}
+
+// Retourne 0 si une ligne a été lue, -1 en fin de flux
+static int read_line(rpc_transport_t* t, json_buf_t* line) {
+    line->len = 0;
+    if (line->data) line->data[0] = '\0';
+
+    for (;;) {
+        if (t->pos == t->len) {
+            DWORD n;
+            if (!transport_io(t, 0, t->buf, sizeof(t->buf), &n) || n == 0) return -1;
+            t->pos = 0;
+            t->len = n;
+        }
+
+        const char* start = t->buf + t->pos;
+        const char* nl    = memchr(start, '\n', t->len - t->pos);
+        DWORD       run   = nl ? (DWORD)(nl - start) : t->len - t->pos;
+
+        // Une ligne trop longue est tronquée : elle échouera à l'analyse
+        if (line->len + (int)run <= RPC_LINE_MAX) {
+            json_buf_printf(line, "%.*s", (int)run, start);
+        }
+        t->pos += run;
+        if (nl) {
+            t->pos++;
+            if (line->len > 0 && line->data[line->len - 1] == '\r') {
+                line->data[--line->len] = '\0';
+            }
+            return 0;
+        }
+    }
+}
+
+static void send_line(json_buf_t* msg) {
+    json_buf_printf(msg, "\n");
+    if (!msg->data) return;
+
+    EnterCriticalSection(&server.out_lock);
+    DWORD sent = 0;
+    while (sent < (DWORD)msg->len) {
+        DWORD n;
+        if (!transport_io(server.transport, 1, msg->data + sent,
+                          (DWORD)msg->len - sent, &n) || n == 0) {
+            break;   // client parti : la réponse est perdue
+        }
+        sent += n;
+    }
+    LeaveCriticalSection(&server.out_lock);
+}
+
+static void send_result(const char* id, const json_buf_t* result) {
+    if (!id) return;
+    json_buf_t msg;
+    json_buf_init(&msg);
+    json_buf_printf(&msg, "{\"jsonrpc\":\"2.0\",\"id\":%s,\"result\":%s}",
+                    id, (result && result->len > 0) ? result->data : "null");
+    send_line(&msg);
+    json_buf_free(&msg);
+}
+
+static void send_error(const char* id, int code, const char* message) {
+    if (!id) return;
+    json_buf_t msg;
+    json_buf_init(&msg);
+    json_buf_printf(&msg, "{\"jsonrpc\":\"2.0\",\"id\":%s,\"error\":{\"code\":%d,\"message\":",
+                    id, code);
+    json_buf_string(&msg, message);
+    json_buf_printf(&msg, "}}");
+    send_line(&msg);
+    json_buf_free(&msg);
+}
+
+// Notification de progression, limitée aux changements de pourcentage
+static void rpc_progress(unsigned long long done, unsigned long long total) {
+    int percent = (total > 0) ? (int)((done * 100ULL) / total) : 0;
+    if (percent == server.job_percent && done != total) return;
+    server.job_percent = percent;
+
+    json_buf_t msg;
+    json_buf_init(&msg);
+    json_buf_printf(&msg,
+        "{\"jsonrpc\":\"2.0\",\"method\":\"progress\","
+        "\"params\":{\"id\":%s,\"done\":%llu,\"total\":%llu}}",
+        server.job_id ? server.job_id : "null", done, total);
+    send_line(&msg);
+    json_buf_free(&msg);
+}
+
+// ── Identité des fichiers ─────────────────────────────────────────────────
+
+static int file_id(const char* path, rpc_file_id_t* out) {
+    WIN32_FILE_ATTRIBUTE_DATA attr;
+    if (strlen(path) >= sizeof(out->path) ||
+        !GetFileAttributesExA(path, GetFileExInfoStandard, &attr)) {
+        return -1;
+    }
+    memcpy(out->path, path, strlen(path) + 1);
+    out->size  = (unsigned long long)attr.nFileSizeHigh << 32 | attr.nFileSizeLow;
+    out->mtime = (unsigned long long)attr.ftLastWriteTime.dwHighDateTime << 32 |
+                 attr.ftLastWriteTime.dwLowDateTime;
+    return 0;
+}
+
+static int file_id_equal(const rpc_file_id_t* a, const rpc_file_id_t* b) {
+    return a->size == b->size && a->mtime == b->mtime && _stricmp(a->path, b->path) == 0;
+}
+
+// Une ISO modifiée depuis sa vérification n'est plus considérée vérifiée
+static int is_verified(const char* path) {
+    rpc_file_id_t id;
+    if (file_id(path, &id) != 0) return 0;
+    for (int i = 0; i < RPC_VERIFIED_MAX; i++) {
+        if (file_id_equal(&server.verified[i], &id)) return 1;
+    }
+    return 0;
+}
+
+static void set_verified(const char* path, int valid) {
+    for (int i = 0; i < RPC_VERIFIED_MAX; i++) {
+        if (_stricmp(server.verified[i].path, path) == 0) server.verified[i].path[0] = '\0';
+    }
+    rpc_file_id_t id;
+    if (!valid || file_id(path, &id) != 0) return;
+    server.verified[server.verified_next] = id;
+    server.verified_next = (server.verified_next + 1) % RPC_VERIFIED_MAX;
+}
+
+// ── Index ISO en cache ────────────────────────────────────────────────────
+// Clé : identité du fichier, éviction du moins récent. Partagé par inspect
+// et plan, qui s'exécutent tous deux dans le thread de travail.
+
+static const iso_index_t* cached_index(const char* path) {
+    rpc_file_id_t id;
+    if (file_id(path, &id) != 0) return NULL;
+
+    rpc_index_slot_t* victim = &server.indexes[0];
+    for (int i = 0; i < RPC_INDEX_CACHE; i++) {
+        rpc_index_slot_t* s = &server.indexes[i];
+        if (s->used && file_id_equal(&s->file, &id)) {
+            s->stamp = ++server.stamp;
+            return &s->index;
+        }
+        if (!s->used || (victim->used && s->stamp < victim->stamp)) victim = s;
+    }
+
+    if (victim->used) iso_index_free(&victim->index);
+    victim->used = 0;
+    if (iso_index_open(path, &victim->index) != 0) return NULL;
+
+    victim->file  = id;
+    victim->stamp = ++server.stamp;
+    victim->used  = 1;
+    return &victim->index;
+}
+
+// ── Méthodes ──────────────────────────────────────────────────────────────
+
+// inspect {path} : contenu de l'ISO sans le monter
+static int rpc_inspect(const json_value_t* params, json_buf_t* result, const char** error) {
+    const char* path = json_get_string(params, "path");
+    if (!path) {
+        *error = "Parametre path manquant";
+        return -1;
+    }
+    const iso_index_t* index = cached_index(path);
+    if (!index) {
+        *error = "Image ISO illisible";
+        return -1;
+    }
+
+    json_buf_printf(result, "{\"label\":");
+    json_buf_string(result, index->label);
+    json_buf_printf(result,
+        ",\"size\":%llu,\"rockRidge\":%s,\"joliet\":%s,"
+        "\"files\":%d,\"directories\":%d,\"fileBytes\":%llu,\"uefi\":%s,\"efiPath\":",
+        index->image_size, index->rock_ridge ? "true" : "false",
+        index->joliet ? "true" : "false", index->file_count, index->dir_count,
+        index->file_bytes, index->efi_path[0] ? "true" : "false");
+    json_buf_string(result, index->efi_path);
+    json_buf_printf(result, "}");
+    return 0;
+}
+
+// verify {path, expected} : même syntaxe que la ligne de commande
+static int rpc_verify(const json_value_t* params, json_buf_t* result, const char** error) {
+    const char* path     = json_get_string(params, "path");
+    const char* expected = json_get_string(params, "expected");
+    if (!path || !expected) {
+        *error = "Parametres path et expected requis";
+        return -1;
+    }
+    int valid = verify_iso_digest(path, expected, rpc_progress);
+    if (cancel_requested()) return -1;
+    set_verified(path, valid);
+    json_buf_printf(result, "{\"valid\":%s}", valid ? "true" : "false");
+    return 0;
+}
+
+static void drop_plan(void) {
+    if (server.plan_ready) staging_free(&server.plan);
+    for (int i = 0; i < STAGING_MAX_IMAGES; i++) {
+        free(server.plan_paths[i]);
+        server.plan_paths[i] = NULL;
+    }
+    server.plan_ready  = 0;
+    server.plan_staged = 0;
+}
+
+// plan {images: [iso, ...]} : indexe les images et garde le plan pour stage
+static int rpc_plan(const json_value_t* params, json_buf_t* result, const char** error) {
+    const json_value_t* images = json_get(params, "images");
+    if (!images || images->type != JSON_ARRAY || images->count < 1 ||
+        images->count > STAGING_MAX_IMAGES) {
+        *error = "Parametre images invalide (1 a 8 chemins)";
+        return -1;
+    }
+    if (server.plan_staged) {
+        *error = "Images deja copiees : appeler configure-boot ou cleanup";
+        return -1;
+    }
+    drop_plan();
+
+    for (int i = 0; i < images->count; i++) {
+        if (images->items[i].type != JSON_STRING) {
+            drop_plan();
+            *error = "Parametre images invalide (1 a 8 chemins)";
+            return -1;
+        }
+        server.plan_paths[i] = _strdup(images->items[i].string);
+    }
+    if (staging_plan(&server.plan, (const char* const*)server.plan_paths, images->count,
+                     cached_index) != 0) {
+        drop_plan();
+        *error = "Analyse des ISO echouee";
+        return -1;
+    }
+    server.plan_ready = 1;
+
+    const staging_plan_t* plan = &server.plan;
+    json_buf_printf(result, "{\"images\":[");
+    for (int i = 0; i < plan->image_count; i++) {
+        json_buf_printf(result, "%s{\"name\":", i ? "," : "");
+        json_buf_string(result, plan->images[i].name);
+        json_buf_printf(result, ",\"efiPath\":");
+        json_buf_string(result, plan->images[i].efi_path);
+        json_buf_printf(result, ",\"verified\":%s}",
+                        is_verified(plan->images[i].iso_path) ? "true" : "false");
+    }
+    json_buf_printf(result,
+        "],\"files\":%d,\"totalBytes\":%llu,\"uniqueBytes\":%llu,"
+        "\"duplicates\":%d,\"partitionMb\":%u}",
+        plan->file_count, plan->total_bytes, plan->unique_bytes, plan->duplicate_count,
+        staging_required_mb(plan) + ISO_SIZE_EXTRA_MB);
+    return 0;
+}
+
+// stage {} : partition temporaire puis copie des images du plan, toutes
+// vérifiées au préalable par verify
+static int rpc_stage(const json_value_t* params, json_buf_t* result, const char** error) {
+    (void)params;
+    if (!server.plan_ready) {
+        *error = "Aucun plan : appeler plan d'abord";
+        return -1;
+    }
+
+    // Rien n'est copié ni démarré sans vérification des empreintes
+    int verified = 1;
+    for (int i = 0; i < server.plan.image_count; i++) {
+        if (!is_verified(server.plan.images[i].iso_path)) {
+            fprintf(stderr, "[Erreur] Image non verifiee : %s\n", server.plan.images[i].iso_path);
+            verified = 0;
+        }
+    }
+    if (!verified) {
+        *error = "Images non verifiees : appeler verify pour chaque ISO du plan";
+        return -1;
+    }
+
+    unsigned int partition_size_mb = staging_required_mb(&server.plan) + ISO_SIZE_EXTRA_MB;
+    if (!check_free_space(required_space_mb(partition_size_mb))) {
+        *error = "Espace disque insuffisant";
+        return -1;
+    }
+
+    if (bcd_backup(BCD_BACKUP_PATH) != 0) {
+        *error = "Sauvegarde BCD echouee";
+        return -1;
+    }
+
+    temp_partition_t part;
+    if (temp_partition_prepare(&part, partition_size_mb, TEMP_DRIVE_LETTER) != 0) {
+        emergency_cleanup(NULL);
+        *error = "Creation partition echouee";
+        return -1;
+    }
+
+    // Les index des ISO sont libérés après la copie : seuls les noms et
+    // chemins EFI du plan restent utiles à configure-boot.
+    int copied = staging_execute(&server.plan, &part, rpc_progress);
+    staging_free(&server.plan);
+    server.plan_ready = 0;
+    if (copied != 0) {
+        temp_partition_abort(&part);
+        emergency_cleanup(NULL);
+        drop_plan();
+        *error = "Copie des images echouee";
+        return -1;
+    }
+    if (temp_partition_commit(&part) != 0) {
+        emergency_cleanup(NULL);
+        drop_plan();
+        *error = "Montage de la partition echoue";
+        return -1;
+    }
+    server.plan_staged = 1;
+
+    json_buf_printf(result, "{\"drive\":\"%c:\",\"partitionMb\":%u}",
+                    TEMP_DRIVE_LETTER, partition_size_mb);
+    return 0;
+}
+
+// configure-boot {} : une entrée BCD par image copiée
+static int rpc_configure_boot(const json_value_t* params, json_buf_t* result, const char** error) {
+    (void)params;
+    if (!server.plan_staged) {
+        *error = "Aucune image copiee : appeler stage d'abord";
+        return -1;
+    }
+
+    memset(server.bcd_ids, 0, sizeof(server.bcd_ids));
+    int rc = configure_staged_boot(&server.plan, server.bcd_ids);
+    if (rc != 0) {
+        // configure_staged_boot a déjà lancé le nettoyage d'urgence
+        drop_plan();
+        *error = "Configuration BCD echouee";
+        return -1;
+    }
+
+    json_buf_printf(result, "{\"entries\":[");
+    for (int i = 0; i < server.plan.image_count; i++) {
+        if (i > 0) json_buf_printf(result, ",");
+        json_buf_string(result, server.bcd_ids[i]);
+    }
+    json_buf_printf(result, "]}");
+    drop_plan();
+    return 0;
+}
+
+// cleanup {} : abandon après stage, restaure le BCD et la partition
+static int rpc_cleanup(const json_value_t* params, json_buf_t* result, const char** error) {
+    (void)params; (void)error;
+    int staged = server.plan_staged;
+    drop_plan();
+    if (staged) emergency_cleanup(NULL);
+    json_buf_printf(result, "{\"cleaned\":%s}", staged ? "true" : "false");
+    return 0;
+}
+
+static int rpc_cancel(const json_value_t* params, json_buf_t* result, const char** error) {
+    (void)params; (void)error;
+    EnterCriticalSection(&server.job_lock);
+    int busy = server.job_busy;
+    if (busy) set_cancel_requested(1);
+    LeaveCriticalSection(&server.job_lock);
+    json_buf_printf(result, "{\"cancelled\":%s}", busy ? "true" : "false");
+    return 0;
+}
+
+static int rpc_status(const json_value_t* params, json_buf_t* result, const char** error) {
+    (void)params; (void)error;
+    int cached = 0;
+    for (int i = 0; i < RPC_INDEX_CACHE; i++) cached += server.indexes[i].used;
+    json_buf_printf(result,
+        "{\"busy\":%s,\"planned\":%s,\"staged\":%s,\"admin\":%s,\"cachedIndexes\":%d}",
+        server.job_busy ? "true" : "false", server.plan_ready ? "true" : "false",
+        server.plan_staged ? "true" : "false", is_admin() ? "true" : "false", cached);
+    return 0;
+}
+
+// reboot {seconds} : par défaut 10 secondes, comme la ligne de commande
+static int rpc_reboot(const json_value_t* params, json_buf_t* result, const char** error) {
+    (void)error;
+    int seconds = (int)json_get_number(params, "seconds", 10);
+    reboot_in_seconds(seconds);
+    json_buf_printf(result, "{\"seconds\":%d}", seconds);
+    return 0;
+}
+
+static int rpc_shutdown(const json_value_t* params, json_buf_t* result, const char** error) {
+    (void)params; (void)result; (void)error;
+    server.stopping = 1;
+    return 0;
+}
+
+static const rpc_method_t methods[] = {
+    { "inspect",        rpc_inspect,        1, 0 },
+    { "verify",         rpc_verify,         1, 0 },
+    { "plan",           rpc_plan,           1, 0 },
+    { "stage",          rpc_stage,          1, 1 },
+    { "configure-boot", rpc_configure_boot, 1, 1 },
+    { "cleanup",        rpc_cleanup,        1, 1 },
+    { "cancel",         rpc_cancel,         0, 0 },
+    { "status",         rpc_status,         0, 0 },
+    { "reboot",         rpc_reboot,         0, 1 },
+    { "shutdown",       rpc_shutdown,       0, 0 },
+};
+
+// ── Exécution ─────────────────────────────────────────────────────────────
+
+static void run_method(const rpc_method_t* m, const json_value_t* request, const char* id) {
+    json_buf_t  result;
+    const char* error = "Echec de l'operation";
+    json_buf_init(&result);
+
+    int rc = m->handler(json_get(request, "params"), &result, &error);
+
+    if (rc == 0) send_result(id, &result);
+    else         send_error(id, RPC_ERR_FAILED, error);
+    json_buf_free(&result);
+}
+
+static DWORD WINAPI job_thread(LPVOID param) {
+    rpc_job_t* job = (rpc_job_t*)param;
+
+    printf("[Pleco] Requete %s...\n", job->method->name);
+    json_buf_t  result;
+    const char* error = "Echec de l'operation";
+    json_buf_init(&result);
+
+    int rc = job->method->handler(json_get(job->request, "params"), &result, &error);
+    int cancelled = rc != 0 && cancel_requested();
+
+    // Libéré avant la réponse : le client peut enchaîner immédiatement
+    EnterCriticalSection(&server.job_lock);
+    server.job_busy = 0;
+    server.job_id   = NULL;
+    set_cancel_requested(0);
+    LeaveCriticalSection(&server.job_lock);
+
+    if (rc == 0)        send_result(job->id, &result);
+    else if (cancelled) send_error(job->id, RPC_ERR_CANCELLED, "Operation annulee");
+    else                send_error(job->id, RPC_ERR_FAILED, error);
+
+    json_buf_free(&result);
+    json_free(job->request);
+    free(job->id);
+    free(job);
+    return 0;
+}
+
+static void wait_job(void) {
+    if (server.job_thread) {
+        WaitForSingleObject(server.job_thread, INFINITE);
+        CloseHandle(server.job_thread);
+        server.job_thread = NULL;
+    }
+}
+
+static void start_job(const rpc_method_t* m, json_value_t* request, const char* id) {
+    EnterCriticalSection(&server.job_lock);
+    int busy = server.job_busy;
+    LeaveCriticalSection(&server.job_lock);
+    if (busy) {
+        send_error(id, RPC_ERR_BUSY, "Une operation est deja en cours");
+        json_free(request);
+        return;
+    }
+    // Le thread précédent a rendu la main mais n'est peut-être pas terminé
+    wait_job();
+
+    rpc_job_t* job = calloc(1, sizeof(rpc_job_t));
+    if (!job) {
+        send_error(id, RPC_ERR_FAILED, "Memoire insuffisante");
+        json_free(request);
+        return;
+    }
+    job->method  = m;
+    job->request = request;
+    job->id      = id ? _strdup(id) : NULL;
+
+    set_cancel_requested(0);
+    server.job_busy    = 1;
+    server.job_id      = job->id;
+    server.job_percent = -1;
+
+    server.job_thread = CreateThread(NULL, 0, job_thread, job, 0, NULL);
+    if (!server.job_thread) {
+        server.job_busy = 0;
+        server.job_id   = NULL;
+        send_error(id, RPC_ERR_FAILED, "Creation du thread impossible");
+        json_free(request);
+        free(job->id);
+        free(job);
+    }
+}
+
+static void handle_line(const char* line) {
+    json_value_t* request = json_parse(line);
+    if (!request) {
+        send_error("null", RPC_ERR_PARSE, "JSON invalide");
+        return;
+    }
+
+    // Sans id, la requête est une notification : pas de réponse
+    json_buf_t id;
+    json_buf_init(&id);
+    const json_value_t* id_value = json_get(request, "id");
+    if (id_value) json_buf_value(&id, id_value);
+    const char* id_text = id_value ? id.data : NULL;
+
+    const char*         name = json_get_string(request, "method");
+    const rpc_method_t* m    = NULL;
+    for (size_t i = 0; name && i < sizeof(methods) / sizeof(methods[0]); i++) {
+        if (strcmp(methods[i].name, name) == 0) m = &methods[i];
+    }
+
+    const json_value_t* params = json_get(request, "params");
+    if (request->type != JSON_OBJECT || !name) {
+        send_error(id_value ? id_text : "null", RPC_ERR_REQUEST, "Requete invalide");
+    } else if (!m) {
+        send_error(id_text, RPC_ERR_METHOD, "Methode inconnue");
+    } else if (params && params->type != JSON_OBJECT) {
+        send_error(id_text, RPC_ERR_PARAMS, "params doit etre un objet");
+    } else if (m->needs_admin && !vdisk_is_open() && !is_admin()) {
+        send_error(id_text, RPC_ERR_FAILED, "Droits administrateur requis");
+    } else if (m->background) {
+        start_job(m, request, id_text);
+        request = NULL;   // possédée par le travail
+    } else {
+        run_method(m, request, id_text);
+    }
+
+    json_buf_free(&id);
+    json_free(request);
+}
+
+// Traite les requêtes jusqu'à la fin du flux ou "shutdown"
+static void serve_client(rpc_transport_t* t) {
+    json_buf_t line;
+    json_buf_init(&line);
+
+    server.transport = t;
+    while (!server.stopping && read_line(t, &line) == 0) {
+        if (line.len > 0) handle_line(line.data);
+    }
+    json_buf_free(&line);
+
+    // Le client est parti : le travail en cours est annulé avant de fermer
+    // le transport, l'état chaud reste en place.
+    if (server.job_busy) set_cancel_requested(1);
+    wait_job();
+    server.transport = NULL;
+}
+
+// ── Sécurité du canal nommé ───────────────────────────────────────────────
+// Le serveur repartitionne le disque système et modifie le BCD : seuls
+// l'utilisateur qui l'a lancé et SYSTEM peuvent ouvrir le canal, et
+// jamais depuis le réseau (PIPE_REJECT_REMOTE_CLIENTS).
+
+#ifdef _WIN32
+typedef struct {
+    SECURITY_ATTRIBUTES attr;
+    SECURITY_DESCRIPTOR desc;
+    DWORD_PTR           user[(sizeof(TOKEN_USER) + SECURITY_MAX_SID_SIZE) / sizeof(DWORD_PTR) + 1];
+    DWORD_PTR           system[SECURITY_MAX_SID_SIZE / sizeof(DWORD_PTR) + 1];
+    DWORD               acl[128];
+} pipe_security_t;
+
+static int pipe_security_init(pipe_security_t* sec) {
+    memset(sec, 0, sizeof(*sec));
+
+    HANDLE token;
+    DWORD  n;
+    if (!OpenProcessToken(GetCurrentProcess(), TOKEN_QUERY, &token)) return -1;
+    BOOL ok = GetTokenInformation(token, TokenUser, sec->user, sizeof(sec->user), &n);
+    CloseHandle(token);
+    if (!ok) return -1;
+
+    n = sizeof(sec->system);
+    if (!CreateWellKnownSid(WinLocalSystemSid, NULL, sec->system, &n)) return -1;
+
+    PACL acl = (PACL)sec->acl;
+    if (!InitializeAcl(acl, sizeof(sec->acl), ACL_REVISION) ||
+        !AddAccessAllowedAce(acl, ACL_REVISION, GENERIC_ALL,
+                             ((TOKEN_USER*)sec->user)->User.Sid) ||
+        !AddAccessAllowedAce(acl, ACL_REVISION, GENERIC_ALL, (PSID)sec->system) ||
+        !InitializeSecurityDescriptor(&sec->desc, SECURITY_DESCRIPTOR_REVISION) ||
+        !SetSecurityDescriptorDacl(&sec->desc, TRUE, acl, FALSE)) {
+        return -1;
+    }
+
+    sec->attr.nLength              = sizeof(sec->attr);
+    sec->attr.lpSecurityDescriptor = &sec->desc;
+    sec->attr.bInheritHandle       = FALSE;
+    return 0;
+}
+#else
+
+// ── Socket Unix ───────────────────────────────────────────────────────────
+// Hors Windows, --pipe <nom> ouvre une socket Unix : $XDG_RUNTIME_DIR/<nom>
+// (/tmp à défaut), ou <nom> tel quel s'il contient un /. Elle est créée en
+// 0600 : comme le canal nommé, seul l'utilisateur du serveur (et root) peut
+// s'y connecter.
+
+static int socket_path(const char* name, struct sockaddr_un* addr) {
+    const char* dir = getenv("XDG_RUNTIME_DIR");
+    if (!dir || !*dir) dir = "/tmp";
+
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    int n = strchr(name, '/')
+        ? snprintf(addr->sun_path, sizeof(addr->sun_path), "%s", name)
+        : snprintf(addr->sun_path, sizeof(addr->sun_path), "%s/%s", dir, name);
+    return (n > 0 && (size_t)n < sizeof(addr->sun_path)) ? 0 : -1;
+}
+
+// Socket laissée par un serveur arrêté : plus personne n'écoute derrière
+static int socket_stale(const struct sockaddr_un* addr) {
+    struct stat st;
+    if (lstat(addr->sun_path, &st) != 0 || !S_ISSOCK(st.st_mode)) return 0;
+
+    int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (probe < 0) return 0;
+    int stale = connect(probe, (const struct sockaddr*)addr, sizeof(*addr)) != 0 &&
+                errno == ECONNREFUSED;
+    close(probe);
+    return stale;
+}
+
+// Retourne la socket à l'écoute, -1 en erreur (errno). Une socket active
+// n'est jamais remplacée : un autre serveur l'occupe déjà.
+static int socket_listen(const struct sockaddr_un* addr) {
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+
+    mode_t mask = umask(0177);
+    int    rc   = bind(fd, (const struct sockaddr*)addr, sizeof(*addr));
+    if (rc != 0 && errno == EADDRINUSE) {
+        if (socket_stale(addr) && unlink(addr->sun_path) == 0) {
+            rc = bind(fd, (const struct sockaddr*)addr, sizeof(*addr));
+        } else {
+            errno = EADDRINUSE;
+        }
+    }
+    umask(mask);
+
+    if (rc != 0 || listen(fd, 1) != 0) {
+        int err = errno;
+        close(fd);
+        errno = err;
+        return -1;
+    }
+    return fd;
+}
+
+static int serve_socket(const char* name) {
+    struct sockaddr_un addr;
+    if (socket_path(name, &addr) != 0) {
+        fprintf(stderr, "[Erreur] Chemin de socket trop long : %s\n", name);
+        return -1;
+    }
+
+    int listener = socket_listen(&addr);
+    if (listener < 0) {
+        fprintf(stderr, "[Erreur] Creation de la socket %s impossible (%s).\n",
+                addr.sun_path, strerror(errno));
+        return -1;
+    }
+
+    // Un client parti au milieu d'une réponse ne doit pas arrêter le serveur
+    signal(SIGPIPE, SIG_IGN);
+
+    printf("[Pleco] Serveur pret : %s\n", addr.sun_path);
+    fflush(stdout);
+    while (!server.stopping) {
+        int fd = accept(listener, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            fprintf(stderr, "[Erreur] Connexion refusee (%s).\n", strerror(errno));
+            break;
+        }
+        HANDLE client = compat_fd_handle(fd);
+        if (client == INVALID_HANDLE_VALUE) {
+            close(fd);
+            continue;
+        }
+
+        rpc_transport_t t;
+        memset(&t, 0, sizeof(t));
+        t.in = t.out = client;
+        printf("[Info] Client connecte.\n");
+        serve_client(&t);
+        printf("[Info] Client deconnecte.\n");
+        CloseHandle(client);
+    }
+
+    close(listener);
+    unlink(addr.sun_path);
+    return 0;
+}
+#endif
+
+// ── Point d'entrée ────────────────────────────────────────────────────────
+
+int rpc_serve(const char* pipe_name) {
+    InitializeCriticalSection(&server.out_lock);
+    InitializeCriticalSection(&server.job_lock);
+    digest_cache_enable(1);
+
+    if (!pipe_name) {
+        rpc_transport_t t;
+        memset(&t, 0, sizeof(t));
+        t.in = GetStdHandle(STD_INPUT_HANDLE);
+
+        // Le vrai stdout est réservé au protocole ; printf et les processus
+        // enfants (bcdedit, shutdown) écrivent sur stderr.
+        if (!DuplicateHandle(GetCurrentProcess(), GetStdHandle(STD_OUTPUT_HANDLE),
+                             GetCurrentProcess(), &t.out, 0, FALSE, DUPLICATE_SAME_ACCESS)) {
+            fprintf(stderr, "[Erreur] Impossible de reserver la sortie standard.\n");
+            return 1;
+        }
+        fflush(stdout);
+        _dup2(_fileno(stderr), _fileno(stdout));
+        SetStdHandle(STD_OUTPUT_HANDLE, GetStdHandle(STD_ERROR_HANDLE));
+
+        fprintf(stderr, "[Pleco] Serveur pret (stdio).\n");
+        serve_client(&t);
+        CloseHandle(t.out);
+    } else {
+#ifdef _WIN32
+        char name[MAX_PATH];
+        if (strncmp(pipe_name, "\\\\", 2) == 0) {
+            snprintf(name, sizeof(name), "%s", pipe_name);
+        } else {
+            snprintf(name, sizeof(name), "\\\\.\\pipe\\%s", pipe_name);
+        }
+
+        pipe_security_t sec;
+        if (pipe_security_init(&sec) != 0) {
+            fprintf(stderr, "[Erreur] Securite du canal impossible a definir (code %lu).\n",
+                    GetLastError());
+            return 1;
+        }
+
+        printf("[Pleco] Serveur pret : %s\n", name);
+        while (!server.stopping) {
+            // Première instance : un autre processus qui aurait déjà créé
+            // ce nom ne peut pas se faire passer pour le serveur
+            HANDLE pipe = CreateNamedPipeA(name, PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED |
+                                                 FILE_FLAG_FIRST_PIPE_INSTANCE,
+                                           PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT |
+                                           PIPE_REJECT_REMOTE_CLIENTS,
+                                           1, 65536, 65536, 0, &sec.attr);
+            if (pipe == INVALID_HANDLE_VALUE) {
+                fprintf(stderr, "[Erreur] Creation du canal %s impossible (code %lu).\n",
+                        name, GetLastError());
+                return 1;
+            }
+
+            OVERLAPPED ov;
+            memset(&ov, 0, sizeof(ov));
+            ov.hEvent = CreateEventA(NULL, TRUE, FALSE, NULL);
+            BOOL connected = ConnectNamedPipe(pipe, &ov);
+            DWORD n;
+            if (!connected && GetLastError() == ERROR_IO_PENDING) {
+                connected = GetOverlappedResult(pipe, &ov, &n, TRUE);
+            } else if (!connected && GetLastError() == ERROR_PIPE_CONNECTED) {
+                connected = TRUE;
+            }
+            CloseHandle(ov.hEvent);
+
+            if (connected) {
+                rpc_transport_t t;
+                memset(&t, 0, sizeof(t));
+                t.in = t.out  = pipe;
+                t.overlapped  = 1;
+                printf("[Info] Client connecte.\n");
+                serve_client(&t);
+                printf("[Info] Client deconnecte.\n");
+                DisconnectNamedPipe(pipe);
+            }
+            CloseHandle(pipe);
+        }
+#else
+        if (serve_socket(pipe_name) != 0) return 1;
+#endif
+    }
+
+    drop_plan();
+    for (int i = 0; i < RPC_INDEX_CACHE; i++) {
+        if (server.indexes[i].used) iso_index_free(&server.indexes[i].index);
+    }
+    DeleteCriticalSection(&server.job_lock);
+    DeleteCriticalSection(&server.out_lock);
+    return 0;
+}
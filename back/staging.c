@@ -0,0 +1,772 @@
+// staging.c
+#include "header/staging.h"
+#include "header/iso9660.h"
+#include "header/storage.h"
+#include "header/digest.h"
+#include "header/utils.h"
+#include "header/io_policy.h"
+#include "header/grub_cfg.h"
+#include "header/compat.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define COPY_BUFFER_SIZE (1024 * 1024)   // sans profil des périphériques
+#define SMALL_FILE_SIZE  (256 * 1024)   // au-delà : copie fichier par fichier
+#define BATCH_MAX_FILES  4096
+#define READ_GAP_MAX     (64 * 1024)    // trou toléré entre deux fichiers lus d'un bloc
+
+// ── Inventaire ────────────────────────────────────────────────────────────
+
+static int plan_push(staging_plan_t* plan, const iso_entry_t* entry, int image) {
+    if (plan->file_count == plan->file_capacity) {
+        int cap = plan->file_capacity ? plan->file_capacity * 2 : 1024;
+        staging_file_t* grown = realloc(plan->files, cap * sizeof(staging_file_t));
+        if (!grown) {
+            fprintf(stderr, "[Erreur] Memoire insuffisante pour l'inventaire.\n");
+            return -1;
+        }
+        plan->files = grown;
+        plan->file_capacity = cap;
+    }
+
+    staging_file_t* f = &plan->files[plan->file_count];
+    memset(f, 0, sizeof(*f));
+    if (copy_string(f->rel_path, sizeof(f->rel_path), entry->path) != 0) {
+        fprintf(stderr, "[Erreur] Chemin trop long : %s\n", entry->path);
+        return -1;
+    }
+    plan->file_count++;
+    f->size      = entry->is_dir ? 0 : entry->size;
+    f->extent    = entry->extent;
+    f->image     = image;
+    f->is_dir    = entry->is_dir;
+    f->canonical = -1;
+
+    plan->total_bytes += f->size;
+    return 0;
+}
+
+static unsigned long long round_up(unsigned long long n, unsigned int unit) {
+    return (n + unit - 1) / unit * unit;
+}
+
+// Contenu d'un petit fichier de l'ISO suivi d'un zéro, à libérer (io_free).
+// NULL en erreur.
+static BYTE* read_small(io_reader_t* iso, const staging_file_t* f) {
+    // io_read_at arrondit les lectures directes au bloc
+    BYTE* raw = io_alloc((size_t)round_up(f->size + 1, IO_ALIGN));
+    DWORD got = 0;
+    if (!raw) return NULL;
+    if (f->size && (io_read_at(iso, (unsigned long long)f->extent * ISO_SECTOR_SIZE, raw,
+                               (DWORD)f->size, &got) != 0 || got != f->size)) {
+        io_free(raw);
+        return NULL;
+    }
+    raw[f->size] = 0;
+    return raw;
+}
+
+// ── Configurations GRUB ───────────────────────────────────────────────────
+// En mode multi-images, les configurations GRUB ne sont pas copiées telles
+// quelles : elles sont réécrites pour le dossier de l'image (grub_cfg.h)
+// une fois le reste copié. Les noyaux et initrd qu'elles citent peuvent
+// être partagés entre images (magasin, staging.h).
+
+// Dossier du chargeur EFI dans l'ISO, ex: \EFI\BOOT
+static void loader_dir(const staging_plan_t* plan, int image, char* out, size_t size) {
+    const staging_image_t* img = &plan->images[image];
+    snprintf(out, size, "%s", img->efi_path + strlen(img->dir));
+    char* sep = strrchr(out, '\\');
+    if (sep) *sep = '\0';
+}
+
+static int is_relocated(const staging_plan_t* plan, const staging_file_t* f) {
+    if (plan->image_count < 2 || f->is_dir || f->size > SMALL_FILE_SIZE) return 0;
+    char dir[MAX_PATH];
+    loader_dir(plan, f->image, dir, sizeof(dir));
+    return grub_cfg_is_config(f->rel_path, dir);
+}
+
+// Chemin de la partition vu par GRUB : séparateurs /
+static void grub_path(const char* path, char* out, size_t size) {
+    snprintf(out, size, "%s", path);
+    for (char* p = out; *p; p++) {
+        if (*p == '\\') *p = '/';
+    }
+}
+
+// Fichier de l'image désigné par un chemin GRUB (séparateurs /), -1 si absent
+static int find_file(const staging_plan_t* plan, int image, const char* path, size_t len) {
+    char rel[MAX_PATH];
+    if (len >= sizeof(rel)) return -1;
+    for (size_t i = 0; i < len; i++) rel[i] = path[i] == '/' ? '\\' : path[i];
+    rel[len] = '\0';
+
+    for (int i = 0; i < plan->file_count; i++) {
+        const staging_file_t* f = &plan->files[i];
+        if (f->image == image && !f->is_dir && _stricmp(f->rel_path, rel) == 0) return i;
+    }
+    return -1;
+}
+
+typedef struct {
+    staging_plan_t* plan;
+    int             image;
+} boot_scan_t;
+
+static void mark_boot_file(void* ctx, const char* path, size_t len) {
+    boot_scan_t* scan = ctx;
+    int i = find_file(scan->plan, scan->image, path, len);
+    if (i >= 0 && !is_relocated(scan->plan, &scan->plan->files[i])) {
+        scan->plan->files[i].boot_file = 1;
+    }
+}
+
+// Repère les noyaux et initrd cités par les configurations de chaque image
+static int mark_boot_files(staging_plan_t* plan) {
+    for (int i = 0; i < plan->image_count; i++) {
+        io_reader_t iso;
+        if (io_open(&iso, plan->images[i].iso_path) != 0) {
+            fprintf(stderr, "[Erreur] Impossible d'ouvrir l'ISO : %s\n",
+                    plan->images[i].iso_path);
+            return -1;
+        }
+
+        boot_scan_t scan = { plan, i };
+        int         rc   = 0;
+        for (int k = 0; rc == 0 && k < plan->file_count; k++) {
+            const staging_file_t* f = &plan->files[k];
+            if (f->image != i || !is_relocated(plan, f)) continue;
+            BYTE* cfg = read_small(&iso, f);
+            if (!cfg) {
+                fprintf(stderr, "[Erreur] Lecture de %s echouee.\n", f->rel_path);
+                rc = -1;
+                break;
+            }
+            grub_cfg_boot_files((const char*)cfg, (size_t)f->size, mark_boot_file, &scan);
+            io_free(cfg);
+        }
+        io_close(&iso);
+        if (rc != 0) return -1;
+    }
+    return 0;
+}
+
+// ── Magasin adressé par contenu ───────────────────────────────────────────
+// Table à adressage ouvert : BLAKE3 -> index du premier fichier portant ce
+// contenu. Chaque case contient un index dans plan->files, -1 si vide.
+
+static int cas_find_or_insert(int* slots, unsigned int mask,
+                              const staging_file_t* files, int idx) {
+    const unsigned char* key = files[idx].digest;
+    unsigned int pos = ((unsigned int)key[0]       | (unsigned int)key[1] << 8 |
+                        (unsigned int)key[2] << 16 | (unsigned int)key[3] << 24) & mask;
+
+    while (slots[pos] >= 0) {
+        if (memcmp(files[slots[pos]].digest, key, 32) == 0) return slots[pos];
+        pos = (pos + 1) & mask;
+    }
+    slots[pos] = idx;
+    return -1;
+}
+
+typedef struct {
+    unsigned long long size;
+    int                idx;
+} size_key_t;
+
+static int cmp_size_key(const void* a, const void* b) {
+    const size_key_t* x = a;
+    const size_key_t* y = b;
+    if (x->size != y->size) return x->size < y->size ? -1 : 1;
+    return x->idx - y->idx;
+}
+
+// Seuls les noyaux et initrd sont candidats, et parmi eux ceux dont la
+// taille est partagée par un autre : une taille unique garantit un contenu
+// unique. Le premier exemplaire d'un contenu dupliqué va au magasin.
+static int deduplicate(staging_plan_t* plan) {
+    int n = 0;
+    size_key_t* keys = malloc((plan->file_count + 1) * sizeof(size_key_t));
+    if (!keys) return -1;
+
+    for (int i = 0; i < plan->file_count; i++) {
+        if (!plan->files[i].boot_file || plan->files[i].size == 0) continue;
+        keys[n].size = plan->files[i].size;
+        keys[n].idx  = i;
+        n++;
+    }
+    qsort(keys, n, sizeof(size_key_t), cmp_size_key);
+
+    unsigned int cap = 16;
+    while (cap < (unsigned int)n * 2) cap <<= 1;
+    int* slots = malloc(cap * sizeof(int));
+    if (!slots) { free(keys); return -1; }
+    for (unsigned int i = 0; i < cap; i++) slots[i] = -1;
+
+    plan->unique_bytes    = plan->total_bytes;
+    plan->duplicate_count = 0;
+
+    int i = 0;
+    while (i < n) {
+        int j = i + 1;
+        while (j < n && keys[j].size == keys[i].size) j++;
+
+        if (j - i > 1) {
+            // Ordre croissant d'index : le fichier canonique est toujours
+            // copié avant ses doublons.
+            for (int k = i; k < j; k++) {
+                if (cancel_requested()) {
+                    free(slots);
+                    free(keys);
+                    return -1;
+                }
+                staging_file_t* f = &plan->files[keys[k].idx];
+                digest_result_t result;
+                if (digest_file_range(plan->images[f->image].iso_path,
+                                      (unsigned long long)f->extent * ISO_SECTOR_SIZE,
+                                      f->size, DIGEST_BLAKE3, &result, NULL) != 0) {
+                    fprintf(stderr, "[Attention] Hash impossible : %s\n", f->rel_path);
+                    continue;
+                }
+                memcpy(f->digest, result.blake3, sizeof(f->digest));
+                f->hashed = 1;
+
+                int first = cas_find_or_insert(slots, cap - 1, plan->files, keys[k].idx);
+                if (first >= 0) {
+                    f->canonical = first;
+                    plan->files[first].shared = 1;
+                    plan->unique_bytes -= f->size;
+                    plan->duplicate_count++;
+                }
+            }
+        }
+        i = j;
+    }
+
+    free(slots);
+    free(keys);
+    return 0;
+}
+
+// ── Plan ──────────────────────────────────────────────────────────────────
+
+int staging_plan(staging_plan_t* plan, const char* const* iso_paths, int count,
+                 staging_index_fn index_fn) {
+    memset(plan, 0, sizeof(*plan));
+
+    if (count < 1 || count > STAGING_MAX_IMAGES) {
+        fprintf(stderr, "[Erreur] Nombre d'images invalide (%d, max %d).\n",
+                count, STAGING_MAX_IMAGES);
+        return -1;
+    }
+
+    for (int i = 0; i < count; i++) {
+        staging_image_t* img = &plan->images[i];
+        img->iso_path = iso_paths[i];
+
+        const char* base = iso_paths[i];
+        for (const char* p = iso_paths[i]; *p; p++) {
+            if (*p == '\\' || *p == '/') base = p + 1;
+        }
+        if (copy_string(img->name, sizeof(img->name), base) != 0) {
+            fprintf(stderr, "[Erreur] Nom de fichier trop long : %s\n", iso_paths[i]);
+            staging_free(plan);
+            return -1;
+        }
+
+        printf("[Pleco] Lecture de %s...\n", img->name);
+        iso_index_t        owned;
+        const iso_index_t* index = &owned;
+        if (index_fn) {
+            index = index_fn(img->iso_path);
+        } else if (iso_index_open(img->iso_path, &owned) != 0) {
+            index = NULL;
+        }
+        if (!index) {
+            staging_free(plan);
+            return -1;
+        }
+        plan->image_count = i + 1;
+
+        // Le binaire EFI est cherché dans l'index : une image non UEFI est
+        // refusée avant de toucher au disque.
+        if (!index->efi_path[0]) {
+            fprintf(stderr,
+                "[Erreur] bootx64.efi introuvable dans %s.\n"
+                "         L'ISO n'est peut-etre pas un ISO Linux UEFI.\n",
+                img->name);
+            if (!index_fn) iso_index_free(&owned);
+            staging_free(plan);
+            return -1;
+        }
+        // Image seule à la racine : les chemins absolus de son GRUB et de
+        // son système live restent valides
+        if (count > 1) snprintf(img->dir, sizeof(img->dir), "%s\\%d", STAGING_ROOT, i + 1);
+        if (snprintf(img->efi_path, sizeof(img->efi_path), "%s%s",
+                     img->dir, index->efi_path) >= (int)sizeof(img->efi_path)) {
+            fprintf(stderr, "[Erreur] Chemin EFI trop long dans %s.\n", img->name);
+            if (!index_fn) iso_index_free(&owned);
+            staging_free(plan);
+            return -1;
+        }
+
+        int rc = 0;
+        for (int e = 0; e < index->count && rc == 0; e++) {
+            rc = plan_push(plan, &index->entries[e], i);
+        }
+        if (!index_fn) iso_index_free(&owned);
+        if (rc != 0) {
+            staging_free(plan);
+            return -1;
+        }
+    }
+
+    // Une image seule n'a rien à partager
+    plan->unique_bytes = plan->total_bytes;
+    if (plan->image_count > 1) {
+        printf("[Pleco] Analyse des doublons...\n");
+        if (mark_boot_files(plan) != 0) {
+            staging_free(plan);
+            return -1;
+        }
+        if (deduplicate(plan) != 0) {
+            if (cancel_requested()) {
+                printf("[Pleco] Analyse annulee.\n");
+            } else {
+                fprintf(stderr, "[Erreur] Memoire insuffisante pour la deduplication.\n");
+            }
+            staging_free(plan);
+            return -1;
+        }
+    }
+
+    printf("[Pleco] %d image(s), %d fichiers, %llu Mo (%llu Mo a ecrire, %d doublons).\n",
+           plan->image_count, plan->file_count,
+           plan->total_bytes / (1024ULL * 1024ULL),
+           plan->unique_bytes / (1024ULL * 1024ULL),
+           plan->duplicate_count);
+    return 0;
+}
+
+unsigned int staging_required_mb(const staging_plan_t* plan) {
+    unsigned long long bytes = plan->unique_bytes;
+    // Perte moyenne d'un demi-cluster par fichier (clusters FAT32 <= 16 Ko)
+    bytes += (unsigned long long)plan->file_count * 8192ULL;
+    return (unsigned int)(bytes / (1024ULL * 1024ULL)) + 1;
+}
+
+// ── Copie ─────────────────────────────────────────────────────────────────
+
+// Copie le contenu d'un fichier de l'ISO (extent contigu) vers le volume
+static int copy_with_progress(io_reader_t* iso, const staging_file_t* f,
+                              storage_volume_t* vol, const char* dst,
+                              BYTE* buffer, DWORD chunk, unsigned long long* done,
+                              unsigned long long total, progress_callback_t progress_cb) {
+    storage_file_t out;
+    if (storage_create(vol, dst, f->size, &out) != 0) return -1;
+
+    int                rc   = 0;
+    unsigned long long pos  = (unsigned long long)f->extent * ISO_SECTOR_SIZE;
+    unsigned long long left = f->size;
+    while (left > 0) {
+        if (cancel_requested()) {
+            rc = -1;
+            break;
+        }
+        DWORD want = (DWORD)(left < chunk ? left : chunk);
+        DWORD n;
+        if (io_read_at(iso, pos, buffer, want, &n) != 0 || n != want ||
+            storage_write(vol, &out, buffer, n) != 0) {
+            rc = -1;
+            break;
+        }
+        pos   += n;
+        left  -= n;
+        *done += n;
+        if (progress_cb) progress_cb(*done, total);
+    }
+
+    if (storage_close_file(vol, &out) != 0) rc = -1;
+    return rc;
+}
+
+// ── Lots de petits fichiers ───────────────────────────────────────────────
+// Les petits fichiers s'accumulent jusqu'à batch_bytes (mesuré sur le
+// volume, en taille arrondie au cluster) puis sont lus de l'ISO par plages
+// contiguës et écrits en une fois (storage_write_batch).
+
+typedef struct {
+    int          image;
+    unsigned int extent;
+    int          slot;       // index dans le lot
+} batch_read_t;
+
+typedef struct {
+    storage_item_t*    items;
+    char             (*paths)[MAX_PATH];
+    int*               files;         // index dans plan->files
+    unsigned long long*offsets;       // position de chaque contenu dans data
+    batch_read_t*      reads;
+    int                count;
+    unsigned long long disk_bytes;    // taille occupée sur le volume
+    unsigned long long data_bytes;
+    BYTE*              data;
+    BYTE*              read_buf;
+    unsigned int       capacity;      // octets de data (read_buf : capacity + IO_ALIGN)
+} batch_t;
+
+static int batch_init(batch_t* b, unsigned int capacity) {
+    memset(b, 0, sizeof(*b));
+    b->capacity = capacity;
+    b->items    = malloc(BATCH_MAX_FILES * sizeof(*b->items));
+    b->paths    = malloc(BATCH_MAX_FILES * sizeof(*b->paths));
+    b->files    = malloc(BATCH_MAX_FILES * sizeof(*b->files));
+    b->offsets  = malloc(BATCH_MAX_FILES * sizeof(*b->offsets));
+    b->reads    = malloc(BATCH_MAX_FILES * sizeof(*b->reads));
+    b->data     = malloc(capacity);
+    // io_read_at arrondit les lectures directes au bloc : marge d'un IO_ALIGN
+    b->read_buf = io_alloc((size_t)capacity + IO_ALIGN);
+    if (!b->items || !b->paths || !b->files || !b->offsets || !b->reads ||
+        !b->data || !b->read_buf) {
+        fprintf(stderr, "[Erreur] Memoire insuffisante pour les lots de copie.\n");
+        return -1;
+    }
+    return 0;
+}
+
+static void batch_free(batch_t* b) {
+    free(b->items);
+    free(b->paths);
+    free(b->files);
+    free(b->offsets);
+    free(b->reads);
+    free(b->data);
+    io_free(b->read_buf);
+}
+
+// Le fichier tient-il encore dans le lot courant ?
+static int batch_fits(const batch_t* b, const staging_file_t* f, unsigned int alloc_unit) {
+    return b->count < BATCH_MAX_FILES &&
+           b->disk_bytes + round_up(f->size, alloc_unit) <= b->capacity;
+}
+
+static int batch_add(batch_t* b, const staging_file_t* f, int index, const char* dst,
+                     unsigned int alloc_unit) {
+    int i = b->count;
+    if (copy_string(b->paths[i], MAX_PATH, dst) != 0) return -1;
+    b->count++;
+    b->files[i]   = index;
+    b->offsets[i] = b->data_bytes;
+    b->items[i].path = b->paths[i];
+    b->items[i].size = f->size;
+    b->items[i].data = b->data + b->data_bytes;
+    b->disk_bytes += round_up(f->size, alloc_unit);
+    b->data_bytes += f->size;
+    return 0;
+}
+
+static int cmp_read(const void* a, const void* b) {
+    const batch_read_t* x = a;
+    const batch_read_t* y = b;
+    if (x->image != y->image) return x->image - y->image;
+    return (x->extent > y->extent) - (x->extent < y->extent);
+}
+
+// Lit le contenu du lot : fichiers triés par position dans l'ISO, une
+// lecture par plage de fichiers voisins.
+static int batch_read(batch_t* b, const staging_plan_t* plan, io_reader_t* iso) {
+    int n = 0;
+    for (int i = 0; i < b->count; i++) {
+        const staging_file_t* f = &plan->files[b->files[i]];
+        if (f->size == 0) continue;
+        b->reads[n].image  = f->image;
+        b->reads[n].extent = f->extent;
+        b->reads[n].slot   = i;
+        n++;
+    }
+    qsort(b->reads, n, sizeof(*b->reads), cmp_read);
+
+    for (int first = 0; first < n;) {
+        if (cancel_requested()) return -1;
+
+        int                image = b->reads[first].image;
+        unsigned long long start = (unsigned long long)b->reads[first].extent * ISO_SECTOR_SIZE;
+        unsigned long long end   = start + b->items[b->reads[first].slot].size;
+        int last = first + 1;
+        for (; last < n && b->reads[last].image == image; last++) {
+            unsigned long long next_start =
+                (unsigned long long)b->reads[last].extent * ISO_SECTOR_SIZE;
+            unsigned long long next_end = next_start + b->items[b->reads[last].slot].size;
+            if (next_start > end + READ_GAP_MAX || next_end - start > b->capacity) break;
+            if (next_end > end) end = next_end;
+        }
+
+        DWORD want = (DWORD)(end - start), got;
+        if (io_read_at(&iso[image], start, b->read_buf, want, &got) != 0 || got != want) {
+            return -1;
+        }
+
+        for (int r = first; r < last; r++) {
+            int slot = b->reads[r].slot;
+            unsigned long long at = (unsigned long long)b->reads[r].extent * ISO_SECTOR_SIZE;
+            memcpy(b->data + b->offsets[slot], b->read_buf + (at - start),
+                   (size_t)b->items[slot].size);
+        }
+        first = last;
+    }
+    return 0;
+}
+
+static int batch_flush(batch_t* b, const staging_plan_t* plan, io_reader_t* iso,
+                       storage_volume_t* vol, unsigned long long* done,
+                       unsigned long long total, progress_callback_t progress_cb) {
+    if (b->count == 0) return 0;
+
+    int rc = batch_read(b, plan, iso);
+    if (rc != 0) {
+        if (cancel_requested()) {
+            printf("\n[Pleco] Copie annulee.\n");
+        } else {
+            fprintf(stderr, "[Erreur] Lecture de l'ISO echouee (code %lu).\n", GetLastError());
+        }
+    } else if (storage_write_batch(vol, b->items, b->count) != 0) {
+        fprintf(stderr, "[Erreur] Ecriture groupee de %d fichier(s) echouee.\n", b->count);
+        rc = -1;
+    }
+    if (rc == 0) {
+        *done += b->data_bytes;
+        if (progress_cb) progress_cb(*done, total);
+    }
+
+    b->count      = 0;
+    b->disk_bytes = 0;
+    b->data_bytes = 0;
+    return rc;
+}
+
+// ── Destinations et configurations ────────────────────────────────────────
+
+// Destination d'un fichier sur la partition : dossier de l'image, ou
+// magasin pour un contenu partagé
+static int file_dest(const staging_plan_t* plan, const staging_file_t* f, char* out,
+                     size_t size) {
+    int len;
+    if (f->shared || f->canonical >= 0) {
+        char hex[65];
+        digest_to_hex(f->digest, 32, hex);
+        len = snprintf(out, size, "%s\\%s", STAGING_CAS, hex);
+    } else {
+        len = snprintf(out, size, "%s%s", plan->images[f->image].dir, f->rel_path);
+    }
+    if (len < 0 || (size_t)len >= size) {
+        fprintf(stderr, "[Erreur] Chemin trop long : %s%s\n",
+                plan->images[f->image].dir, f->rel_path);
+        return -1;
+    }
+    return 0;
+}
+
+typedef struct {
+    const staging_plan_t* plan;
+    int                   image;
+    char                  path[MAX_PATH];
+} cas_map_t;
+
+// grub_cfg_map_fn : un noyau ou initrd partagé est lu dans le magasin
+static const char* cas_path(void* ctx, const char* path, size_t len) {
+    cas_map_t* map = ctx;
+    int i = find_file(map->plan, map->image, path, len);
+    if (i < 0) return NULL;
+
+    const staging_file_t* f = &map->plan->files[i];
+    char dst[MAX_PATH];
+    if (!(f->shared || f->canonical >= 0) || file_dest(map->plan, f, dst, sizeof(dst)) != 0) {
+        return NULL;
+    }
+    grub_path(dst, map->path, sizeof(map->path));
+    return map->path;
+}
+
+static int write_relocated(storage_volume_t* vol, const char* dst, const char* cfg,
+                           size_t len, const char* dir, const char* marker, cas_map_t* map) {
+    size_t text_len;
+    char*  text = grub_cfg_relocate(cfg, len, dir, marker, cas_path, map, &text_len);
+    if (!text) return -1;
+
+    storage_file_t out;
+    int rc = storage_create(vol, dst, text_len, &out);
+    if (rc == 0) {
+        if (text_len && storage_write(vol, &out, text, (unsigned int)text_len) != 0) rc = -1;
+        if (storage_close_file(vol, &out) != 0) rc = -1;
+    }
+    free(text);
+    return rc;
+}
+
+// Réécrit les configurations GRUB de chaque image, et ajoute à côté du
+// chargeur un grub.cfg qui charge celle de \boot\grub s'il n'y en a pas.
+static int write_boot_configs(const staging_plan_t* plan, io_reader_t* iso,
+                              storage_volume_t* vol, unsigned long long* done,
+                              unsigned long long total, progress_callback_t progress_cb) {
+    for (int i = 0; i < plan->image_count; i++) {
+        const staging_image_t* img = &plan->images[i];
+        cas_map_t map = { plan, i, "" };
+        char dir[MAX_PATH], marker[MAX_PATH], loader[MAX_PATH], loader_cfg[MAX_PATH];
+        grub_path(img->dir, dir, sizeof(dir));
+        grub_path(img->efi_path, marker, sizeof(marker));
+        loader_dir(plan, i, loader, sizeof(loader));
+        if (snprintf(loader_cfg, sizeof(loader_cfg), "%s\\grub.cfg", loader) >=
+            (int)sizeof(loader_cfg)) {
+            return -1;
+        }
+
+        int has_loader_cfg = 0, has_main_cfg = 0;
+        for (int k = 0; k < plan->file_count; k++) {
+            const staging_file_t* f = &plan->files[k];
+            if (f->image != i || !is_relocated(plan, f)) continue;
+            if (_stricmp(f->rel_path, loader_cfg) == 0) has_loader_cfg = 1;
+            if (_stricmp(f->rel_path, "\\boot\\grub\\grub.cfg") == 0) has_main_cfg = 1;
+
+            char dst[MAX_PATH];
+            if (snprintf(dst, sizeof(dst), "%s%s", img->dir, f->rel_path) >= (int)sizeof(dst)) {
+                fprintf(stderr, "[Erreur] Chemin trop long : %s%s\n", img->dir, f->rel_path);
+                return -1;
+            }
+            BYTE* raw = read_small(&iso[i], f);
+            int   rc  = raw ? write_relocated(vol, dst, (const char*)raw, (size_t)f->size,
+                                              dir, marker, &map) : -1;
+            io_free(raw);
+            if (rc != 0) {
+                fprintf(stderr, "[Erreur] Configuration GRUB %s non ecrite.\n", dst);
+                return -1;
+            }
+            *done += f->size;
+            if (progress_cb) progress_cb(*done, total);
+        }
+
+        if (has_loader_cfg) continue;
+        if (!has_main_cfg) {
+            printf("\n[Attention] %s : pas de configuration GRUB, l'image risque de ne "
+                   "pas demarrer depuis %s.\n", img->name, img->dir);
+            continue;
+        }
+        char dst[MAX_PATH];
+        static const char entry[] = "source $prefix/grub.cfg\n";
+        if (snprintf(dst, sizeof(dst), "%s%s", img->dir, loader_cfg) >= (int)sizeof(dst) ||
+            write_relocated(vol, dst, entry, sizeof(entry) - 1, dir, marker, &map) != 0) {
+            fprintf(stderr, "[Erreur] Configuration GRUB %s non ecrite.\n", dst);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int staging_execute(staging_plan_t* plan, temp_partition_t* part,
+                    progress_callback_t progress_cb) {
+    storage_volume_t vol;
+    char             drive_letter = part->drive_letter;
+    if (storage_open_disk(&vol, part->disk, part->offset, drive_letter) != 0) return -1;
+
+    if (plan->image_count > 1)    storage_mkdir(&vol, STAGING_ROOT);
+    if (plan->duplicate_count > 0) storage_mkdir(&vol, STAGING_CAS);
+    for (int i = 0; i < plan->image_count; i++) {
+        if (plan->images[i].dir[0]) storage_mkdir(&vol, plan->images[i].dir);
+    }
+
+    io_reader_t iso[STAGING_MAX_IMAGES];
+    batch_t     batch;
+    BYTE*       buffer = NULL;
+    int         opened = 0;
+    int         rc     = batch_init(&batch, vol.batch_bytes);
+    for (; rc == 0 && opened < plan->image_count; opened++) {
+        if (io_open(&iso[opened], plan->images[opened].iso_path) != 0) {
+            fprintf(stderr, "[Erreur] Impossible d'ouvrir l'ISO : %s\n",
+                    plan->images[opened].iso_path);
+            rc = -1;
+            break;
+        }
+    }
+
+    // Morceaux de copie : au moins la taille conseillée de chaque côté
+    DWORD chunk = vol.write_block ? vol.write_block : COPY_BUFFER_SIZE;
+    for (int i = 0; i < opened; i++) {
+        if (iso[i].block > chunk) chunk = iso[i].block;
+    }
+    if (rc == 0 && !(buffer = io_alloc(chunk))) rc = -1;
+
+    unsigned long long done  = 0;
+    unsigned long long total = plan->unique_bytes;
+    if (rc == 0 && progress_cb) progress_cb(0, total);
+
+    for (int i = 0; rc == 0 && i < plan->file_count; i++) {
+        staging_file_t* f = &plan->files[i];
+        if (f->canonical >= 0) continue;   // déjà écrit dans le magasin
+
+        char dst[MAX_PATH];
+        if (file_dest(plan, f, dst, sizeof(dst)) != 0) {
+            rc = -1;
+            break;
+        }
+
+        if (f->is_dir) {
+            if (storage_mkdir(&vol, dst) != 0) {
+                fprintf(stderr, "[Erreur] Creation du dossier %c:%s impossible (code %lu).\n",
+                        drive_letter, dst, GetLastError());
+                rc = -1;
+            }
+            continue;
+        }
+
+        // Configuration GRUB : réécrite après la copie
+        if (is_relocated(plan, f)) continue;
+
+        if (f->size <= SMALL_FILE_SIZE) {
+            if (!batch_fits(&batch, f, vol.alloc_unit) &&
+                batch_flush(&batch, plan, iso, &vol, &done, total, progress_cb) != 0) {
+                rc = -1;
+                break;
+            }
+            if (batch_add(&batch, f, i, dst, vol.alloc_unit) != 0) {
+                rc = -1;
+                break;
+            }
+            continue;
+        }
+
+        if (copy_with_progress(&iso[f->image], f, &vol, dst, buffer, chunk,
+                               &done, total, progress_cb) != 0) {
+            if (cancel_requested()) {
+                printf("\n[Pleco] Copie annulee.\n");
+            } else {
+                fprintf(stderr, "[Erreur] Copie de %s echouee (code %lu).\n",
+                        f->rel_path, GetLastError());
+            }
+            rc = -1;
+        }
+    }
+
+    if (rc == 0) rc = batch_flush(&batch, plan, iso, &vol, &done, total, progress_cb);
+    if (rc == 0 && plan->image_count > 1) {
+        rc = write_boot_configs(plan, iso, &vol, &done, total, progress_cb);
+    }
+
+    for (int i = 0; i < opened; i++) io_close(&iso[i]);
+    batch_free(&batch);
+    io_free(buffer);
+    if (storage_close(&vol) != 0) rc = -1;
+    if (rc != 0) return -1;
+
+    if (progress_cb) progress_cb(total, total);
+    printf("\n[Pleco] %llu Mo ecrits, %d doublon(s) lus depuis le magasin.\n",
+           done / (1024ULL * 1024ULL), plan->duplicate_count);
+    return 0;
+}
+
+void staging_free(staging_plan_t* plan) {
+    free(plan->files);
+    plan->files         = NULL;
+    plan->file_count    = 0;
+    plan->file_capacity = 0;
+}
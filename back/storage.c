@@ -0,0 +1,119 @@
+// storage.c
+#include "header/storage.h"
+#include "header/io_policy.h"
+#include "header/io_tuner.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define WRITE_BLOCK      (1024 * 1024)      // sans profil du périphérique
+#define BATCH_MIN        (1024 * 1024)
+#define BATCH_MAX        (32 * 1024 * 1024)
+#define BATCH_LATENCIES  16     // un lot dure ~16 latences : surcoût fixe ~6 %
+
+// ── Mesure du support ─────────────────────────────────────────────────────
+// Profil d'écriture du périphérique (io_tuner.h), mesuré à sa première
+// rencontre puis relu ; réglages par défaut si la mesure est impossible.
+// Le lot de petits fichiers est dimensionné pour que la latence fixe
+// d'une écriture reste faible devant son temps de transfert.
+
+static void calibrate(storage_volume_t* vol) {
+    vol->batch_bytes = BATCH_MIN;
+    vol->write_block = WRITE_BLOCK;
+
+    // Le périphérique est celui qui porte l'image, ou le disque système
+    // pour la partition temporaire (mesuré via C:)
+    char dir[MAX_PATH];
+    if (vol->fat.disk->physical) {
+#ifdef _WIN32
+        if (!GetSystemWindowsDirectoryA(dir, sizeof(dir))) return;
+        dir[3] = '\0';
+#else
+        return;
+#endif
+    } else {
+        snprintf(dir, sizeof(dir), "%s", vol->fat.disk->name);
+        char* sep = strrchr(dir, '\\');
+        if (!sep) sep = strrchr(dir, '/');
+        if (sep) *sep = '\0';
+        else     snprintf(dir, sizeof(dir), ".");
+    }
+
+    io_profile_t profile;
+    if (io_tune_target(dir, &profile) != 0) return;
+    vol->write_block = profile.block;
+
+    double batch = profile.latency * profile.bandwidth * BATCH_LATENCIES;
+    if (batch > BATCH_MAX) batch = BATCH_MAX;
+    if (batch < BATCH_MIN) batch = BATCH_MIN;
+    vol->batch_bytes = (unsigned int)batch & ~0xFFFFu;
+
+    printf("[Info] Volume %c: ecritures de %u Ko, lots de %u Ko.\n",
+           vol->drive_letter, vol->write_block / 1024, vol->batch_bytes / 1024);
+}
+
+// ── Volume ────────────────────────────────────────────────────────────────
+
+int storage_open_disk(storage_volume_t* vol, gpt_disk_t* disk, unsigned long long offset,
+                      char drive_letter) {
+    memset(vol, 0, sizeof(*vol));
+    vol->drive_letter = drive_letter;
+    if (fat32_open(&vol->fat, disk, offset) != 0) return -1;
+    vol->alloc_unit = vol->fat.bytes_per_cluster;
+    calibrate(vol);
+    return 0;
+}
+
+int storage_close(storage_volume_t* vol) {
+    return fat32_close(&vol->fat);
+}
+
+int storage_mkdir(storage_volume_t* vol, const char* path) {
+    return fat32_mkdir(&vol->fat, path);
+}
+
+// ── Fichiers ──────────────────────────────────────────────────────────────
+
+int storage_create(storage_volume_t* vol, const char* path, unsigned long long size,
+                   storage_file_t* file) {
+    memset(file, 0, sizeof(*file));
+    return fat32_create(&vol->fat, path, size, &file->fat);
+}
+
+// Vidage périodique : le volume garde au plus IO_FLUSH_BYTES en attente
+static int flush_if_due(storage_volume_t* vol, unsigned long long len) {
+    if (!io_flush_due(&vol->pending, len)) return 0;
+    if (gpt_flush(vol->fat.disk) != 0) return -1;
+    io_drop_cache(vol->fat.disk->handle, 0, 0);
+    return 0;
+}
+
+int storage_write(storage_volume_t* vol, storage_file_t* file, const void* data,
+                  unsigned int len) {
+    if (fat32_write(&vol->fat, &file->fat, data, len) != 0) return -1;
+    return flush_if_due(vol, len);
+}
+
+int storage_close_file(storage_volume_t* vol, storage_file_t* file) {
+    return fat32_close_file(&vol->fat, &file->fat);
+}
+
+int storage_write_batch(storage_volume_t* vol, const storage_item_t* items, int count) {
+    int rc = fat32_write_batch(&vol->fat, items, count);
+    if (rc == 0) {
+        unsigned long long bytes = 0;
+        for (int i = 0; i < count; i++) bytes += items[i].size;
+        return flush_if_due(vol, bytes);
+    }
+    if (rc != 1) return rc;
+
+    // Pas de plage contiguë assez grande : fichier par fichier
+    for (int i = 0; i < count; i++) {
+        storage_file_t file;
+        if (storage_create(vol, items[i].path, items[i].size, &file) != 0) return -1;
+        int rc = items[i].size ? storage_write(vol, &file, items[i].data,
+                                               (unsigned int)items[i].size) : 0;
+        if (storage_close_file(vol, &file) != 0 || rc != 0) return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,178 @@
+# e2e.py
+# Test de bout en bout du pipeline hors Windows, sur disque virtuel :
+# compile pleco, fabrique des ISO (Rock Ridge avec noms longs et arbre
+# profond, Joliet seul, fichiers multi-extent), les copie avec
+# pleco --image puis relit la GPT et les FAT32 de l'image obtenue.
+#
+#   python3 back/tests/e2e.py [pleco]
+#
+# Sans argument, pleco est compilé depuis back/ avec gcc. Code de sortie
+# non nul au premier écart.
+import hashlib
+import os
+import subprocess
+import sys
+import tempfile
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from imgcheck import CheckError, Disk, ensure, fat32_tree, is_fat32, partitions  # noqa: E402
+from mkiso import Node, build                                                    # noqa: E402
+
+BACK = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+# Assez pour l'ESP, un "Windows" minimal et la partition d'une petite image
+DISK_MB   = 1024
+SYSTEM_MB = 64
+
+KERNEL = b'KERNEL' * 100000
+EXTRA  = b'EXTRA' * 1000
+GRUB_CFG = (b'menuentry "Live" {\n'
+            b'\tlinux\t/casper/vmlinuz boot=casper quiet splash ---\n'
+            b'\tinitrd\t"/casper/initrd" /casper/extra.img\n'
+            b'}\n')
+
+
+def distro(flavour, rock_ridge):
+    """Arborescence d'une distribution live ; noyau et extra.img communs."""
+    grub = Node('grub', kids=[Node('grub.cfg', GRUB_CFG)])
+    grub.kids += [Node('module_%03d.mod' % i, bytes([i % 256]) * (100 + 7 * i))
+                  for i in range(300)]
+    root = Node('', kids=[
+        Node('EFI', kids=[Node('BOOT', kids=[
+            Node('BOOTx64.EFI', b'shim' * 1000),
+            Node('grubx64.efi', b'grub' * 3000)])]),
+        Node('boot', kids=[grub]),
+        Node('casper', kids=[
+            Node('vmlinuz', KERNEL),
+            Node('initrd', (b'INITRD' + flavour) * 50000),
+            Node('extra.img', EXTRA),
+            Node('filesystem.squashfs', bytes(range(256)) * 1200 + flavour * 7)]),
+        Node('README.txt', b'live ' + flavour),
+        Node('empty.txt', b''),
+    ])
+    if rock_ridge:
+        # Nom poursuivi en zone CE, répertoires déplacés au-delà de 8 niveaux
+        root.kids.append(Node('notes_' + 'n' * 150 + '.txt', b'long name'))
+        d = root
+        for i in range(12):
+            sub = Node('level%02d' % i, kids=[Node('f%02d.txt' % i, bytes([i]) * (3000 + i))])
+            d.kids.append(sub)
+            d = sub
+    return root
+
+
+def expected(node, rock_ridge):
+    tree = {k.name: expected(k, False) if k.is_dir else k.data for k in node.kids}
+    if rock_ridge:
+        tree['rr_moved'] = {}   # vide : son contenu est listé à sa place d'origine
+    return tree
+
+
+def compare(got, want, path=''):
+    ensure(set(got) == set(want), '%s : %s' % (path or '/', sorted(set(got) ^ set(want))))
+    for name, value in want.items():
+        if isinstance(value, dict):
+            compare(got[name], value, path + '/' + name)
+        else:
+            ensure(got[name] == value, '%s/%s : contenu different' % (path, name))
+
+
+def run(pleco, *args):
+    proc = subprocess.run([pleco] + list(args), stdout=subprocess.PIPE,
+                          stderr=subprocess.STDOUT)
+    ensure(proc.returncode == 0, 'pleco %s : code %d\n%s' % (
+        ' '.join(args), proc.returncode, proc.stdout.decode(errors='replace')[-2000:]))
+
+
+def staged_volume(image):
+    """Vérifie tout le disque, retourne l'arborescence de PLECO_TEMP."""
+    disk = Disk(image)
+    try:
+        staged = None
+        for name, (first, _) in partitions(disk).items():
+            if not is_fat32(disk, first):
+                continue
+            tree = fat32_tree(disk, first)
+            if 'PLECO' in name:
+                staged = tree
+        ensure(staged is not None, 'partition PLECO_TEMP absente')
+        return staged
+    finally:
+        disk.close()
+
+
+def check_single(pleco, work, iso, tree):
+    image = os.path.join(work, 'single.img')
+    run(pleco, 'mkimage', image, str(DISK_MB), str(SYSTEM_MB))
+    run(pleco, '--image', image, iso, sha256(iso), 'dualboot')
+    compare(staged_volume(image), expected(tree, True))
+    print('[OK] Image seule copiee a la racine')
+
+
+def check_multi(pleco, work, isos, trees):
+    image = os.path.join(work, 'multi.img')
+    run(pleco, 'mkimage', image, str(DISK_MB), str(SYSTEM_MB))
+    args = []
+    for iso in isos:
+        args += [iso, sha256(iso)]
+    run(pleco, '--image', image, 'multi', 'dualboot', *args)
+
+    staged = staged_volume(image)['pleco']
+    # Noyau et extra.img communs : une seule copie, dans le magasin
+    ensure(sorted(staged['cas'].values()) == sorted([EXTRA, KERNEL]), 'magasin CAS')
+    for i, (tree, rock_ridge) in enumerate(trees):
+        got, n = staged[str(i + 1)], i + 1
+        cfg   = got['boot']['grub'].pop('grub.cfg').decode()
+        entry = got['EFI']['BOOT'].pop('grub.cfg').decode()
+        ensure(cfg.startswith('# Pleco') and entry.startswith('# Pleco'), 'configs non reecrites')
+        ensure('/pleco/cas/' in cfg and '/pleco/%d/casper/initrd' % n in cfg,
+               'chemins du noyau et des initrd')
+        ensure('live-media-path=/pleco/%d/casper ---' % n in cfg, 'live-media-path')
+
+        want = expected(tree, rock_ridge)
+        del want['boot']['grub']['grub.cfg']
+        del want['casper']['vmlinuz']
+        del want['casper']['extra.img']
+        compare(got, want, '/pleco/%d' % n)
+        print('[OK] Image %d copiee dans /pleco/%d' % (n, n))
+
+
+def sha256(path):
+    h = hashlib.sha256()
+    with open(path, 'rb') as f:
+        for block in iter(lambda: f.read(1 << 20), b''):
+            h.update(block)
+    return h.hexdigest()
+
+
+def compile_pleco(work):
+    out = os.path.join(work, 'pleco')
+    sources = sorted(os.path.join(BACK, f) for f in os.listdir(BACK) if f.endswith('.c'))
+    subprocess.run(['gcc', '-O2', '-Wall', '-Wextra', '-o', out] + sources + ['-lpthread'],
+                   check=True)
+    return out
+
+
+def main():
+    with tempfile.TemporaryDirectory(prefix='pleco-e2e-') as work:
+        # Caches (empreintes, profils d'E/S) propres au test
+        os.environ['XDG_CACHE_HOME'] = os.path.join(work, 'cache')
+        pleco = os.path.abspath(sys.argv[1]) if len(sys.argv) > 1 else compile_pleco(work)
+
+        rr_tree, jol_tree = distro(b'A', True), distro(b'B', False)
+        rr_iso, jol_iso = os.path.join(work, 'rr.iso'), os.path.join(work, 'joliet.iso')
+        build(rr_iso, rr_tree, rock_ridge=True, joliet=True, max_extent=65536)
+        build(jol_iso, jol_tree, rock_ridge=False, joliet=True)
+
+        try:
+            check_single(pleco, work, rr_iso, rr_tree)
+            check_multi(pleco, work, [rr_iso, jol_iso], [(rr_tree, True), (jol_tree, False)])
+        except CheckError as e:
+            print('[Erreur] %s' % e)
+            return 1
+    print('[OK] Pipeline de bout en bout')
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,147 @@
+# imgcheck.py
+# Lecture et contrôle d'un disque virtuel produit par pleco --image :
+# les deux copies de la table GPT, puis chaque FAT32 (copies de la FAT
+# identiques, compteur FSInfo exact, aucune chaîne partagée ou perdue).
+import struct
+import zlib
+
+SECTOR = 512
+
+
+class CheckError(Exception):
+    pass
+
+
+def ensure(cond, message):
+    if not cond:
+        raise CheckError(message)
+
+
+class Disk:
+    def __init__(self, path):
+        self.file = open(path, 'rb')
+        self.size = self.file.seek(0, 2)
+
+    def read(self, offset, length):
+        self.file.seek(offset)
+        return self.file.read(length)
+
+    def close(self):
+        self.file.close()
+
+
+# ── GPT ──────────────────────────────────────────────────────────────────
+
+def gpt_header(disk, lba):
+    h = disk.read(lba * SECTOR, 92)
+    ensure(h[:8] == b'EFI PART', 'en-tete GPT absent (LBA %d)' % lba)
+    crc = struct.unpack_from('<I', h, 16)[0]
+    ensure(zlib.crc32(h[:16] + b'\0' * 4 + h[20:]) == crc, 'CRC en-tete GPT (LBA %d)' % lba)
+    current, backup = struct.unpack_from('<QQ', h, 24)
+    entries_lba, count, entry_size, entries_crc = struct.unpack_from('<QIII', h, 72)
+    entries = disk.read(entries_lba * SECTOR, count * entry_size)
+    ensure(zlib.crc32(entries) == entries_crc, 'CRC entrees GPT (LBA %d)' % lba)
+    ensure(current == lba, 'LBA courant GPT (LBA %d)' % lba)
+    return entries, backup, entry_size
+
+
+def partitions(disk):
+    """Partitions {nom: (premier LBA, dernier LBA)}, les deux GPT vérifiées."""
+    last = disk.size // SECTOR - 1
+    entries, backup, entry_size = gpt_header(disk, 1)
+    ensure(backup == last, 'GPT de secours mal placee')
+    ensure(gpt_header(disk, backup)[0] == entries, 'GPT primaire et de secours differentes')
+    ensure(disk.read(510, 2) == b'\x55\xaa' and disk.read(450, 1) == b'\xee', 'MBR protecteur')
+
+    parts = {}
+    for i in range(len(entries) // entry_size):
+        e = entries[i * entry_size:(i + 1) * entry_size]
+        if e[:16] == b'\0' * 16:
+            continue
+        first, end = struct.unpack_from('<QQ', e, 32)
+        parts[e[56:128].decode('utf-16-le').rstrip('\0')] = (first, end)
+    spans = sorted(parts.values())
+    for a, b in zip(spans, spans[1:]):
+        ensure(a[1] < b[0], 'partitions superposees')
+    return parts
+
+
+# ── FAT32 ────────────────────────────────────────────────────────────────
+
+def is_fat32(disk, first_lba):
+    return disk.read(first_lba * SECTOR + 82, 5) == b'FAT32'
+
+
+def fat32_tree(disk, first_lba):
+    """Arborescence {nom: dict | bytes} d'un volume FAT32, après contrôle."""
+    base = first_lba * SECTOR
+    boot = disk.read(base, SECTOR)
+    per_cluster = boot[13]
+    reserved    = struct.unpack_from('<H', boot, 14)[0]
+    fat_count   = boot[16]
+    total       = struct.unpack_from('<I', boot, 32)[0]
+    fat_sectors = struct.unpack_from('<I', boot, 36)[0]
+    root        = struct.unpack_from('<I', boot, 44)[0]
+    data_start  = reserved + fat_count * fat_sectors
+    clusters    = (total - data_start) // per_cluster
+
+    fats = [disk.read(base + (reserved + i * fat_sectors) * SECTOR, fat_sectors * SECTOR)
+            for i in range(fat_count)]
+    ensure(all(f == fats[0] for f in fats), 'copies de la FAT differentes')
+    fat = struct.unpack_from('<%dI' % (fat_sectors * SECTOR // 4), fats[0])
+
+    free = sum(1 for c in range(2, clusters + 2) if fat[c] & 0x0FFFFFFF == 0)
+    fsinfo = disk.read(base + SECTOR, SECTOR)
+    ensure(struct.unpack_from('<I', fsinfo, 488)[0] == free, 'compteur FSInfo faux')
+
+    used = set()
+
+    def chain(c):
+        out = []
+        while 2 <= c < 0x0FFFFFF8:
+            ensure(c not in used, 'cluster %d utilise deux fois' % c)
+            used.add(c)
+            out.append(c)
+            c = fat[c] & 0x0FFFFFFF
+        return out
+
+    def data(c):
+        size = per_cluster * SECTOR
+        return b''.join(disk.read(base + (data_start + (x - 2) * per_cluster) * SECTOR, size)
+                        for x in chain(c))
+
+    def directory(c):
+        raw, out, lfn = data(c), {}, {}
+        for i in range(0, len(raw), 32):
+            e = raw[i:i + 32]
+            if e[0] == 0:
+                break
+            if e[0] == 0xE5:
+                lfn = {}
+                continue
+            if e[11] == 0x0F:
+                lfn[e[0] & 0x1F] = (e[1:11] + e[14:26] + e[28:32]).decode('utf-16-le')
+                continue
+            if e[11] & 0x08:
+                lfn = {}
+                continue
+            short = e[:8].decode().rstrip()
+            if e[8] != 0x20:
+                short += '.' + e[8:11].decode().rstrip()
+            name = ''.join(lfn[k] for k in sorted(lfn)).split('\0')[0] if lfn else short
+            lfn = {}
+            if short in ('.', '..'):
+                continue
+            first = struct.unpack_from('<H', e, 20)[0] << 16 | struct.unpack_from('<H', e, 26)[0]
+            out[name] = (e[11], first, struct.unpack_from('<I', e, 28)[0])
+        return out
+
+    def walk(c):
+        tree = {}
+        for name, (attr, first, size) in directory(c).items():
+            tree[name] = walk(first) if attr & 0x10 else data(first)[:size]
+        return tree
+
+    tree = walk(root)
+    ensure(len(used) + free == clusters, 'clusters perdus : %d' % (clusters - free - len(used)))
+    return tree
@@ -0,0 +1,228 @@
+# mkiso.py
+# Générateur d'images ISO 9660 pour les tests de bout en bout : noms
+# Rock Ridge (NM, zone de continuation CE pour les noms longs, RE/CL pour
+# les répertoires au-delà de 8 niveaux), Joliet en option, fichiers
+# découpés en plusieurs extents.
+import struct
+
+SECTOR    = 2048
+RR_DEPTH  = 8      # profondeur ISO 9660 maximale, au-delà : rr_moved
+NM_INLINE = 100    # un nom plus long continue dans une zone CE
+DATE      = bytes([124, 1, 1, 0, 0, 0, 0])
+
+
+def both32(v):
+    return struct.pack('<I', v) + struct.pack('>I', v)
+
+
+def both16(v):
+    return struct.pack('<H', v) + struct.pack('>H', v)
+
+
+class Node:
+    """Fichier (data = contenu) ou répertoire (data = None)."""
+
+    def __init__(self, name, data=None, kids=None):
+        self.name  = name
+        self.data  = data
+        self.kids  = kids or []
+        self.moved = False      # déplacé sous rr_moved (PVD seulement)
+        self.hidden = False     # rr_moved : absent de l'arbre Joliet
+        self.ce    = 0          # secteur de la zone de continuation du nom
+        self.ext   = {}         # extent et taille par arbre ('pvd', 'jol')
+
+    @property
+    def is_dir(self):
+        return self.data is None
+
+
+def record(extent, size, flags, name, su=b''):
+    pad  = b'\0' if len(name) % 2 == 0 else b''
+    body = (both32(extent) + both32(size) + DATE + bytes([flags, 0, 0]) +
+            both16(1) + bytes([len(name)]) + name + pad + su)
+    if len(body) % 2:
+        body += b'\0'
+    assert len(body) + 2 <= 255, name
+    return bytes([len(body) + 2, 0]) + body
+
+
+def susp(sig, data):
+    return sig + bytes([4 + len(data), 1]) + data
+
+
+def nm_entries(node):
+    """Entrées NM de l'enregistrement et de sa zone de continuation."""
+    name = node.name.encode()
+    if len(name) <= NM_INLINE:
+        return susp(b'NM', b'\0' + name), b''
+    rest = susp(b'NM', b'\0' + name[NM_INLINE:])
+    head = (susp(b'NM', b'\1' + name[:NM_INLINE]) +
+            susp(b'CE', both32(node.ce) + both32(0) + both32(len(rest))))
+    return head, rest
+
+
+def relocate(root):
+    """Déplace sous /rr_moved les répertoires plus profonds que RR_DEPTH."""
+    moved = Node('rr_moved')
+    moved.hidden = True
+
+    def walk(d, depth):
+        for k in d.kids:
+            if not k.is_dir:
+                continue
+            if depth + 1 > RR_DEPTH:
+                k.moved = True
+                moved.kids.append(k)
+                walk(k, 3)
+            else:
+                walk(k, depth + 1)
+    walk(root, 1)
+    if moved.kids:
+        root.kids.append(moved)
+    return moved
+
+
+def build(path, tree, rock_ridge=True, joliet=True, max_extent=None, label='TEST_LABEL'):
+    max_extent = max_extent or 0xFFFFF800
+    rr_moved   = relocate(tree) if rock_ridge else None
+
+    # Enfants tels que les voit chaque arbre : dans le PVD, un répertoire
+    # déplacé n'est sous son parent d'origine qu'un fichier vide avec CL
+    def kids(d, tree_name):
+        if tree_name == 'jol':
+            return [k for k in d.kids if not k.hidden]
+        return d.kids
+
+    def subdirs(d, tree_name):
+        return [k for k in kids(d, tree_name)
+                if k.is_dir and (tree_name == 'jol' or not k.moved or d is rr_moved)]
+
+    def collect(tree_name):
+        dirs, parents = [], {id(tree): tree}
+
+        def walk(d):
+            dirs.append(d)
+            for k in subdirs(d, tree_name):
+                parents[id(k)] = d
+                walk(k)
+        walk(tree)
+        return dirs, parents
+
+    def dir_records(d, tree_name, parent):
+        pvd     = tree_name == 'pvd'
+        dot_su  = susp(b'SP', b'\xbe\xef\0') if pvd and rock_ridge and d is tree else b''
+        out     = [record(*d.ext.get(tree_name, (0, 0)), 2, b'\0', dot_su),
+                   record(*parent.ext.get(tree_name, (0, 0)), 2, b'\1')]
+        cont    = []
+        for i, k in enumerate(kids(d, tree_name)):
+            if not pvd:
+                name = k.name[:64].encode('utf-16-be')    # limite Joliet
+            else:
+                name = b'D%06d' % i if k.is_dir else b'F%06d.BIN;1' % i
+            su = b''
+            if pvd and rock_ridge:
+                su, rest = nm_entries(k)
+                if rest:
+                    cont.append((k, rest))
+            if k.is_dir:
+                extent, size = k.ext.get(tree_name, (0, 0))
+                if pvd and k.moved and d is not rr_moved:
+                    out.append(record(0, 0, 0, name, su + susp(b'CL', both32(extent))))
+                else:
+                    if pvd and k.moved:
+                        su += susp(b'RE', b'')
+                    out.append(record(extent, size, 2, name, su))
+                continue
+            size, extent, off = len(k.data), k.ext.get('data', 0), 0
+            if size == 0:
+                out.append(record(extent, 0, 0, name, su))
+            while off < size:
+                part = min(max_extent, size - off)
+                last = off + part >= size
+                out.append(record(extent, part, 0 if last else 0x80, name, su))
+                extent += part // SECTOR
+                off    += part
+        return out, cont
+
+    def pack(records):
+        out = b''
+        for r in records:
+            # Un enregistrement ne chevauche jamais deux secteurs
+            if len(out) // SECTOR != (len(out) + len(r) - 1) // SECTOR:
+                out += b'\0' * (SECTOR - len(out) % SECTOR)
+            out += r
+        return out + b'\0' * (-len(out) % SECTOR)
+
+    trees = ['pvd'] + (['jol'] if joliet else [])
+    dirs  = {t: collect(t) for t in trees}
+
+    # Les tailles ne dépendent pas des extents : on les calcule d'abord
+    for t in trees:
+        for d in dirs[t][0]:
+            d.ext[t] = (0, len(pack(dir_records(d, t, dirs[t][1][id(d)])[0])))
+
+    lba = 20
+    for t in trees:
+        for d in dirs[t][0]:
+            d.ext[t] = (lba, d.ext[t][1])
+            lba += d.ext[t][1] // SECTOR
+
+    long_names = []
+    for d in dirs['pvd'][0]:
+        long_names += [k for k, _ in dir_records(d, 'pvd', dirs['pvd'][1][id(d)])[1]]
+    for k in {id(k): k for k in long_names}.values():
+        k.ce = lba
+        lba += 1
+
+    files = []
+
+    def collect_files(d):
+        for k in kids(d, 'jol'):
+            if k.is_dir:
+                collect_files(k)
+            else:
+                files.append(k)
+    collect_files(tree)
+    for f in files:
+        f.ext['data'] = lba
+        lba += (len(f.data) + SECTOR - 1) // SECTOR
+
+    img = bytearray(lba * SECTOR)
+
+    def put(sector, data):
+        img[sector * SECTOR:sector * SECTOR + len(data)] = data
+
+    def volume_descriptor(kind, tree_name):
+        v = bytearray(SECTOR)
+        v[0], v[1:6], v[6] = kind, b'CD001', 1
+        v[40:72]   = label.ljust(32).encode()[:32]
+        v[80:88]   = both32(lba)
+        v[120:124] = both16(1)
+        v[124:128] = both16(1)
+        v[128:132] = both16(SECTOR)
+        if tree_name == 'jol':
+            v[88:91] = b'%/E'
+        root = record(*tree.ext[tree_name], 2, b'\0')
+        v[156:156 + len(root)] = root
+        return v
+
+    put(16, volume_descriptor(1, 'pvd'))
+    sector = 17
+    if joliet:
+        put(sector, volume_descriptor(2, 'jol'))
+        sector += 1
+    put(sector, bytes([255]) + b'CD001' + bytes([1]))
+
+    for t in trees:
+        for d in dirs[t][0]:
+            records, cont = dir_records(d, t, dirs[t][1][id(d)])
+            put(d.ext[t][0], pack(records))
+            for k, rest in cont:
+                put(k.ce, rest)
+    for f in files:
+        put(f.ext['data'], f.data)
+
+    if rr_moved is not None and rr_moved.kids:
+        tree.kids.remove(rr_moved)
+    with open(path, 'wb') as out:
+        out.write(img)
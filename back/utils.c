@@ -3,6 +3,30 @@
 #include <stdio.h>
 #include <string.h>
 
+static volatile LONG cancel_flag = 0;
+
+void set_cancel_requested(int value) {
+    InterlockedExchange(&cancel_flag, value ? 1 : 0);
+}
+
+int cancel_requested(void) {
+    return cancel_flag != 0;
+}
+
+int copy_string(char* dst, size_t size, const char* src) {
+    if (size == 0) return -1;
+    size_t len = strlen(src);
+    if (len >= size) {
+        memcpy(dst, src, size - 1);
+        dst[size - 1] = '\0';
+        return -1;
+    }
+    memcpy(dst, src, len + 1);
+    return 0;
+}
+
+#ifdef _WIN32
+
 int run_process_with_input(
     const char* executable,
     const char* input_text,
@@ -80,11 +104,23 @@ int run_process_with_input(
     CloseHandle(pi.hProcess);
     CloseHandle(pi.hThread);
 
-    // robocopy retourne 1 quand des fichiers ont été copiés — ce n'est pas une erreur
-    if (exit_code == 1 &&
-        (strstr(executable, "robocopy") || strstr(executable, "ROBOCOPY"))) {
-        return 0;
-    }
-
     return (exit_code == 0) ? 0 : -1;
 }
+
+#else
+
+// bcdedit n'existe que sous Windows : hors Windows,
+// le disque virtuel (vdisk.h, bcd_image.h) le remplace.
+int run_process_with_input(
+    const char* executable,
+    const char* input_text,
+    char* output_buffer,
+    DWORD output_buffer_size
+) {
+    (void)input_text;
+    if (output_buffer && output_buffer_size > 0) output_buffer[0] = '\0';
+    fprintf(stderr, "[Erreur] %s indisponible hors Windows.\n", executable);
+    return -1;
+}
+
+#endif
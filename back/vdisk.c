@@ -0,0 +1,218 @@
+// vdisk.c
+#include "header/vdisk.h"
+#include "header/gpt.h"
+#include "header/fat32.h"
+#include "header/compat.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MB_SECTORS        (1024ULL * 1024ULL / VDISK_SECTOR_SIZE)
+#define ESP_SIZE_MB       100
+
+static struct {
+    int        open;
+    gpt_disk_t dev;
+} disk;
+
+// ── Accès à l'image ───────────────────────────────────────────────────────
+
+int vdisk_read(unsigned long long offset, void* buffer, unsigned int size) {
+    return disk.open ? gpt_read(&disk.dev, offset, buffer, size) : -1;
+}
+
+int vdisk_write(unsigned long long offset, const void* buffer, unsigned int size) {
+    return disk.open ? gpt_write(&disk.dev, offset, buffer, size) : -1;
+}
+
+int vdisk_flush(void) {
+    return disk.open ? gpt_flush(&disk.dev) : -1;
+}
+
+gpt_disk_t* vdisk_device(void) {
+    return disk.open ? &disk.dev : NULL;
+}
+
+// Lettre notée dans le nom : "... (P:)", 0 si aucune
+static char entry_letter(const gpt_entry_t* e) {
+    char name[37];
+    gpt_entry_name(e, name, sizeof(name));
+    size_t n = strlen(name);
+    if (n >= 4 && name[n - 4] == '(' && name[n - 2] == ':' && name[n - 1] == ')') {
+        return name[n - 3];
+    }
+    return 0;
+}
+
+// Index de l'entrée portant la lettre, -1 si aucune
+static int find_letter(const gpt_table_t* table, char drive_letter) {
+    for (int i = 0; i < GPT_ENTRY_COUNT; i++) {
+        if (gpt_entry_used(&table->entries[i]) &&
+            entry_letter(&table->entries[i]) == drive_letter) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// ── Création / ouverture ──────────────────────────────────────────────────
+
+int vdisk_create(const char* image_path, unsigned int size_mb, unsigned int system_mb) {
+    unsigned long long sectors = (unsigned long long)size_mb * MB_SECTORS;
+    unsigned long long needed  = (2 + ESP_SIZE_MB + (unsigned long long)system_mb) * MB_SECTORS;
+    if (disk.open) {
+        fprintf(stderr, "[Erreur] Un disque virtuel est deja ouvert.\n");
+        return -1;
+    }
+    if (sectors < needed) {
+        fprintf(stderr, "[Erreur] Image trop petite : %u Mo pour %llu Mo requis.\n",
+                size_mb, needed / MB_SECTORS);
+        return -1;
+    }
+    if (gpt_open_image(&disk.dev, image_path, 1, sectors * VDISK_SECTOR_SIZE) != 0) return -1;
+    disk.open = 1;
+
+    gpt_table_t* table = malloc(sizeof(gpt_table_t));
+    int          rc    = table && gpt_init(table, &disk.dev) == 0 ? 0 : -1;
+
+    unsigned long long esp_first = GPT_ALIGN_BYTES / VDISK_SECTOR_SIZE;
+    unsigned long long esp_size  = ESP_SIZE_MB * MB_SECTORS;
+    if (rc == 0) {
+        gpt_add(table, GPT_TYPE_ESP, esp_first, esp_size, "EFI system partition");
+        gpt_add(table, GPT_TYPE_BASIC_DATA, esp_first + esp_size,
+                (unsigned long long)system_mb * MB_SECTORS, "Windows (C:)");
+        rc = gpt_store(table);
+    }
+    if (rc == 0) {
+        rc = fat32_format(&disk.dev, esp_first * VDISK_SECTOR_SIZE,
+                          esp_size * VDISK_SECTOR_SIZE, "SYSTEM", (unsigned int)esp_first);
+    }
+    free(table);
+    vdisk_close();
+
+    if (rc == 0) {
+        printf("[Pleco] Disque virtuel cree : %s (%u Mo, Windows %u Mo).\n",
+               image_path, size_mb, system_mb);
+    }
+    return rc;
+}
+
+int vdisk_open(const char* image_path) {
+    if (disk.open) vdisk_close();
+    if (gpt_open_image(&disk.dev, image_path, 0, 0) != 0) return -1;
+    disk.open = 1;
+
+    gpt_table_t* table = malloc(sizeof(gpt_table_t));
+    if (!table || gpt_load(table, &disk.dev) != 0 ||
+        (table->damaged && gpt_store(table) != 0)) {
+        free(table);
+        vdisk_close();
+        return -1;
+    }
+    free(table);
+    return 0;
+}
+
+void vdisk_close(void) {
+    if (!disk.open) return;
+    gpt_close(&disk.dev);
+    disk.open = 0;
+}
+
+int vdisk_is_open(void) {
+    return disk.open;
+}
+
+const char* vdisk_path(void) {
+    return disk.dev.name;
+}
+
+// ── Partitions ────────────────────────────────────────────────────────────
+
+int vdisk_create_partition(unsigned int size_mb, char drive_letter) {
+    gpt_table_t* table = malloc(sizeof(gpt_table_t));
+    if (!table || gpt_load(table, &disk.dev) != 0) {
+        free(table);
+        return -1;
+    }
+
+    if (find_letter(table, drive_letter) >= 0) {
+        fprintf(stderr, "[Erreur] La lettre %c: est deja attribuee sur le disque virtuel.\n",
+                drive_letter);
+        free(table);
+        return -1;
+    }
+
+    unsigned long long sectors = (unsigned long long)size_mb * MB_SECTORS;
+    unsigned long long first   = gpt_find_free(table, sectors, NULL);
+    if (!first) {
+        fprintf(stderr, "[Erreur] Pas d'espace libre de %u Mo sur le disque virtuel.\n", size_mb);
+        free(table);
+        return -1;
+    }
+
+    char name[36];
+    snprintf(name, sizeof(name), "PLECO_TEMP (%c:)", drive_letter);
+    int rc = gpt_add(table, GPT_TYPE_ESP, first, sectors, name) < 0 ? -1 : 0;
+    if (rc == 0) rc = gpt_store(table);
+    free(table);
+    if (rc != 0) return -1;
+
+    if (fat32_format(&disk.dev, first * VDISK_SECTOR_SIZE, sectors * VDISK_SECTOR_SIZE,
+                     "PLECO_TEMP", (unsigned int)first) != 0) {
+        vdisk_delete_partition(drive_letter);
+        return -1;
+    }
+
+    printf("[Pleco] Partition %c: creee sur le disque virtuel (LBA %llu, %u Mo).\n",
+           drive_letter, first, size_mb);
+    return 0;
+}
+
+int vdisk_delete_partition(char drive_letter) {
+    gpt_table_t* table = malloc(sizeof(gpt_table_t));
+    if (!table || gpt_load(table, &disk.dev) != 0) {
+        free(table);
+        return -1;
+    }
+
+    int found = 0, i;
+    while ((i = find_letter(table, drive_letter)) >= 0) {
+        gpt_remove(table, i);
+        found = 1;
+    }
+    int rc = found ? gpt_store(table) : -1;
+    free(table);
+
+    if (rc == 0) {
+        printf("[Pleco] Partition %c: supprimee.\n", drive_letter);
+    } else {
+        fprintf(stderr, "[Attention] Impossible de supprimer la partition %c:.\n", drive_letter);
+    }
+    return rc;
+}
+
+unsigned long long vdisk_free_space_mb(void) {
+    unsigned long long largest = 0;
+    gpt_table_t*       table   = malloc(sizeof(gpt_table_t));
+    if (table && gpt_load(table, &disk.dev) == 0) gpt_find_free(table, ~0ULL, &largest);
+    free(table);
+    return largest / MB_SECTORS;
+}
+
+int vdisk_find_partition(char drive_letter, unsigned long long* offset,
+                         unsigned long long* size) {
+    gpt_table_t* table = malloc(sizeof(gpt_table_t));
+    int          rc    = -1;
+    if (table && gpt_load(table, &disk.dev) == 0) {
+        int i = find_letter(table, drive_letter);
+        if (i >= 0) {
+            const gpt_entry_t* e = &table->entries[i];
+            *offset = e->first_lba * VDISK_SECTOR_SIZE;
+            *size   = (e->last_lba - e->first_lba + 1) * VDISK_SECTOR_SIZE;
+            rc = 0;
+        }
+    }
+    free(table);
+    return rc;
+}
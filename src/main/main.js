@@ -1,8 +1,92 @@
 const { app, BrowserWindow, ipcMain } = require('electron')
 const path = require('node:path')
+const { spawn } = require('node:child_process')
+const readline = require('node:readline')
 const request = require('request')
 const fs = require('fs')
 
+// Backend persistant : pleco.exe serve, JSON-RPC 2.0 une ligne par message.
+// Le processus reste lancé pour garder ses caches (empreintes, index ISO).
+// pleco.exe demande l'élévation : l'application doit tourner en administrateur.
+// Il est compilé depuis back/ par npm run build:back (lancé avant npm start).
+const backendPath = path.join(__dirname, '../../back/pleco.exe')
+let backend = null
+let nextId = 1
+const pending = new Map()
+
+// Manifeste requireAdministrator : lancé sans élévation, CreateProcess
+// échoue avec ERROR_ELEVATION_REQUIRED (EACCES côté Node)
+const needsElevation = (err) => err.code === 'EACCES' || err.errno === 740
+
+const startBackend = () => {
+  const proc = spawn(backendPath, ['serve'], {
+    stdio: ['pipe', 'pipe', 'pipe'],
+    windowsHide: true
+  })
+
+  readline.createInterface({ input: proc.stdout }).on('line', (line) => {
+    let msg
+    try {
+      msg = JSON.parse(line)
+    } catch {
+      return
+    }
+
+    if (msg.method === 'progress') {
+      BrowserWindow.getAllWindows().forEach((win) => {
+        win.webContents.send('pleco:progress', msg.params)
+      })
+      return
+    }
+
+    const call = pending.get(msg.id)
+    if (!call) return
+    pending.delete(msg.id)
+    if (msg.error) call.reject(new Error(msg.error.message))
+    else call.resolve(msg.result)
+  })
+
+  // Dernière ligne d'erreur du backend, reprise si le processus s'arrête
+  let lastError = ''
+  proc.stderr.on('data', (data) => {
+    process.stderr.write(data)
+    const lines = data.toString().split(/\r?\n/).filter((line) => line.trim())
+    if (lines.length) lastError = lines[lines.length - 1].trim()
+  })
+
+  const fail = (err) => {
+    pending.forEach((call) => call.reject(err))
+    pending.clear()
+    if (backend === proc) backend = null
+  }
+  // Échec du lancement : signalé par 'error', pas par l'écriture de la requête
+  proc.stdin.on('error', () => {})
+  proc.on('error', (err) => {
+    if (needsElevation(err)) {
+      fail(new Error('pleco.exe demande les droits administrateur : relancer Pleco en tant qu\'administrateur'))
+    } else if (err.code === 'ENOENT') {
+      fail(new Error(`pleco.exe introuvable (${backendPath}) : compiler avec npm run build:back`))
+    } else {
+      fail(err)
+    }
+  })
+  proc.on('exit', (code) => {
+    const detail = lastError ? ` : ${lastError}` : ''
+    fail(new Error(`pleco.exe termine (code ${code})${detail}`))
+  })
+
+  return proc
+}
+
+const callBackend = (method, params = {}) => {
+  if (!backend) backend = startBackend()
+  const id = nextId++
+  return new Promise((resolve, reject) => {
+    pending.set(id, { resolve, reject })
+    backend.stdin.write(JSON.stringify({ jsonrpc: '2.0', id, method, params }) + '\n')
+  })
+}
+
 const createWindow = () => {
   const win = new BrowserWindow({
     width: 1920,
@@ -36,5 +120,11 @@ app.whenReady().then(() => {
     })
   })
 
+  ipcMain.handle('pleco', (_event, method, params) => callBackend(method, params))
+
   createWindow()
 })
+
+app.on('will-quit', () => {
+  if (backend) backend.stdin.end()
+})
@@ -1,5 +1,9 @@
 const { contextBridge, ipcRenderer } = require('electron')
 
 contextBridge.exposeInMainWorld('api', {
-  download: (url, path) => ipcRenderer.invoke('download', url, path)
+  download: (url, path) => ipcRenderer.invoke('download', url, path),
+
+  // Appel au backend : inspect, verify, plan, stage, configure-boot, cancel...
+  pleco: (method, params) => ipcRenderer.invoke('pleco', method, params),
+  onProgress: (callback) => ipcRenderer.on('pleco:progress', (_event, progress) => callback(progress))
 })